@@ -0,0 +1,51 @@
+//
+// Converts TLMv2 telemetry files into the seekable columnar format
+//
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <telemetry/columnar.h>
+
+int main(int argc, char *argv[])
+{
+	if(argc != 3)
+	{
+		std::fprintf(stderr, "Usage: %s <input.tlm> <output.tlm>\n", argv[0]);
+		return 1;
+	}
+
+	std::ifstream input(argv[1], std::ios::binary);
+
+	if(!input)
+	{
+		std::fprintf(stderr, "Failed to open %s\n", argv[1]);
+		return 1;
+	}
+
+	const std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+	try
+	{
+		const std::vector<uint8_t> result = convert_telemetry_to_columnar(data.data(), data.size());
+
+		std::ofstream output(argv[2], std::ios::binary);
+		output.write(reinterpret_cast<const char *>(result.data()), std::streamsize(result.size()));
+
+		if(!output)
+		{
+			std::fprintf(stderr, "Failed to write %s\n", argv[2]);
+			return 1;
+		}
+
+		std::printf("Converted %zu bytes into %zu bytes\n", data.size(), result.size());
+	}
+	catch(std::exception &e)
+	{
+		std::fprintf(stderr, "Failed to convert %s. Error: %s\n", argv[1], e.what());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,740 @@
+//
+//  columnar.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <limits>
+#include <stdexcept>
+#include "columnar.h"
+#include "compression.h"
+#include "parser.h"
+#include "stream.h"
+
+static constexpr uint32_t columnar_magic = 0x434d4c54; // 'TLMC'
+static constexpr uint32_t columnar_header_length = 8;
+static constexpr uint32_t columnar_trailer_length = 12;
+static constexpr uint32_t columnar_chunk_entry_length = 59;
+
+// Every byte of a compressed block expands to at most 255 bytes, see decompress_telemetry_block()
+static bool is_plausible_block(uint32_t compressed_size, uint32_t size)
+{
+	return uint64_t(size) <= uint64_t(compressed_size) * 255;
+}
+
+static bool is_delta_encoded_type(telemetry_type type)
+{
+	switch(type)
+	{
+		case telemetry_type::uint16:
+		case telemetry_type::uint32:
+		case telemetry_type::uint64:
+		case telemetry_type::int32:
+		case telemetry_type::int64:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+// Floating point values are XOR'ed with their predecessor and then stored byte shuffled, ie. first all the lowest bytes, then all second
+// lowest bytes etc. Repeated values turn into zeros and sign and exponent bytes barely change, so the upper planes become long runs
+static size_t get_shuffled_value_size(telemetry_type type)
+{
+	switch(type)
+	{
+		case telemetry_type::f32:
+			return sizeof(float);
+		case telemetry_type::f64:
+			return sizeof(double);
+		case telemetry_type::vec2:
+			return sizeof(float) * 2;
+		case telemetry_type::dvec2:
+			return sizeof(double) * 2;
+
+		default:
+			return 0;
+	}
+}
+
+static bool is_numeric_type(telemetry_type type)
+{
+	switch(type)
+	{
+		case telemetry_type::string:
+		case telemetry_type::vec2:
+		case telemetry_type::dvec2:
+			return false;
+
+		default:
+			return true;
+	}
+}
+
+static uint64_t get_integer_bits(const telemetry_data_value &value)
+{
+	switch(value.type)
+	{
+		case telemetry_type::uint16:
+			return value.u16;
+		case telemetry_type::uint32:
+			return value.u32;
+		case telemetry_type::uint64:
+			return value.u64;
+		case telemetry_type::int32:
+			return value.i32;
+		case telemetry_type::int64:
+			return value.i64;
+
+		default:
+			return 0;
+	}
+}
+
+static void set_integer_bits(telemetry_data_value &value, uint64_t bits)
+{
+	switch(value.type)
+	{
+		case telemetry_type::uint16:
+			value.u16 = uint16_t(bits);
+			break;
+		case telemetry_type::uint32:
+			value.u32 = uint32_t(bits);
+			break;
+		case telemetry_type::uint64:
+			value.u64 = bits;
+			break;
+		case telemetry_type::int32:
+			value.i32 = uint32_t(bits);
+			break;
+		case telemetry_type::int64:
+			value.i64 = bits;
+			break;
+
+		default:
+			break;
+	}
+}
+
+static std::vector<uint8_t> decompress(const uint8_t *data, size_t compressed_size, size_t size)
+{
+	std::vector<uint8_t> result(size);
+	decompress_telemetry_block(data, compressed_size, result.data(), result.size());
+
+	return result;
+}
+
+// ---------------------
+// Writing
+// ---------------------
+
+static std::vector<uint8_t> encode_timestamps(const telemetry_data_point *data_points, size_t count)
+{
+	file_writer result;
+	int64_t previous_time = 0;
+
+	for(size_t i = 0; i < count; ++ i)
+	{
+		const int64_t time = data_points[i].timestamp.ticks;
+
+		result.write_signed_varint(time - previous_time);
+		previous_time = time;
+	}
+
+	return std::move(result.get_data());
+}
+
+static telemetry_chunk_info write_chunk(file_writer &output, telemetry_block_compressor &compressor, const telemetry_field &field, const telemetry_data_point *data_points, size_t count, const std::vector<uint8_t> &timestamps, uint32_t timestamp_chunk)
+{
+	file_writer chunk;
+
+	if(timestamp_chunk == telemetry_columnar_own_timestamps)
+		chunk.write_bytes(timestamps.data(), timestamps.size());
+
+	const bool is_delta_encoded = is_delta_encoded_type(field.get_type());
+	const bool is_numeric = is_numeric_type(field.get_type());
+	const size_t shuffled_size = get_shuffled_value_size(field.get_type());
+
+	file_writer values;
+
+	uint64_t previous_value = 0;
+
+	double minimum = std::numeric_limits<double>::max();
+	double maximum = std::numeric_limits<double>::lowest();
+
+	for(size_t i = 0; i < count; ++ i)
+	{
+		const telemetry_data_value &value = data_points[i].value;
+
+		if(is_delta_encoded)
+		{
+			const uint64_t bits = get_integer_bits(value);
+
+			chunk.write_signed_varint(int64_t(bits - previous_value));
+			previous_value = bits;
+		}
+		else if(shuffled_size)
+			values.write_value(value);
+		else
+			chunk.write_value(value);
+
+		if(is_numeric)
+		{
+			const double number = value.get<double>();
+
+			minimum = std::min(minimum, number);
+			maximum = std::max(maximum, number);
+		}
+	}
+
+	if(shuffled_size)
+	{
+		std::vector<uint8_t> &bytes = values.get_data();
+
+		// Back to front, so that every value is still intact when its successor is XOR'ed with it
+		for(size_t i = count - 1; i > 0; -- i)
+		{
+			for(size_t byte = 0; byte < shuffled_size; ++ byte)
+				bytes[i * shuffled_size + byte] ^= bytes[(i - 1) * shuffled_size + byte];
+		}
+
+		for(size_t byte = 0; byte < shuffled_size; ++ byte)
+		{
+			for(size_t i = 0; i < count; ++ i)
+				chunk.write_uint8(bytes[i * shuffled_size + byte]);
+		}
+	}
+
+	const std::vector<uint8_t> compressed = compressor.compress(chunk.get_data().data(), chunk.get_written());
+
+	telemetry_chunk_info info;
+	info.provider = field.get_provider_id();
+	info.field = field.get_id();
+	info.start_time = data_points[0].timestamp;
+	info.end_time = data_points[count - 1].timestamp;
+	info.minimum = is_numeric ? minimum : 0.0;
+	info.maximum = is_numeric ? maximum : 0.0;
+	info.count = uint32_t(count);
+	info.offset = output.get_written();
+	info.compressed_size = uint32_t(compressed.size());
+	info.size = uint32_t(chunk.get_written());
+	info.timestamp_chunk = timestamp_chunk;
+
+	output.write_bytes(compressed.data(), compressed.size());
+
+	return info;
+}
+
+static void write_event(file_writer &output, const telemetry_event &event)
+{
+	output.write_uint64(event.get_id());
+	output.write_double(event.get_start());
+	output.write_double(event.get_end());
+
+	output.write_uint32(uint32_t(event.get_entries().size()));
+
+	for(auto &entry : event.get_entries())
+	{
+		output.write_uint8(uint8_t(entry.value.type));
+		output.write_string(entry.title);
+		output.write_value(entry.value);
+	}
+
+	output.write_uint32(uint32_t(event.get_children().size()));
+
+	for(auto &child : event.get_children())
+		write_event(output, child);
+}
+
+static void write_metadata(file_writer &output, const telemetry_container &container)
+{
+	output.write_uint32(uint32_t(container.get_providers().size()));
+
+	for(auto &provider : container.get_providers())
+	{
+		output.write_uint16(provider.get_id());
+		output.write_uint16(provider.get_version());
+		output.write_string(provider.get_identifier());
+		output.write_string(provider.get_title());
+
+		output.write_uint32(uint32_t(provider.get_fields().size()));
+
+		for(auto &field : provider.get_fields())
+		{
+			output.write_uint8(field.get_id());
+			output.write_uint8(uint8_t(field.get_type()));
+			output.write_uint8(uint8_t(field.get_unit()));
+			output.write_string(field.get_title());
+		}
+	}
+
+	output.write_uint32(uint32_t(container.get_statistics().size()));
+
+	for(auto &statistic : container.get_statistics())
+	{
+		output.write_string(statistic.get_title());
+		output.write_uint32(uint32_t(statistic.get_entries().size()));
+
+		for(auto &entry : statistic.get_entries())
+		{
+			output.write_uint8(uint8_t(entry.value.type));
+			output.write_string(entry.title);
+			output.write_value(entry.value);
+		}
+	}
+
+	output.write_uint32(uint32_t(container.get_events().size()));
+
+	for(auto &event : container.get_events())
+		write_event(output, event);
+}
+
+std::vector<uint8_t> write_columnar_telemetry(const telemetry_container &container)
+{
+	file_writer output;
+
+	output.write_uint32(telemetry_columnar_version);
+	output.write_uint32(columnar_header_length);
+
+	std::vector<telemetry_chunk_info> chunks;
+	telemetry_block_compressor compressor;
+
+	for(auto &provider : container.get_providers())
+	{
+		// Encoded timestamps of the chunks written so far for this provider, by the position of the chunk within its field
+		std::vector<std::vector<std::pair<std::vector<uint8_t>, uint32_t>>> written_timestamps;
+
+		for(auto &field : provider.get_fields())
+		{
+			// Chunks hold one data point per sample and there is no way to mark a field as compacted, reading runs back would turn them into samples
+			if(field.get_encoding() == telemetry_field_encoding::runs)
+				throw std::invalid_argument("Compacted fields can't be written as columnar telemetry");
+
+			// Compressed fields have to be decoded first
+			const bool is_compressed = (field.get_encoding() == telemetry_field_encoding::compressed);
+			std::vector<telemetry_data_point> decompressed;
+
+			if(is_compressed)
+				decompressed = field.get_data_points_in_range(telemetry_time(std::numeric_limits<int64_t>::min()), telemetry_time(std::numeric_limits<int64_t>::max()));
+
+			const auto &data_points = is_compressed ? decompressed : field.get_data_points();
+
+			for(size_t i = 0; i < data_points.size(); i += telemetry_columnar_chunk_size)
+			{
+				const size_t count = std::min(data_points.size() - i, size_t(telemetry_columnar_chunk_size));
+				const size_t position = i / telemetry_columnar_chunk_size;
+
+				std::vector<uint8_t> timestamps = encode_timestamps(data_points.data() + i, count);
+				uint32_t timestamp_chunk = telemetry_columnar_own_timestamps;
+
+				if(written_timestamps.size() <= position)
+					written_timestamps.resize(position + 1);
+
+				for(auto &[ encoded, index ] : written_timestamps[position])
+				{
+					if(encoded == timestamps)
+					{
+						timestamp_chunk = index;
+						break;
+					}
+				}
+
+				chunks.push_back(write_chunk(output, compressor, field, data_points.data() + i, count, timestamps, timestamp_chunk));
+
+				if(timestamp_chunk == telemetry_columnar_own_timestamps)
+					written_timestamps[position].emplace_back(std::move(timestamps), uint32_t(chunks.size() - 1));
+			}
+		}
+	}
+
+	file_writer metadata;
+	write_metadata(metadata, container);
+
+	const std::vector<uint8_t> compressed_metadata = compressor.compress(metadata.get_data().data(), metadata.get_written());
+
+	const uint64_t metadata_offset = output.get_written();
+	output.write_bytes(compressed_metadata.data(), compressed_metadata.size());
+
+	const uint64_t footer_offset = output.get_written();
+
+	output.write_uint32(uint32_t(chunks.size()));
+
+	for(auto &chunk : chunks)
+	{
+		output.write_uint16(chunk.provider);
+		output.write_uint8(chunk.field);
+		output.write_int64(chunk.start_time.ticks);
+		output.write_int64(chunk.end_time.ticks);
+		output.write_double(chunk.minimum);
+		output.write_double(chunk.maximum);
+		output.write_uint32(chunk.count);
+		output.write_uint64(chunk.offset);
+		output.write_uint32(chunk.compressed_size);
+		output.write_uint32(chunk.size);
+		output.write_uint32(chunk.timestamp_chunk);
+	}
+
+	output.write_uint64(metadata_offset);
+	output.write_uint32(uint32_t(compressed_metadata.size()));
+	output.write_uint32(uint32_t(metadata.get_written()));
+
+	output.write_uint64(footer_offset);
+	output.write_uint32(columnar_magic);
+
+	return std::move(output.get_data());
+}
+
+std::vector<uint8_t> convert_telemetry_to_columnar(const void *data, size_t size)
+{
+	telemetry_parser_options options;
+
+	telemetry_container container = parse_telemetry_data(data, size, options);
+
+	return write_columnar_telemetry(container);
+}
+
+// ---------------------
+// Reading
+// ---------------------
+
+static telemetry_event read_event(file_reader &reader)
+{
+	const uint64_t id = reader.read_uint64();
+	const double start = reader.read_double();
+	const double end = reader.read_double();
+
+	telemetry_event event(id, start, end);
+
+	const uint32_t entries = reader.read_uint32();
+
+	for(uint32_t i = 0; i < entries; ++ i)
+	{
+		const telemetry_type type = static_cast<telemetry_type>(reader.read_uint8());
+
+		telemetry_event_entry entry;
+		entry.title = reader.read_string();
+		entry.value = reader.read_value(type);
+
+		event.add_entry(std::move(entry));
+	}
+
+	const uint32_t children = reader.read_uint32();
+
+	for(uint32_t i = 0; i < children; ++ i)
+		event.add_child(read_event(reader));
+
+	return event;
+}
+
+static telemetry_container read_metadata(file_reader &reader)
+{
+	telemetry_container container(telemetry_columnar_version);
+
+	const uint32_t providers = reader.read_uint32();
+
+	for(uint32_t i = 0; i < providers; ++ i)
+	{
+		const uint16_t id = reader.read_uint16();
+		const uint16_t version = reader.read_uint16();
+		const std::string identifier = reader.read_string();
+		const std::string title = reader.read_string();
+
+		telemetry_provider provider(id, version, identifier, title);
+
+		const uint32_t fields = reader.read_uint32();
+
+		for(uint32_t j = 0; j < fields; ++ j)
+		{
+			const uint8_t field_id = reader.read_uint8();
+			const telemetry_type type = static_cast<telemetry_type>(reader.read_uint8());
+			const telemetry_unit unit = static_cast<telemetry_unit>(reader.read_uint8());
+			const std::string field_title = reader.read_string();
+
+			provider.add_field(telemetry_field(field_id, id, field_title, type, unit));
+		}
+
+		container.add_provider(std::move(provider));
+	}
+
+	const uint32_t statistics = reader.read_uint32();
+
+	for(uint32_t i = 0; i < statistics; ++ i)
+	{
+		telemetry_statistic statistic(reader.read_string());
+
+		const uint32_t entries = reader.read_uint32();
+
+		for(uint32_t j = 0; j < entries; ++ j)
+		{
+			const telemetry_type type = static_cast<telemetry_type>(reader.read_uint8());
+
+			telemetry_statistic_entry entry;
+			entry.title = reader.read_string();
+			entry.value = reader.read_value(type);
+
+			statistic.add_entry(std::move(entry));
+		}
+
+		container.add_statistic(std::move(statistic));
+	}
+
+	const uint32_t events = reader.read_uint32();
+
+	for(uint32_t i = 0; i < events; ++ i)
+		container.add_event(read_event(reader));
+
+	return container;
+}
+
+telemetry_columnar_reader::telemetry_columnar_reader(const void *data, size_t size) :
+	m_data(static_cast<const uint8_t *>(data)),
+	m_size(size)
+{
+	if(m_size < columnar_header_length + columnar_trailer_length)
+		throw std::invalid_argument("Columnar telemetry data is truncated");
+
+	file_reader header(m_data, m_size);
+
+	if(header.read_uint32() != telemetry_columnar_version || header.read_uint32() != columnar_header_length)
+		throw std::invalid_argument("Unsupported columnar telemetry version");
+
+	file_reader trailer(m_data, m_size - columnar_trailer_length, m_size);
+
+	const uint64_t footer_offset = trailer.read_uint64();
+
+	if(trailer.read_uint32() != columnar_magic || footer_offset < columnar_header_length || footer_offset > m_size - columnar_trailer_length)
+		throw std::invalid_argument("Columnar telemetry data is missing its footer");
+
+	file_reader footer(m_data, footer_offset, m_size - columnar_trailer_length);
+
+	const uint32_t count = footer.read_uint32();
+
+	if(footer.get_remaining() < size_t(count) * columnar_chunk_entry_length + 16)
+		throw std::invalid_argument("Columnar telemetry footer is truncated");
+
+	m_chunks.reserve(count);
+
+	for(uint32_t i = 0; i < count; ++ i)
+	{
+		telemetry_chunk_info chunk;
+		chunk.provider = footer.read_uint16();
+		chunk.field = footer.read_uint8();
+		chunk.start_time = telemetry_time(footer.read_int64());
+		chunk.end_time = telemetry_time(footer.read_int64());
+		chunk.minimum = footer.read_double();
+		chunk.maximum = footer.read_double();
+		chunk.count = footer.read_uint32();
+		chunk.offset = footer.read_uint64();
+		chunk.compressed_size = footer.read_uint32();
+		chunk.size = footer.read_uint32();
+		chunk.timestamp_chunk = footer.read_uint32();
+
+		if(chunk.offset < columnar_header_length || chunk.offset > footer_offset || chunk.compressed_size > footer_offset - chunk.offset)
+			throw std::invalid_argument("Columnar telemetry chunk is out of bounds");
+
+		// Every sample takes up at least one byte, which together with the compression ratio bounds what decoding may allocate
+		if(chunk.count == 0 || chunk.count > chunk.size || !is_plausible_block(chunk.compressed_size, chunk.size) || chunk.start_time > chunk.end_time)
+			throw std::invalid_argument("Columnar telemetry chunk is malformed");
+
+		if(chunk.timestamp_chunk != telemetry_columnar_own_timestamps)
+		{
+			if(chunk.timestamp_chunk >= i)
+				throw std::invalid_argument("Columnar telemetry chunk is malformed");
+
+			const telemetry_chunk_info &source = m_chunks[chunk.timestamp_chunk];
+
+			if(source.timestamp_chunk != telemetry_columnar_own_timestamps || source.provider != chunk.provider || source.count != chunk.count)
+				throw std::invalid_argument("Columnar telemetry chunk is malformed");
+		}
+
+		std::vector<uint32_t> &field_chunks = m_field_chunks[(uint32_t(chunk.provider) << 8) | chunk.field];
+
+		if(!field_chunks.empty() && m_chunks[field_chunks.back()].end_time > chunk.start_time)
+			throw std::invalid_argument("Columnar telemetry chunks are out of order");
+
+		field_chunks.push_back(i);
+		m_chunks.push_back(chunk);
+	}
+
+	const uint64_t metadata_offset = footer.read_uint64();
+	const uint32_t metadata_compressed_size = footer.read_uint32();
+	const uint32_t metadata_size = footer.read_uint32();
+
+	if(metadata_offset < columnar_header_length || metadata_offset > footer_offset || metadata_compressed_size > footer_offset - metadata_offset)
+		throw std::invalid_argument("Columnar telemetry metadata is out of bounds");
+	if(!is_plausible_block(metadata_compressed_size, metadata_size))
+		throw std::invalid_argument("Columnar telemetry metadata is malformed");
+
+	const std::vector<uint8_t> metadata = decompress(m_data + metadata_offset, metadata_compressed_size, metadata_size);
+
+	file_reader metadata_reader(metadata.data(), metadata.size());
+	m_layout = read_metadata(metadata_reader);
+
+	for(auto &chunk : m_chunks)
+	{
+		if(!m_layout.has_provider(chunk.provider) || !m_layout.get_provider(chunk.provider).has_field(chunk.field))
+			throw std::invalid_argument("Columnar telemetry chunk references unknown field");
+	}
+}
+
+const std::vector<uint32_t> &telemetry_columnar_reader::get_field_chunks(uint16_t provider, uint8_t field) const
+{
+	static const std::vector<uint32_t> empty;
+
+	auto iterator = m_field_chunks.find((uint32_t(provider) << 8) | field);
+	return (iterator != m_field_chunks.end()) ? iterator->second : empty;
+}
+
+std::vector<telemetry_chunk_info> telemetry_columnar_reader::get_chunks(uint16_t provider, uint8_t field, telemetry_time start, telemetry_time end) const
+{
+	const std::vector<uint32_t> &indices = get_field_chunks(provider, field);
+
+	// Chunks of a field don't overlap, so the ones ending before start are all at the front
+	auto iterator = std::partition_point(indices.begin(), indices.end(), [&](uint32_t index) {
+		return m_chunks[index].end_time < start;
+	});
+
+	std::vector<telemetry_chunk_info> result;
+
+	for(; iterator != indices.end() && m_chunks[*iterator].start_time <= end; ++ iterator)
+		result.push_back(m_chunks[*iterator]);
+
+	return result;
+}
+
+std::vector<uint8_t> telemetry_columnar_reader::decompress_chunk(const telemetry_chunk_info &chunk) const
+{
+	return decompress(m_data + chunk.offset, chunk.compressed_size, chunk.size);
+}
+
+std::vector<telemetry_time> telemetry_columnar_reader::read_timestamps(const telemetry_chunk_info &chunk) const
+{
+	if(chunk.timestamp_chunk != telemetry_columnar_own_timestamps)
+		return read_timestamps(m_chunks.at(chunk.timestamp_chunk));
+
+	const std::vector<uint8_t> data = decompress_chunk(chunk);
+	file_reader reader(data.data(), data.size());
+
+	std::vector<telemetry_time> result(chunk.count);
+	int64_t time = 0;
+
+	for(auto &timestamp : result)
+	{
+		time += reader.read_signed_varint();
+		timestamp = telemetry_time(time);
+	}
+
+	return result;
+}
+
+void telemetry_columnar_reader::read_values(const telemetry_chunk_info &chunk, file_reader &reader, std::vector<telemetry_data_point> &data_points) const
+{
+	const telemetry_type type = m_layout.get_provider(chunk.provider).get_field(chunk.field).get_type();
+
+	if(is_delta_encoded_type(type))
+	{
+		uint64_t value = 0;
+
+		for(auto &data_point : data_points)
+		{
+			value += uint64_t(reader.read_signed_varint());
+
+			data_point.value.type = type;
+			set_integer_bits(data_point.value, value);
+		}
+	}
+	else if(const size_t shuffled_size = get_shuffled_value_size(type))
+	{
+		const size_t count = data_points.size();
+		const size_t length = shuffled_size * count;
+
+		if(reader.get_remaining() < length)
+			throw std::invalid_argument("Columnar telemetry chunk is malformed");
+
+		std::vector<uint8_t> values(length);
+		const uint8_t *bytes = reader.get_position();
+
+		for(size_t byte = 0; byte < shuffled_size; ++ byte)
+		{
+			for(size_t i = 0; i < count; ++ i)
+				values[i * shuffled_size + byte] = bytes[byte * count + i];
+		}
+
+		for(size_t i = 1; i < count; ++ i)
+		{
+			for(size_t byte = 0; byte < shuffled_size; ++ byte)
+				values[i * shuffled_size + byte] ^= values[(i - 1) * shuffled_size + byte];
+		}
+
+		reader.skip(length);
+
+		file_reader value_reader(values.data(), values.size());
+
+		for(auto &data_point : data_points)
+			data_point.value = value_reader.read_value(type);
+	}
+	else
+	{
+		for(auto &data_point : data_points)
+			data_point.value = reader.read_value(type);
+	}
+
+	if(reader.get_remaining() != 0)
+		throw std::invalid_argument("Columnar telemetry chunk is malformed");
+}
+
+std::vector<telemetry_data_point> telemetry_columnar_reader::read_chunk(const telemetry_chunk_info &chunk) const
+{
+	if(chunk.timestamp_chunk != telemetry_columnar_own_timestamps)
+		return read_chunk(chunk, read_timestamps(chunk));
+
+	const std::vector<uint8_t> data = decompress_chunk(chunk);
+	file_reader reader(data.data(), data.size());
+
+	std::vector<telemetry_data_point> result(chunk.count);
+	int64_t time = 0;
+
+	for(auto &data_point : result)
+	{
+		time += reader.read_signed_varint();
+		data_point.timestamp = telemetry_time(time);
+	}
+
+	read_values(chunk, reader, result);
+
+	return result;
+}
+
+std::vector<telemetry_data_point> telemetry_columnar_reader::read_chunk(const telemetry_chunk_info &chunk, const std::vector<telemetry_time> &timestamps) const
+{
+	if(chunk.timestamp_chunk == telemetry_columnar_own_timestamps)
+		return read_chunk(chunk);
+
+	if(timestamps.size() != chunk.count)
+		throw std::invalid_argument("Timestamps don't match the columnar telemetry chunk");
+
+	const std::vector<uint8_t> data = decompress_chunk(chunk);
+	file_reader reader(data.data(), data.size());
+
+	std::vector<telemetry_data_point> result(chunk.count);
+
+	for(size_t i = 0; i < result.size(); ++ i)
+		result[i].timestamp = timestamps[i];
+
+	read_values(chunk, reader, result);
+
+	return result;
+}
@@ -0,0 +1,100 @@
+//
+//  columnar.h
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef TELEMETRY_COLUMNAR_H
+#define TELEMETRY_COLUMNAR_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "container.h"
+
+struct file_reader;
+
+// The columnar format stores the data points of every field in compressed chunks of up to telemetry_columnar_chunk_size samples.
+// Unlike TLMv2 files it is not a command stream, instead a footer at the end of the file indexes every chunk with its time range,
+// sample count and value range. Readers can therefore seek directly to the chunks they need without decoding anything else.
+//
+// Layout:
+//   header:   uint32 version, uint32 header length (8)
+//   chunks:   compressed blobs, each holding delta encoded timestamps followed by the typed values. Fields of a provider are usually
+//             sampled together, so a chunk whose timestamps match an earlier chunk of the same provider only references that chunk
+//   metadata: compressed blob with providers, fields, statistics and events
+//   footer:   chunk index and location of the metadata block
+//   trailer:  uint64 footer offset, uint32 magic
+
+static constexpr uint32_t telemetry_columnar_version = 4;
+static constexpr uint32_t telemetry_columnar_chunk_size = 4096;
+static constexpr uint32_t telemetry_columnar_own_timestamps = UINT32_MAX;
+
+struct telemetry_chunk_info
+{
+	uint16_t provider;
+	uint8_t field;
+
+	telemetry_time start_time;
+	telemetry_time end_time;
+
+	double minimum; // Only valid for numeric types
+	double maximum; // Only valid for numeric types
+	uint32_t count;
+
+	uint64_t offset;
+	uint32_t compressed_size;
+	uint32_t size;
+
+	uint32_t timestamp_chunk; // Index of the chunk that stores the timestamps, or telemetry_columnar_own_timestamps if they are part of this chunk
+};
+
+class telemetry_columnar_reader
+{
+public:
+	telemetry_columnar_reader(const void *data, size_t size); // Will throw std::invalid_argument() error for malformed data
+
+	// Providers, fields, statistics and events, but without any data points
+	const telemetry_container &get_layout() const { return m_layout; }
+
+	const std::vector<telemetry_chunk_info> &get_chunks() const { return m_chunks; }
+	std::vector<telemetry_chunk_info> get_chunks(uint16_t provider, uint8_t field, telemetry_time start, telemetry_time end) const;
+
+	// Indices into get_chunks() of all chunks of the field, ordered by time. Empty for fields without data points
+	const std::vector<uint32_t> &get_field_chunks(uint16_t provider, uint8_t field) const;
+
+	// Both will throw std::invalid_argument() error for malformed data. Chunks that share their timestamps decode the referenced chunk as well,
+	// unless its timestamps are passed in, see read_timestamps()
+	std::vector<telemetry_data_point> read_chunk(const telemetry_chunk_info &chunk) const;
+	std::vector<telemetry_data_point> read_chunk(const telemetry_chunk_info &chunk, const std::vector<telemetry_time> &timestamps) const;
+
+	std::vector<telemetry_time> read_timestamps(const telemetry_chunk_info &chunk) const;
+
+private:
+	std::vector<uint8_t> decompress_chunk(const telemetry_chunk_info &chunk) const;
+	void read_values(const telemetry_chunk_info &chunk, file_reader &reader, std::vector<telemetry_data_point> &data_points) const;
+
+	const uint8_t *m_data;
+	size_t m_size;
+
+	telemetry_container m_layout;
+	std::vector<telemetry_chunk_info> m_chunks;
+	std::unordered_map<uint32_t, std::vector<uint32_t>> m_field_chunks; // Keyed by provider << 8 | field
+};
+
+std::vector<uint8_t> write_columnar_telemetry(const telemetry_container &container); // Will throw std::invalid_argument() error for compacted fields, see telemetry_field::compact()
+std::vector<uint8_t> convert_telemetry_to_columnar(const void *data, size_t size); // Will throw std::invalid_argument() error for unsupported data
+
+#endif //TELEMETRY_COLUMNAR_H
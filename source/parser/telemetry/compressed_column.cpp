@@ -0,0 +1,353 @@
+//
+//  compressed_column.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include "compressed_column.h"
+
+// Delta-of-delta buckets, the prefix is followed by a signed value of the given bit width
+struct timestamp_bucket
+{
+	uint32_t prefix;
+	uint32_t prefix_bits;
+	uint32_t value_bits;
+};
+
+static constexpr timestamp_bucket timestamp_buckets[] = {
+	{ 0b10, 2, 8 },
+	{ 0b110, 3, 12 },
+	{ 0b1110, 4, 20 },
+	{ 0b1111, 4, 64 }
+};
+
+class bit_writer
+{
+public:
+	bit_writer(std::vector<uint64_t> &words) :
+		m_words(words)
+	{}
+
+	uint64_t get_position() const { return m_position; }
+
+	void write_bits(uint64_t value, uint32_t count)
+	{
+		if(count < 64)
+			value &= (uint64_t(1) << count) - 1;
+
+		const uint32_t used = m_position % 64;
+		const uint32_t available = 64 - used;
+
+		if(used == 0)
+			m_words.push_back(0);
+
+		if(count <= available)
+			m_words.back() |= value << (available - count);
+		else
+		{
+			const uint32_t rest = count - available;
+
+			m_words.back() |= value >> rest;
+			m_words.push_back(value << (64 - rest));
+		}
+
+		m_position += count;
+	}
+
+private:
+	std::vector<uint64_t> &m_words;
+	uint64_t m_position = 0;
+};
+
+// f32 values are moved into the upper half, so that the leading zero count of their XOR is meaningful
+static uint64_t get_value_bits(telemetry_type type, const telemetry_data_value &value)
+{
+	if(type == telemetry_type::f32)
+		return uint64_t(std::bit_cast<uint32_t>(value.f32)) << 32;
+
+	return std::bit_cast<uint64_t>(value.f64);
+}
+static void set_value_bits(telemetry_type type, telemetry_data_value &value, uint64_t bits)
+{
+	value.type = type;
+
+	if(type == telemetry_type::f32)
+		value.f32 = std::bit_cast<float>(uint32_t(bits >> 32));
+	else
+		value.f64 = std::bit_cast<double>(bits);
+}
+
+static int64_t sign_extend(uint64_t value, uint32_t bits)
+{
+	if(bits == 64)
+		return int64_t(value);
+
+	return int64_t(value << (64 - bits)) >> (64 - bits);
+}
+
+bool telemetry_compressed_column::is_supported_type(telemetry_type type)
+{
+	return type == telemetry_type::f32 || type == telemetry_type::f64;
+}
+
+telemetry_compressed_column::telemetry_compressed_column(telemetry_type type, const std::vector<telemetry_data_point> &data_points) :
+	m_type(type),
+	m_count(data_points.size())
+{
+	if(!is_supported_type(type))
+		throw std::invalid_argument("Compressed columns only support f32 and f64 values");
+
+	bit_writer writer(m_bits);
+
+	for(size_t start = 0; start < data_points.size(); start += block_size)
+	{
+		const size_t count = std::min<size_t>(block_size, data_points.size() - start);
+
+		block info;
+		info.start = data_points[start].timestamp;
+		info.end = data_points[start + count - 1].timestamp;
+		info.offset = writer.get_position();
+		info.count = uint32_t(count);
+
+		m_blocks.push_back(info);
+
+		// Every block starts out with a raw timestamp and value, so it can be decoded on its own
+		int64_t previous_time = data_points[start].timestamp.ticks;
+		int64_t previous_delta = 0;
+
+		uint64_t previous_value = get_value_bits(type, data_points[start].value);
+		uint32_t previous_leading = 64;
+		uint32_t previous_trailing = 0;
+
+		writer.write_bits(uint64_t(previous_time), 64);
+		writer.write_bits(previous_value, 64);
+
+		for(size_t i = start + 1; i < start + count; ++ i)
+		{
+			const int64_t time = data_points[i].timestamp.ticks;
+			const int64_t delta = time - previous_time;
+			const int64_t delta_of_delta = delta - previous_delta;
+
+			if(delta_of_delta == 0)
+				writer.write_bits(0, 1);
+			else
+			{
+				for(auto &bucket : timestamp_buckets)
+				{
+					const int64_t limit = (bucket.value_bits == 64) ? 0 : (int64_t(1) << (bucket.value_bits - 1));
+
+					if(bucket.value_bits == 64 || (delta_of_delta >= -limit && delta_of_delta < limit))
+					{
+						writer.write_bits(bucket.prefix, bucket.prefix_bits);
+						writer.write_bits(uint64_t(delta_of_delta), bucket.value_bits);
+
+						break;
+					}
+				}
+			}
+
+			previous_time = time;
+			previous_delta = delta;
+
+			const uint64_t value = get_value_bits(type, data_points[i].value);
+			const uint64_t xor_value = value ^ previous_value;
+
+			previous_value = value;
+
+			if(xor_value == 0)
+			{
+				writer.write_bits(0, 1);
+				continue;
+			}
+
+			const uint32_t leading = std::min<uint32_t>(std::countl_zero(xor_value), 31);
+			const uint32_t trailing = std::countr_zero(xor_value);
+
+			if(leading >= previous_leading && trailing >= previous_trailing)
+			{
+				// The meaningful bits fit into the previous window
+				writer.write_bits(0b10, 2);
+				writer.write_bits(xor_value >> previous_trailing, 64 - previous_leading - previous_trailing);
+			}
+			else
+			{
+				const uint32_t meaningful = 64 - leading - trailing;
+
+				writer.write_bits(0b11, 2);
+				writer.write_bits(leading, 5);
+				writer.write_bits(meaningful - 1, 6);
+				writer.write_bits(xor_value >> trailing, meaningful);
+
+				previous_leading = leading;
+				previous_trailing = trailing;
+			}
+		}
+	}
+
+	m_bits.shrink_to_fit();
+}
+
+size_t telemetry_compressed_column::get_memory_usage() const
+{
+	return m_bits.capacity() * sizeof(uint64_t) + m_blocks.capacity() * sizeof(block);
+}
+
+size_t telemetry_compressed_column::find_block(telemetry_time time) const
+{
+	const auto iterator = std::lower_bound(m_blocks.begin(), m_blocks.end(), time, [](const block &block, telemetry_time time) {
+		return block.end < time;
+	});
+
+	return iterator - m_blocks.begin();
+}
+
+telemetry_data_point telemetry_compressed_column::get_data_point(size_t index) const
+{
+	if(index >= m_count)
+		throw std::out_of_range("Data point index out of range");
+
+	block_cursor cursor(*this, index / block_size);
+	telemetry_data_point data_point;
+
+	for(size_t i = 0; i <= index % block_size; ++ i)
+		cursor.next(data_point);
+
+	return data_point;
+}
+
+size_t telemetry_compressed_column::lower_bound(telemetry_time time) const
+{
+	const size_t block = find_block(time);
+
+	if(block >= m_blocks.size())
+		return m_count;
+
+	block_cursor cursor(*this, block);
+	telemetry_data_point data_point;
+
+	size_t index = block * block_size;
+
+	while(cursor.next(data_point))
+	{
+		if(data_point.timestamp >= time)
+			break;
+
+		index ++;
+	}
+
+	return index;
+}
+
+std::vector<telemetry_data_point> telemetry_compressed_column::decompress() const
+{
+	std::vector<telemetry_data_point> result;
+	result.reserve(m_count);
+
+	for(size_t i = 0; i < m_blocks.size(); ++ i)
+	{
+		block_cursor cursor(*this, i);
+		telemetry_data_point data_point;
+
+		while(cursor.next(data_point))
+			result.push_back(data_point);
+	}
+
+	return result;
+}
+
+// ---------------------
+// Decoding
+// ---------------------
+
+telemetry_compressed_column::block_cursor::block_cursor(const telemetry_compressed_column &column, size_t block) :
+	m_column(column),
+	m_position(column.m_blocks[block].offset),
+	m_remaining(column.m_blocks[block].count)
+{}
+
+uint64_t telemetry_compressed_column::block_cursor::read_bits(uint32_t count)
+{
+	const uint64_t *words = m_column.m_bits.data();
+
+	const size_t word = m_position / 64;
+	const uint32_t used = m_position % 64;
+	const uint32_t available = 64 - used;
+
+	uint64_t result;
+
+	if(count <= available)
+		result = (words[word] << used) >> (64 - count);
+	else
+	{
+		const uint32_t rest = count - available;
+		result = ((words[word] << used) >> (64 - count)) | (words[word + 1] >> (64 - rest));
+	}
+
+	m_position += count;
+	return result;
+}
+
+bool telemetry_compressed_column::block_cursor::next(telemetry_data_point &data_point)
+{
+	if(m_remaining == 0)
+		return false;
+
+	m_remaining --;
+
+	if(m_first)
+	{
+		m_first = false;
+
+		m_time = int64_t(read_bits(64));
+		m_value = read_bits(64);
+		m_leading = 64;
+		m_trailing = 0;
+	}
+	else
+	{
+		if(read_bits(1) != 0)
+		{
+			// Walk the bucket prefixes, each additional set bit selects the next bucket
+			size_t bucket = 0;
+
+			while(bucket < std::size(timestamp_buckets) - 1 && read_bits(1) != 0)
+				bucket ++;
+
+			const uint32_t bits = timestamp_buckets[bucket].value_bits;
+			m_delta += sign_extend(read_bits(bits), bits);
+		}
+
+		m_time += m_delta;
+
+		if(read_bits(1) != 0)
+		{
+			if(read_bits(1) != 0)
+			{
+				m_leading = uint32_t(read_bits(5));
+				m_trailing = 64 - m_leading - (uint32_t(read_bits(6)) + 1);
+			}
+
+			m_value ^= read_bits(64 - m_leading - m_trailing) << m_trailing;
+		}
+	}
+
+	data_point.timestamp = telemetry_time(m_time);
+	set_value_bits(m_column.m_type, data_point.value, m_value);
+
+	return true;
+}
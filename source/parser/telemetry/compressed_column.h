@@ -0,0 +1,113 @@
+//
+//  compressed_column.h
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef TELEMETRY_COMPRESSED_COLUMN_H
+#define TELEMETRY_COMPRESSED_COLUMN_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "data.h"
+
+// Gorilla style in-memory storage for floating point data points. Timestamps are stored as bit packed delta-of-deltas and every
+// value is XOR'ed against its predecessor, so regular timestamps and slowly changing values take up only a few bits per sample.
+// Data points are split into blocks of block_size samples, with an index of the time range of each block for random access.
+class telemetry_compressed_column
+{
+public:
+	static constexpr uint32_t block_size = 1024;
+
+	// Streams the data points of a single block in order
+	class block_cursor
+	{
+	public:
+		block_cursor(const telemetry_compressed_column &column, size_t block);
+
+		bool next(telemetry_data_point &data_point);
+
+	private:
+		uint64_t read_bits(uint32_t count);
+
+		const telemetry_compressed_column &m_column;
+		uint64_t m_position;
+		uint32_t m_remaining;
+		bool m_first = true;
+
+		int64_t m_time = 0;
+		int64_t m_delta = 0;
+
+		uint64_t m_value = 0;
+		uint32_t m_leading = 0;
+		uint32_t m_trailing = 0;
+	};
+
+	telemetry_compressed_column() = default;
+	telemetry_compressed_column(telemetry_type type, const std::vector<telemetry_data_point> &data_points); // Will throw std::invalid_argument() for unsupported types
+
+	static bool is_supported_type(telemetry_type type);
+
+	bool empty() const { return m_count == 0; }
+	size_t size() const { return m_count; }
+	size_t get_memory_usage() const;
+
+	telemetry_data_point get_data_point(size_t index) const;
+	size_t lower_bound(telemetry_time time) const; // Index of the first data point at or after time, size() if there is none
+
+	std::vector<telemetry_data_point> decompress() const;
+
+	// Calls function for every data point in [start, end], only decoding the blocks that overlap the range
+	template<class F>
+	void for_each_in_range(telemetry_time start, telemetry_time end, F &&function) const
+	{
+		for(size_t i = find_block(start); i < m_blocks.size() && m_blocks[i].start <= end; ++ i)
+		{
+			block_cursor cursor(*this, i);
+			telemetry_data_point data_point;
+
+			while(cursor.next(data_point))
+			{
+				if(data_point.timestamp < start)
+					continue;
+				if(data_point.timestamp > end)
+					return;
+
+				function(data_point);
+			}
+		}
+	}
+
+private:
+	struct block
+	{
+		telemetry_time start;
+		telemetry_time end;
+
+		uint64_t offset; // In bits
+		uint32_t count;
+	};
+
+	size_t find_block(telemetry_time time) const; // First block that ends at or after time
+
+	telemetry_type m_type = telemetry_type::f64;
+	size_t m_count = 0;
+
+	std::vector<block> m_blocks;
+	std::vector<uint64_t> m_bits;
+};
+
+#endif //TELEMETRY_COMPRESSED_COLUMN_H
@@ -0,0 +1,211 @@
+//
+//  compression.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include "compression.h"
+
+static constexpr size_t min_match_length = 4;
+static constexpr size_t max_match_offset = UINT16_MAX;
+static constexpr uint32_t hash_bits = 14;
+
+static uint32_t read_sequence(const uint8_t *data)
+{
+	uint32_t result;
+	std::memcpy(&result, data, sizeof(result));
+
+	return result;
+}
+
+static uint32_t hash_sequence(uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - hash_bits);
+}
+
+static void write_length(std::vector<uint8_t> &output, size_t length)
+{
+	while(length >= 255)
+	{
+		output.push_back(255);
+		length -= 255;
+	}
+
+	output.push_back(uint8_t(length));
+}
+
+static void write_sequence(std::vector<uint8_t> &output, const uint8_t *literals, size_t literal_length, size_t offset, size_t match_length)
+{
+	const size_t encoded_match = match_length ? match_length - min_match_length : 0;
+
+	uint8_t token = uint8_t(std::min<size_t>(literal_length, 15) << 4);
+	token |= uint8_t(std::min<size_t>(encoded_match, 15));
+
+	output.push_back(token);
+
+	if(literal_length >= 15)
+		write_length(output, literal_length - 15);
+
+	output.insert(output.end(), literals, literals + literal_length);
+
+	if(match_length == 0)
+		return;
+
+	output.push_back(uint8_t(offset));
+	output.push_back(uint8_t(offset >> 8));
+
+	if(encoded_match >= 15)
+		write_length(output, encoded_match - 15);
+}
+
+telemetry_block_compressor::telemetry_block_compressor() :
+	m_table(1 << hash_bits, 0)
+{}
+
+std::vector<uint8_t> telemetry_block_compressor::compress(const uint8_t *data, size_t size)
+{
+	// Entries store base + position + 1, once the base would overflow everything starts over from an empty table
+	if(size >= UINT32_MAX - m_base)
+	{
+		if(size >= UINT32_MAX)
+			throw std::invalid_argument("Block is too large to compress");
+
+		std::fill(m_table.begin(), m_table.end(), 0);
+		m_base = 0;
+	}
+
+	std::vector<uint8_t> result;
+	result.reserve(size / 2 + 16);
+
+	size_t anchor = 0;
+	size_t position = 0;
+
+	while(position + min_match_length <= size)
+	{
+		const uint32_t sequence = read_sequence(data + position);
+		const uint32_t hash = hash_sequence(sequence);
+
+		const uint32_t entry = m_table[hash];
+		m_table[hash] = uint32_t(m_base + position + 1);
+
+		if(entry <= m_base)
+		{
+			position ++;
+			continue;
+		}
+
+		const size_t match = entry - m_base - 1;
+
+		if(position - match > max_match_offset || read_sequence(data + match) != sequence)
+		{
+			position ++;
+			continue;
+		}
+
+		size_t length = min_match_length;
+
+		while(position + length < size && data[match + length] == data[position + length])
+			length ++;
+
+		write_sequence(result, data + anchor, position - anchor, position - match, length);
+
+		position += length;
+		anchor = position;
+	}
+
+	// The last sequence is always literals only, which is also how the decompressor knows that it's done
+	write_sequence(result, data + anchor, size - anchor, 0, 0);
+
+	m_base += uint32_t(size) + 1;
+
+	return result;
+}
+
+std::vector<uint8_t> compress_telemetry_block(const uint8_t *data, size_t size)
+{
+	telemetry_block_compressor compressor;
+	return compressor.compress(data, size);
+}
+
+void decompress_telemetry_block(const uint8_t *data, size_t size, uint8_t *output, size_t output_size)
+{
+	const uint8_t *end = data + size;
+	size_t written = 0;
+
+	auto read_length = [&](size_t base) -> size_t {
+
+		if(base != 15)
+			return base;
+
+		size_t length = base;
+
+		while(true)
+		{
+			if(data >= end)
+				throw std::invalid_argument("Corrupt compressed block");
+
+			const uint8_t byte = *data ++;
+			length += byte;
+
+			if(byte != 255)
+				break;
+		}
+
+		return length;
+	};
+
+	while(data < end)
+	{
+		const uint8_t token = *data ++;
+
+		const size_t literal_length = read_length(token >> 4);
+
+		if(literal_length > size_t(end - data) || literal_length > output_size - written)
+			throw std::invalid_argument("Corrupt compressed block");
+
+		std::memcpy(output + written, data, literal_length);
+
+		data += literal_length;
+		written += literal_length;
+
+		if(data >= end)
+			break;
+
+		if(end - data < 2)
+			throw std::invalid_argument("Corrupt compressed block");
+
+		const size_t offset = size_t(data[0]) | (size_t(data[1]) << 8);
+		data += 2;
+
+		const size_t match_length = read_length(token & 0xf) + min_match_length;
+
+		if(offset == 0 || offset > written || match_length > output_size - written)
+			throw std::invalid_argument("Corrupt compressed block");
+
+		// Matches are allowed to overlap with the output they produce, so this has to be copied byte by byte
+		const uint8_t *source = output + written - offset;
+
+		for(size_t i = 0; i < match_length; ++ i)
+			output[written + i] = source[i];
+
+		written += match_length;
+	}
+
+	if(written != output_size)
+		throw std::invalid_argument("Corrupt compressed block");
+}
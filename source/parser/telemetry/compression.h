@@ -0,0 +1,45 @@
+//
+//  compression.h
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef TELEMETRY_COMPRESSION_H
+#define TELEMETRY_COMPRESSION_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// LZ77 style block compression, using the same sequence layout as LZ4 blocks (token, literals, 16bit offset, match length).
+// This is not a general purpose compressor, it's tuned for decompression speed on the small, repetitive blocks written by the columnar format.
+std::vector<uint8_t> compress_telemetry_block(const uint8_t *data, size_t size);
+void decompress_telemetry_block(const uint8_t *data, size_t size, uint8_t *output, size_t output_size); // Will throw std::invalid_argument() for corrupt data
+
+// Compresses many blocks with a single match table. Positions are stored relative to a base that moves past every block, so
+// entries left over from earlier blocks are simply out of range and the table never has to be cleared or allocated again
+class telemetry_block_compressor
+{
+public:
+	telemetry_block_compressor();
+
+	std::vector<uint8_t> compress(const uint8_t *data, size_t size);
+
+private:
+	std::vector<uint32_t> m_table;
+	uint32_t m_base = 0;
+};
+
+#endif //TELEMETRY_COMPRESSION_H
@@ -20,9 +20,7 @@
 #include "container.h"
 
 telemetry_container::telemetry_container(uint32_t version) :
-	m_version(version),
-	m_start_time(0),
-	m_end_time(0)
+	m_version(version)
 {}
 
 bool telemetry_container::has_provider(uint16_t id) const
@@ -123,11 +121,11 @@ telemetry_event &telemetry_container::get_event(uint64_t id)
 	throw std::out_of_range("No event with id " + std::to_string(id));
 }
 
-void telemetry_container::set_start_time(int32_t start_time)
+void telemetry_container::set_start_time(telemetry_time start_time)
 {
 	m_start_time = start_time;
 }
-void telemetry_container::set_end_time(int32_t end_time)
+void telemetry_container::set_end_time(telemetry_time end_time)
 {
 	m_end_time = end_time;
 }
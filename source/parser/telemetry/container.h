@@ -54,11 +54,14 @@ public:
 	const std::vector<telemetry_statistic> &get_statistics() const { return m_statistics; }
 	std::vector<telemetry_statistic> &get_statistics() { return m_statistics; }
 
-	int32_t get_start_time() const { return m_start_time; }
-	int32_t get_end_time() const { return m_end_time; }
+	telemetry_time get_start_time() const { return m_start_time; }
+	telemetry_time get_end_time() const { return m_end_time; }
 
-	void set_start_time(int32_t start_time);
-	void set_end_time(int32_t end_time);
+	double get_start_seconds() const { return m_start_time.to_seconds(); }
+	double get_end_seconds() const { return m_end_time.to_seconds(); }
+
+	void set_start_time(telemetry_time start_time);
+	void set_end_time(telemetry_time end_time);
 
 	void add_provider(telemetry_provider &&provider);
 	void add_event(telemetry_event &&event);
@@ -67,8 +70,8 @@ public:
 private:
 	uint32_t m_version = 0;
 
-	int32_t m_start_time = 0;
-	int32_t m_end_time = 0;
+	telemetry_time m_start_time;
+	telemetry_time m_end_time;
 
 	std::vector<telemetry_provider> m_providers;
 	std::vector<telemetry_event> m_events;
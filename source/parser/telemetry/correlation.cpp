@@ -0,0 +1,190 @@
+//
+//  correlation.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include "correlation.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TELEMETRY_CORRELATION_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define TELEMETRY_CORRELATION_NEON 1
+#endif
+
+// Four products per iteration in two independent vector accumulators, the scalar loop picks up the remainder
+static double dot_product(const double *a, const double *b, size_t count)
+{
+	double result = 0.0;
+	size_t i = 0;
+
+#if TELEMETRY_CORRELATION_SSE2
+	if(count >= 4)
+	{
+		__m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+
+		for(; i + 4 <= count; i += 4)
+		{
+			sum0 = _mm_add_pd(sum0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+			sum1 = _mm_add_pd(sum1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+		}
+
+		double lanes[2];
+		_mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+
+		result = lanes[0] + lanes[1];
+	}
+#elif TELEMETRY_CORRELATION_NEON
+	if(count >= 4)
+	{
+		float64x2_t sum0 = vdupq_n_f64(0.0), sum1 = sum0;
+
+		for(; i + 4 <= count; i += 4)
+		{
+			sum0 = vfmaq_f64(sum0, vld1q_f64(a + i), vld1q_f64(b + i));
+			sum1 = vfmaq_f64(sum1, vld1q_f64(a + i + 2), vld1q_f64(b + i + 2));
+		}
+
+		result = vaddvq_f64(vaddq_f64(sum0, sum1));
+	}
+#endif
+
+	for(; i < count; ++ i)
+		result += a[i] * b[i];
+
+	return result;
+}
+
+static std::vector<double> rank_values(const std::vector<double> &values)
+{
+	std::vector<size_t> order(values.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+		return values[lhs] < values[rhs];
+	});
+
+	std::vector<double> ranks(values.size());
+
+	for(size_t i = 0; i < order.size();)
+	{
+		size_t end = i + 1;
+
+		while(end < order.size() && values[order[end]] == values[order[i]])
+			end ++;
+
+		const double rank = (i + end - 1) * 0.5;
+
+		for(size_t j = i; j < end; ++ j)
+			ranks[order[j]] = rank;
+
+		i = end;
+	}
+
+	return ranks;
+}
+
+telemetry_correlation_series::column::column(const std::vector<double> &input) :
+	values(input),
+	sums(input.size() + 1, 0.0),
+	squares(input.size() + 1, 0.0)
+{
+	if(values.empty())
+		return;
+
+	const double mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+
+	for(size_t i = 0; i < values.size(); ++ i)
+	{
+		values[i] -= mean;
+
+		sums[i + 1] = sums[i] + values[i];
+		squares[i + 1] = squares[i] + values[i] * values[i];
+	}
+}
+
+telemetry_correlation_series::telemetry_correlation_series(const std::vector<double> &values) :
+	m_values(values),
+	m_ranks(rank_values(values))
+{
+	m_constant = std::all_of(values.begin(), values.end(), [&](double value) { return value == values.front(); });
+}
+
+double telemetry_correlation_series::correlate_at_lag(const column &a, const column &b, int64_t lag)
+{
+	const size_t count = a.values.size();
+	const size_t shift = size_t(std::abs(lag));
+	const size_t overlap = count - shift;
+
+	const size_t a_start = lag < 0 ? shift : 0;
+	const size_t b_start = lag > 0 ? shift : 0;
+
+	const double sum_a = a.sums[a_start + overlap] - a.sums[a_start];
+	const double sum_b = b.sums[b_start + overlap] - b.sums[b_start];
+
+	const double variance_a = (a.squares[a_start + overlap] - a.squares[a_start]) - sum_a * sum_a / overlap;
+	const double variance_b = (b.squares[b_start + overlap] - b.squares[b_start]) - sum_b * sum_b / overlap;
+
+	// Relative to the whole series, rounding in the prefix sums can leave a little variance in ranges that are in fact constant
+	constexpr double epsilon = 1e-12;
+
+	if(variance_a <= epsilon * a.squares.back() || variance_b <= epsilon * b.squares.back())
+		return std::numeric_limits<double>::quiet_NaN();
+
+	const double covariance = dot_product(a.values.data() + a_start, b.values.data() + b_start, overlap) - sum_a * sum_b / overlap;
+
+	return std::clamp(covariance / std::sqrt(variance_a * variance_b), -1.0, 1.0);
+}
+
+telemetry_correlation correlate_telemetry_series(const telemetry_correlation_series &a, const telemetry_correlation_series &b, size_t max_lag)
+{
+	if(a.size() != b.size())
+		throw std::invalid_argument("Correlated series need to be on the same grid");
+
+	telemetry_correlation result;
+
+	if(a.size() < 2 || a.is_constant() || b.is_constant())
+		return result;
+
+	result.pearson = telemetry_correlation_series::correlate_at_lag(a.m_values, b.m_values, 0);
+	result.spearman = telemetry_correlation_series::correlate_at_lag(a.m_ranks, b.m_ranks, 0);
+
+	const int64_t lags = int64_t(std::min(max_lag, a.size() / 2));
+	result.lags.reserve(lags * 2 + 1);
+
+	for(int64_t lag = -lags; lag <= lags; ++ lag)
+	{
+		const double correlation = (lag == 0) ? result.pearson : telemetry_correlation_series::correlate_at_lag(a.m_values, b.m_values, lag);
+		result.lags.push_back(correlation);
+
+		if(std::isnan(correlation))
+			continue;
+
+		// Ties go to the shortest lag
+		if(std::isnan(result.peak_correlation) || std::abs(correlation) > std::abs(result.peak_correlation) ||
+		   (std::abs(correlation) == std::abs(result.peak_correlation) && std::abs(lag) < std::abs(result.peak_lag)))
+		{
+			result.peak_correlation = correlation;
+			result.peak_lag = lag;
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,75 @@
+//
+//  correlation.h
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef TELEMETRY_CORRELATION_H
+#define TELEMETRY_CORRELATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+struct telemetry_correlation
+{
+	double pearson = std::numeric_limits<double>::quiet_NaN();
+	double spearman = std::numeric_limits<double>::quiet_NaN(); // Pearson correlation of the ranks
+
+	// The lag with the strongest Pearson correlation in either direction, in grid points. Positive lags mean that b follows a
+	int64_t peak_lag = 0;
+	double peak_correlation = std::numeric_limits<double>::quiet_NaN();
+
+	std::vector<double> lags; // Pearson correlation of a[i] and b[i + lag] for every lag in [-max_lag, max_lag]
+};
+
+// A series sampled on a grid shared with the series it's correlated with, see resample_telemetry_values().
+// Ranks and prefix sums are built once up front, so a series that is part of many pairs is only sorted once and every lag costs a single
+// vectorized dot product over the overlap
+class telemetry_correlation_series
+{
+public:
+	telemetry_correlation_series() = default;
+	explicit telemetry_correlation_series(const std::vector<double> &values);
+
+	size_t size() const { return m_values.values.size(); }
+	bool is_constant() const { return m_constant; }
+
+	friend telemetry_correlation correlate_telemetry_series(const telemetry_correlation_series &a, const telemetry_correlation_series &b, size_t max_lag);
+
+private:
+	struct column
+	{
+		column() = default;
+		explicit column(const std::vector<double> &values);
+
+		std::vector<double> values; // Centered around their mean, which keeps the sums below well conditioned
+		std::vector<double> sums; // Prefix sums, sums[i] covers [0, i)
+		std::vector<double> squares;
+	};
+
+	static double correlate_at_lag(const column &a, const column &b, int64_t lag); // Pearson correlation of a[i] and b[i + lag] over their overlap
+
+	column m_values;
+	column m_ranks; // Ties share their average rank
+	bool m_constant = true;
+};
+
+// Correlations are NaN where one of the series doesn't vary over the overlap. max_lag is clamped to half the series, so that every lag is
+// backed by at least half of the samples. Will throw std::invalid_argument() if the series have different sizes
+telemetry_correlation correlate_telemetry_series(const telemetry_correlation_series &a, const telemetry_correlation_series &b, size_t max_lag);
+
+#endif //TELEMETRY_CORRELATION_H
@@ -20,10 +20,38 @@
 #define TELEMETRY_DATA_H
 
 #include <cstdint>
+#include <compare>
+#include <optional>
 #include <string>
 #include <stdexcept>
 #include <type_traits>
 
+// Timestamps are stored as integer microseconds, which makes comparisons exact and allows for sub-second ranges.
+// The file format and the UI deal in floating point seconds, use from_seconds() and to_seconds() to convert between the two
+struct telemetry_time
+{
+	static constexpr int64_t ticks_per_second = 1000000;
+
+	constexpr telemetry_time() = default;
+	constexpr explicit telemetry_time(int64_t ticks) :
+		ticks(ticks)
+	{}
+
+	static constexpr telemetry_time from_seconds(double seconds) { return telemetry_time(int64_t(seconds * ticks_per_second + (seconds < 0.0 ? -0.5 : 0.5))); }
+	constexpr double to_seconds() const { return double(ticks) / ticks_per_second; }
+
+	constexpr auto operator <=>(const telemetry_time &) const = default;
+
+	constexpr telemetry_time operator +(telemetry_time other) const { return telemetry_time(ticks + other.ticks); }
+	constexpr telemetry_time operator -(telemetry_time other) const { return telemetry_time(ticks - other.ticks); }
+	constexpr telemetry_time operator -() const { return telemetry_time(-ticks); }
+
+	constexpr telemetry_time &operator +=(telemetry_time other) { ticks += other.ticks; return *this; }
+	constexpr telemetry_time &operator -=(telemetry_time other) { ticks -= other.ticks; return *this; }
+
+	int64_t ticks = 0;
+};
+
 enum class telemetry_type : uint8_t
 {
 	uint8 = 0,
@@ -55,6 +83,72 @@ enum class telemetry_unit : uint8_t
 	duration = 4
 };
 
+// Calls function with a std::integral_constant<telemetry_type, type>, so that kernels can resolve the type of a field once and then read
+// every value with telemetry_data_value::get_as() instead of switching on the type per sample. Will throw std::invalid_argument() for unknown types
+template<class F>
+decltype(auto) visit_telemetry_type(telemetry_type type, F &&function)
+{
+	switch(type)
+	{
+		case telemetry_type::uint8:
+			return function(std::integral_constant<telemetry_type, telemetry_type::uint8>());
+		case telemetry_type::uint16:
+			return function(std::integral_constant<telemetry_type, telemetry_type::uint16>());
+		case telemetry_type::uint32:
+			return function(std::integral_constant<telemetry_type, telemetry_type::uint32>());
+		case telemetry_type::int32:
+			return function(std::integral_constant<telemetry_type, telemetry_type::int32>());
+		case telemetry_type::uint64:
+			return function(std::integral_constant<telemetry_type, telemetry_type::uint64>());
+		case telemetry_type::int64:
+			return function(std::integral_constant<telemetry_type, telemetry_type::int64>());
+		case telemetry_type::f64:
+			return function(std::integral_constant<telemetry_type, telemetry_type::f64>());
+		case telemetry_type::f32:
+			return function(std::integral_constant<telemetry_type, telemetry_type::f32>());
+		case telemetry_type::string:
+			return function(std::integral_constant<telemetry_type, telemetry_type::string>());
+		case telemetry_type::boolean:
+			return function(std::integral_constant<telemetry_type, telemetry_type::boolean>());
+		case telemetry_type::vec2:
+			return function(std::integral_constant<telemetry_type, telemetry_type::vec2>());
+		case telemetry_type::dvec2:
+			return function(std::integral_constant<telemetry_type, telemetry_type::dvec2>());
+	}
+
+	throw std::invalid_argument("Unknown telemetry type");
+}
+
+// Whether telemetry_data_value::get<T>() can read a value of the given type
+template<class T>
+constexpr bool is_telemetry_type_convertible(telemetry_type type)
+{
+	if constexpr (std::is_arithmetic<T>::value)
+	{
+		switch(type)
+		{
+			case telemetry_type::boolean:
+			case telemetry_type::uint8:
+			case telemetry_type::uint16:
+			case telemetry_type::uint32:
+			case telemetry_type::uint64:
+			case telemetry_type::int32:
+			case telemetry_type::int64:
+			case telemetry_type::f32:
+			case telemetry_type::f64:
+				return true;
+
+			default:
+				return false;
+		}
+	}
+
+	if constexpr (std::is_same<T, std::string>::value || std::is_same<T, const char *>::value)
+		return (type == telemetry_type::string);
+
+	return false;
+}
+
 struct telemetry_data_value
 {
 	union
@@ -79,123 +173,75 @@ struct telemetry_data_value
 	std::string string;
 	telemetry_type type;
 
+	// Reads the value as if it was of type Type, without looking at type
+	template<class T, telemetry_type Type>
+	T get_as() const
+	{
+		static_assert(is_telemetry_type_convertible<T>(Type), "Unsupported type conversion");
+
+		if constexpr (Type == telemetry_type::boolean)
+			return static_cast<T>(b);
+		else if constexpr (Type == telemetry_type::uint8)
+			return static_cast<T>(u8);
+		else if constexpr (Type == telemetry_type::uint16)
+			return static_cast<T>(u16);
+		else if constexpr (Type == telemetry_type::uint32)
+			return static_cast<T>(u32);
+		else if constexpr (Type == telemetry_type::uint64)
+			return static_cast<T>(u64);
+		else if constexpr (Type == telemetry_type::int32)
+			return static_cast<T>(i32);
+		else if constexpr (Type == telemetry_type::int64)
+			return static_cast<T>(i64);
+		else if constexpr (Type == telemetry_type::f32)
+			return static_cast<T>(this->f32);
+		else if constexpr (Type == telemetry_type::f64)
+			return static_cast<T>(this->f64);
+		else if constexpr (std::is_same<T, std::string>::value)
+			return this->string;
+		else
+			return this->string.c_str();
+	}
+
 	template<class T>
-	T get() const
+	std::optional<T> try_get() const
 	{
-		if constexpr (std::is_integral<T>::value || std::is_floating_point<T>::value)
-		{
-			switch(type)
-			{
-				using enum telemetry_type;
-
-				case boolean:
-					return static_cast<T>(b);
-
-				case uint8:
-					return static_cast<T>(u8);
-				case uint16:
-					return static_cast<T>(u16);
-				case uint32:
-					return static_cast<T>(u32);
-				case uint64:
-					return static_cast<T>(u64);
-
-				case int32:
-					return static_cast<T>(i32);
-				case int64:
-					return static_cast<T>(i64);
-
-				case f32:
-					return static_cast<T>(this->f32);
-				case f64:
-					return static_cast<T>(this->f64);
-
-				default:
-					break;
-			}
-		}
+		if(!can_convert_to<T>())
+			return std::nullopt;
 
-		if constexpr (std::is_same<T, bool>::value)
-		{
-			switch(type)
-			{
-				using enum telemetry_type;
-
-				case boolean:
-					return b;
-
-				case uint8:
-					return u8;
-				case uint16:
-					return u16;
-				case uint32:
-					return u32;
-				case uint64:
-					return u64;
-
-				case int32:
-					return i32;
-				case int64:
-					return i64;
-
-				case f32:
-					return this->f32;
-				case f64:
-					return this->f64;
-
-				default:
-					break;
-			}
-		}
+		return visit_telemetry_type(type, [this](auto tag) -> std::optional<T> {
 
-		if constexpr (std::is_same<T, std::string>::value)
-		{
-			switch(type)
-			{
-				using enum telemetry_type;
+			constexpr telemetry_type Type = decltype(tag)::value;
 
-				case string:
-					return this->string;
+			if constexpr (is_telemetry_type_convertible<T>(Type))
+				return get_as<T, Type>();
+			else
+				return std::nullopt;
 
-				default:
-					break;
-			}
-		}
-		if constexpr (std::is_same<T, const char *>::value)
-		{
-			switch(type)
-			{
-				using enum telemetry_type;
+		});
+	}
 
-				case string:
-					return this->string.c_str();
+	template<class T>
+	T get() const
+	{
+		std::optional<T> result = try_get<T>();
 
-				default:
-					break;
-			}
-		}
+		if(!result)
+			throw std::runtime_error("Unsupported type conversion");
 
-		throw std::runtime_error("Unsupported type conversion");
+		return *result;
 	}
 
 	template<class T>
 	bool can_convert_to() const
 	{
-		try
-		{
-			get<T>();
-			return true;
-		}
-		catch(...)
-		{
-			return false;
-		}
+		return is_telemetry_type_convertible<T>(type);
 	}
 };
 
 struct telemetry_data_point
 {
-	double timestamp;
+	telemetry_time timestamp;
 	telemetry_data_value value;
 };
 
@@ -0,0 +1,430 @@
+//
+//  expression.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include "expression.h"
+
+static constexpr size_t expression_block_size = 512;
+static constexpr size_t expression_max_nesting = 256; // Parentheses, function calls and unary operators, the parser recurses for each of them
+
+class telemetry_expression::parser
+{
+public:
+	parser(telemetry_expression &expression) :
+		m_expression(expression),
+		m_source(expression.m_source)
+	{}
+
+	void parse()
+	{
+		parse_expression();
+		skip_whitespace();
+
+		if(m_position < m_source.size())
+			fail("Unexpected '" + std::string(1, m_source[m_position]) + "'");
+		if(m_expression.m_references.empty())
+			throw std::invalid_argument("Expression doesn't reference any fields");
+	}
+
+private:
+	[[noreturn]] void fail(const std::string &message) const
+	{
+		throw std::invalid_argument(message + " at position " + std::to_string(m_position + 1));
+	}
+
+	void enter_nesting()
+	{
+		if((++ m_nesting) > expression_max_nesting)
+			fail("Expression is nested too deeply");
+	}
+
+	void skip_whitespace()
+	{
+		while(m_position < m_source.size() && std::isspace((unsigned char)m_source[m_position]))
+			m_position ++;
+	}
+
+	bool consume(char character)
+	{
+		skip_whitespace();
+
+		if(m_position < m_source.size() && m_source[m_position] == character)
+		{
+			m_position ++;
+			return true;
+		}
+
+		return false;
+	}
+
+	void emit(opcode op, int stack_change, uint32_t operand = 0, double constant = 0.0)
+	{
+		m_expression.m_instructions.push_back({ op, operand, constant });
+
+		m_depth += stack_change;
+		m_expression.m_stack_depth = std::max(m_expression.m_stack_depth, m_depth);
+
+		if(op == opcode::multiply || op == opcode::divide || op == opcode::sqrt)
+			m_expression.m_additive = false;
+	}
+
+	void parse_expression()
+	{
+		parse_term();
+
+		while(true)
+		{
+			if(consume('+'))
+			{
+				parse_term();
+				emit(opcode::add, -1);
+			}
+			else if(consume('-'))
+			{
+				parse_term();
+				emit(opcode::subtract, -1);
+			}
+			else
+				break;
+		}
+	}
+
+	void parse_term()
+	{
+		parse_unary();
+
+		while(true)
+		{
+			if(consume('*'))
+			{
+				parse_unary();
+				emit(opcode::multiply, -1);
+			}
+			else if(consume('/'))
+			{
+				parse_unary();
+				emit(opcode::divide, -1);
+			}
+			else
+				break;
+		}
+	}
+
+	void parse_unary()
+	{
+		if(consume('-'))
+		{
+			enter_nesting();
+			parse_unary();
+			emit(opcode::negate, 0);
+			m_nesting --;
+		}
+		else
+		{
+			consume('+');
+			parse_primary();
+		}
+	}
+
+	void parse_primary()
+	{
+		skip_whitespace();
+
+		if(m_position >= m_source.size())
+			fail("Unexpected end of expression");
+
+		const char character = m_source[m_position];
+
+		if(consume('('))
+		{
+			enter_nesting();
+			parse_expression();
+
+			if(!consume(')'))
+				fail("Expected ')'");
+
+			m_nesting --;
+			return;
+		}
+
+		if(std::isdigit((unsigned char)character) || character == '.')
+		{
+			const char *begin = m_source.c_str() + m_position;
+			char *end = nullptr;
+
+			const double value = std::strtod(begin, &end);
+
+			if(end == begin)
+				fail("Invalid number");
+
+			m_position += end - begin;
+			emit(opcode::constant, 1, 0, value);
+
+			return;
+		}
+
+		if(std::isalpha((unsigned char)character) || character == '_')
+		{
+			const size_t start = m_position;
+
+			while(m_position < m_source.size() && (std::isalnum((unsigned char)m_source[m_position]) || m_source[m_position] == '_'))
+				m_position ++;
+
+			const std::string name = m_source.substr(start, m_position - start);
+
+			if(consume('('))
+			{
+				parse_function(name, start);
+				return;
+			}
+
+			parse_reference(name);
+			return;
+		}
+
+		fail("Unexpected '" + std::string(1, character) + "'");
+	}
+
+	void parse_function(const std::string &name, size_t start)
+	{
+		struct function
+		{
+			const char *name;
+			opcode op;
+			int arguments;
+		};
+
+		static const function functions[] = {
+			{ "abs", opcode::abs, 1 },
+			{ "sqrt", opcode::sqrt, 1 },
+			{ "delta", opcode::delta, 1 },
+			{ "min", opcode::min, 2 },
+			{ "max", opcode::max, 2 }
+		};
+
+		const auto iterator = std::find_if(std::begin(functions), std::end(functions), [&](const function &function) {
+			return name == function.name;
+		});
+
+		if(iterator == std::end(functions))
+		{
+			m_position = start;
+			fail("Unknown function '" + name + "'");
+		}
+
+		enter_nesting();
+
+		for(int i = 0; i < iterator->arguments; ++ i)
+		{
+			if(i > 0 && !consume(','))
+				fail("Expected ','");
+
+			parse_expression();
+		}
+
+		if(!consume(')'))
+			fail("Expected ')'");
+
+		emit(iterator->op, 1 - iterator->arguments);
+		m_nesting --;
+	}
+
+	void parse_reference(const std::string &name)
+	{
+		telemetry_expression_reference reference;
+		reference.name = normalize_name(name);
+
+		if(consume('@'))
+		{
+			skip_whitespace();
+
+			const size_t start = m_position;
+
+			while(m_position < m_source.size() && std::isdigit((unsigned char)m_source[m_position]))
+				m_position ++;
+
+			if(m_position == start)
+				fail("Expected a document number");
+
+			const char *begin = m_source.data() + start;
+			const char *end = m_source.data() + m_position;
+
+			if(std::from_chars(begin, end, reference.document).ec != std::errc())
+			{
+				m_position = start;
+				fail("Document number is out of range");
+			}
+		}
+
+		auto &references = m_expression.m_references;
+		const auto iterator = std::find(references.begin(), references.end(), reference);
+
+		const uint32_t index = uint32_t(iterator - references.begin());
+
+		if(iterator == references.end())
+			references.push_back(std::move(reference));
+
+		emit(opcode::column, 1, index);
+	}
+
+	telemetry_expression &m_expression;
+	const std::string &m_source;
+
+	size_t m_position = 0;
+	size_t m_depth = 0;
+	size_t m_nesting = 0;
+};
+
+telemetry_expression::telemetry_expression(const std::string &source) :
+	m_source(source)
+{
+	parser(*this).parse();
+}
+
+std::vector<double> telemetry_expression::evaluate(const std::vector<const double *> &columns, size_t count) const
+{
+	if(columns.size() != m_references.size())
+		throw std::invalid_argument("Expected a column for every reference");
+
+	std::vector<double> result(count);
+
+	// One block sized slot per stack entry, plus the previous value of every delta instruction carried over from the last block
+	std::vector<double> stack(m_stack_depth * expression_block_size);
+	std::vector<double> carry(m_instructions.size(), std::numeric_limits<double>::quiet_NaN());
+
+	for(size_t begin = 0; begin < count; begin += expression_block_size)
+	{
+		const size_t size = std::min(expression_block_size, count - begin);
+		size_t top = 0;
+
+		for(size_t i = 0; i < m_instructions.size(); ++ i)
+		{
+			const instruction &instruction = m_instructions[i];
+
+			// Binary instructions combine the two topmost slots into the lower one, unary ones work on the topmost slot in place
+			const bool binary = (instruction.op >= opcode::add && instruction.op <= opcode::divide) || instruction.op == opcode::min || instruction.op == opcode::max;
+
+			double *lhs = (top >= 1) ? stack.data() + (top - (binary ? 2 : 1)) * expression_block_size : nullptr;
+			const double *rhs = binary ? lhs + expression_block_size : nullptr;
+
+			switch(instruction.op)
+			{
+				case opcode::constant:
+					std::fill_n(stack.data() + (top ++) * expression_block_size, size, instruction.constant);
+					break;
+				case opcode::column:
+					std::copy_n(columns[instruction.operand] + begin, size, stack.data() + (top ++) * expression_block_size);
+					break;
+
+				case opcode::add:
+					for(size_t j = 0; j < size; ++ j)
+						lhs[j] += rhs[j];
+
+					top --;
+					break;
+				case opcode::subtract:
+					for(size_t j = 0; j < size; ++ j)
+						lhs[j] -= rhs[j];
+
+					top --;
+					break;
+				case opcode::multiply:
+					for(size_t j = 0; j < size; ++ j)
+						lhs[j] *= rhs[j];
+
+					top --;
+					break;
+				case opcode::divide:
+					for(size_t j = 0; j < size; ++ j)
+						lhs[j] = (rhs[j] != 0.0) ? lhs[j] / rhs[j] : std::numeric_limits<double>::quiet_NaN();
+
+					top --;
+					break;
+				case opcode::min:
+					for(size_t j = 0; j < size; ++ j)
+						lhs[j] = std::min(lhs[j], rhs[j]);
+
+					top --;
+					break;
+				case opcode::max:
+					for(size_t j = 0; j < size; ++ j)
+						lhs[j] = std::max(lhs[j], rhs[j]);
+
+					top --;
+					break;
+
+				case opcode::negate:
+					for(size_t j = 0; j < size; ++ j)
+						lhs[j] = -lhs[j];
+					break;
+				case opcode::abs:
+					for(size_t j = 0; j < size; ++ j)
+						lhs[j] = std::abs(lhs[j]);
+					break;
+				case opcode::sqrt:
+					for(size_t j = 0; j < size; ++ j)
+						lhs[j] = std::sqrt(lhs[j]);
+					break;
+				case opcode::delta:
+				{
+					double previous = carry[i];
+
+					for(size_t j = 0; j < size; ++ j)
+					{
+						const double value = lhs[j];
+
+						lhs[j] = value - previous;
+						previous = value;
+					}
+
+					carry[i] = previous;
+					break;
+				}
+			}
+		}
+
+		std::copy_n(stack.data(), size, result.data() + begin);
+	}
+
+	return result;
+}
+
+std::string telemetry_expression::normalize_name(const std::string &title)
+{
+	std::string result;
+	result.reserve(title.size());
+
+	for(char character : title)
+	{
+		if(std::isalnum((unsigned char)character))
+			result.push_back(char(std::tolower((unsigned char)character)));
+		else if(!result.empty() && result.back() != '_')
+			result.push_back('_');
+	}
+
+	while(!result.empty() && result.back() == '_')
+		result.pop_back();
+
+	return result;
+}
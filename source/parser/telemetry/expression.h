@@ -0,0 +1,93 @@
+//
+//  expression.h
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef TELEMETRY_EXPRESSION_H
+#define TELEMETRY_EXPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A field an expression refers to, by its normalized title. Document 0 is the document the expression is evaluated for, anything else
+// is the 1 based index of a loaded document
+struct telemetry_expression_reference
+{
+	std::string name;
+	uint32_t document = 0;
+
+	bool operator ==(const telemetry_expression_reference &other) const = default;
+};
+
+// Arithmetic over fields, like "cpu + gpu", "1 / time" or "fps / fps@1". Supports + - * /, parentheses, unary minus and the functions
+// abs(), sqrt(), min(), max() and delta(), which is the difference to the previous sample.
+// The source is compiled into a postfix plan once, which is then run over blocks of the input columns so that every instruction is a
+// tight loop over a block that stays in cache
+class telemetry_expression
+{
+public:
+	telemetry_expression() = default;
+	explicit telemetry_expression(const std::string &source); // Will throw std::invalid_argument() with the position of syntax errors, or if it's nested too deeply
+
+	const std::string &get_source() const { return m_source; }
+	const std::vector<telemetry_expression_reference> &get_references() const { return m_references; }
+
+	// True if the result has the same unit as the fields, ie. only sums, differences and the like of them
+	bool is_additive() const { return m_additive; }
+
+	// Columns are in the order of get_references() and all hold count values sampled at the same points in time. Division by zero and
+	// the first delta produce NaN
+	std::vector<double> evaluate(const std::vector<const double *> &columns, size_t count) const;
+
+	// Lower case with everything that isn't a letter or digit turned into a single underscore, so "Cloud Update (GPU)" is cloud_update_gpu
+	static std::string normalize_name(const std::string &title);
+
+private:
+	enum class opcode : uint8_t
+	{
+		constant,
+		column,
+		add,
+		subtract,
+		multiply,
+		divide,
+		negate,
+		abs,
+		sqrt,
+		min,
+		max,
+		delta
+	};
+
+	struct instruction
+	{
+		opcode op;
+		uint32_t operand = 0; // Column index
+		double constant = 0.0;
+	};
+
+	class parser;
+
+	std::string m_source;
+	std::vector<instruction> m_instructions;
+	std::vector<telemetry_expression_reference> m_references;
+	size_t m_stack_depth = 0;
+	bool m_additive = true;
+};
+
+#endif //TELEMETRY_EXPRESSION_H
@@ -0,0 +1,229 @@
+//
+//  histogram.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include "histogram.h"
+
+uint32_t telemetry_histogram::get_bin_index(double value)
+{
+	// Also catches NaN
+	if(!(value >= std::ldexp(1.0, min_exponent)))
+		return 0;
+
+	int exponent;
+	const double mantissa = std::frexp(value, &exponent) * 2.0; // [1, 2)
+
+	exponent --;
+
+	if(exponent >= max_exponent)
+		return bin_count - 1;
+
+	const uint32_t sub_bin = std::min(uint32_t((mantissa - 1.0) * sub_bins), sub_bins - 1);
+
+	return 1 + uint32_t(exponent - min_exponent) * sub_bins + sub_bin;
+}
+
+double telemetry_histogram::get_bin_lower_bound(uint32_t index)
+{
+	if(index == 0)
+		return 0.0;
+
+	index --;
+
+	const int32_t exponent = min_exponent + int32_t(index / sub_bins);
+	const uint32_t sub_bin = index % sub_bins;
+
+	return std::ldexp(1.0 + double(sub_bin) / sub_bins, exponent);
+}
+
+double telemetry_histogram::get_bin_upper_bound(uint32_t index)
+{
+	if(index + 1 >= bin_count)
+		return std::ldexp(1.0, max_exponent);
+
+	return get_bin_lower_bound(index + 1);
+}
+
+void telemetry_histogram::add(double value)
+{
+	const uint32_t index = get_bin_index(value);
+
+	auto iterator = std::lower_bound(m_bins.begin(), m_bins.end(), index, [](const telemetry_histogram_bin &bin, uint32_t index) {
+		return bin.index < index;
+	});
+
+	if(iterator == m_bins.end() || iterator->index != index)
+		iterator = m_bins.insert(iterator, { index, 0, 0.0 });
+
+	iterator->count ++;
+	iterator->sum += value;
+
+	m_minimum = (m_count == 0) ? value : std::min(m_minimum, value);
+	m_maximum = (m_count == 0) ? value : std::max(m_maximum, value);
+
+	m_count ++;
+	m_sum += value;
+}
+
+void telemetry_histogram::merge(const telemetry_histogram &other)
+{
+	if(other.empty())
+		return;
+
+	if(empty())
+	{
+		*this = other;
+		return;
+	}
+
+	std::vector<telemetry_histogram_bin> bins;
+	bins.reserve(m_bins.size() + other.m_bins.size());
+
+	auto lhs = m_bins.begin();
+	auto rhs = other.m_bins.begin();
+
+	while(lhs != m_bins.end() || rhs != other.m_bins.end())
+	{
+		if(rhs == other.m_bins.end() || (lhs != m_bins.end() && lhs->index < rhs->index))
+			bins.push_back(*lhs ++);
+		else if(lhs == m_bins.end() || rhs->index < lhs->index)
+			bins.push_back(*rhs ++);
+		else
+		{
+			bins.push_back({ lhs->index, lhs->count + rhs->count, lhs->sum + rhs->sum });
+
+			++ lhs;
+			++ rhs;
+		}
+	}
+
+	m_bins = std::move(bins);
+
+	m_minimum = std::min(m_minimum, other.m_minimum);
+	m_maximum = std::max(m_maximum, other.m_maximum);
+
+	m_count += other.m_count;
+	m_sum += other.m_sum;
+}
+
+double telemetry_histogram::get_bin_value(const telemetry_histogram_bin &bin) const
+{
+	return std::clamp(bin.sum / bin.count, m_minimum, m_maximum);
+}
+
+double telemetry_histogram::get_percentile(double percentile) const
+{
+	if(empty())
+		return 0.0;
+
+	const double needle = percentile * m_count;
+	uint64_t count = 0;
+
+	for(auto &bin : m_bins)
+	{
+		count += bin.count;
+
+		if(count >= needle)
+			return get_bin_value(bin);
+	}
+
+	return m_maximum;
+}
+
+double telemetry_histogram::get_weighted_percentile(double percentile) const
+{
+	if(empty())
+		return 0.0;
+
+	const double needle = percentile * m_sum;
+	double sum = 0.0;
+
+	for(auto &bin : m_bins)
+	{
+		sum += bin.sum;
+
+		if(sum >= needle)
+			return get_bin_value(bin);
+	}
+
+	return m_maximum;
+}
+
+size_t telemetry_histogram::get_memory_usage() const
+{
+	return sizeof(telemetry_histogram) + m_bins.capacity() * sizeof(telemetry_histogram_bin);
+}
+
+
+int64_t telemetry_histogram_series::get_bucket(telemetry_time time) const
+{
+	const int64_t ticks = (time - m_start).ticks;
+	const int64_t duration = bucket_duration.ticks;
+
+	// Rounds towards negative infinity for times before the first bucket
+	return (ticks >= 0) ? (ticks / duration) : -((-ticks + duration - 1) / duration);
+}
+
+void telemetry_histogram_series::add(telemetry_time timestamp, double value)
+{
+	if(m_buckets.empty())
+		m_start = telemetry_time(timestamp.ticks - (((timestamp.ticks % bucket_duration.ticks) + bucket_duration.ticks) % bucket_duration.ticks));
+
+	int64_t bucket = get_bucket(timestamp);
+
+	// Data points come in order, so this only happens if they are added out of order
+	if(bucket < 0)
+	{
+		m_buckets.insert(m_buckets.begin(), size_t(-bucket), telemetry_histogram());
+		m_start -= telemetry_time(-bucket * bucket_duration.ticks);
+
+		bucket = 0;
+	}
+
+	if(size_t(bucket) >= m_buckets.size())
+		m_buckets.resize(size_t(bucket) + 1);
+
+	m_buckets[size_t(bucket)].add(value);
+}
+
+telemetry_histogram telemetry_histogram_series::get_histogram(telemetry_time start, telemetry_time end) const
+{
+	telemetry_histogram result;
+
+	if(m_buckets.empty() || end < start)
+		return result;
+
+	const int64_t first = std::max<int64_t>(get_bucket(start), 0);
+	const int64_t last = std::min<int64_t>(get_bucket(end), int64_t(m_buckets.size()) - 1);
+
+	for(int64_t i = first; i <= last; ++ i)
+		result.merge(m_buckets[size_t(i)]);
+
+	return result;
+}
+
+size_t telemetry_histogram_series::get_memory_usage() const
+{
+	size_t result = m_buckets.capacity() * sizeof(telemetry_histogram);
+
+	for(auto &bucket : m_buckets)
+		result += bucket.get_memory_usage() - sizeof(telemetry_histogram);
+
+	return result;
+}
@@ -0,0 +1,100 @@
+//
+//  histogram.h
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef TELEMETRY_HISTOGRAM_H
+#define TELEMETRY_HISTOGRAM_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "data.h"
+
+struct telemetry_histogram_bin
+{
+	uint32_t index;
+	uint32_t count; // Kept small, since every second of every field stores its own bins
+	double sum; // Of the values that fell into the bin
+};
+
+// HDR style histogram of positive values. Every power of two between 2^min_exponent and 2^max_exponent is split into sub_bins linear bins,
+// so a bin is never wider than 1/sub_bins of the values in it, no matter whether they are frame times in seconds or frame rates.
+// Smaller values, zero and negative values share the first bin, larger values the last one. Only non-empty bins are stored, and since
+// histograms merge by adding up their bins, histograms of parts can be combined into the histogram of the whole
+class telemetry_histogram
+{
+public:
+	static constexpr int32_t min_exponent = -24;
+	static constexpr int32_t max_exponent = 24;
+	static constexpr uint32_t sub_bins = 32;
+	static constexpr uint32_t bin_count = uint32_t(max_exponent - min_exponent) * sub_bins + 1;
+
+	static uint32_t get_bin_index(double value);
+	static double get_bin_lower_bound(uint32_t index);
+	static double get_bin_upper_bound(uint32_t index);
+
+	void add(double value);
+	void merge(const telemetry_histogram &other);
+
+	bool empty() const { return m_count == 0; }
+	uint64_t get_count() const { return m_count; }
+	double get_sum() const { return m_sum; }
+	double get_minimum() const { return m_minimum; } // Exact, not rounded to a bin
+	double get_maximum() const { return m_maximum; }
+
+	const std::vector<telemetry_histogram_bin> &get_bins() const { return m_bins; } // Sorted by index
+
+	// Percentiles walk the bins once and report the average of the bin they end up in. get_percentile() counts samples,
+	// get_weighted_percentile() weighs them by their value the same way summarize_telemetry_values() does. Both return 0.0 if empty
+	double get_percentile(double percentile) const;
+	double get_weighted_percentile(double percentile) const;
+
+	size_t get_memory_usage() const;
+
+private:
+	double get_bin_value(const telemetry_histogram_bin &bin) const;
+
+	std::vector<telemetry_histogram_bin> m_bins;
+
+	uint64_t m_count = 0;
+	double m_sum = 0.0;
+	double m_minimum = 0.0;
+	double m_maximum = 0.0;
+};
+
+// Histograms of a field's values for every second of the recording. The histogram of a time range is the sum of the seconds it overlaps,
+// which only depends on the number of seconds and never has to look at the samples again
+class telemetry_histogram_series
+{
+public:
+	static constexpr telemetry_time bucket_duration = telemetry_time(telemetry_time::ticks_per_second);
+
+	void add(telemetry_time timestamp, double value);
+
+	bool empty() const { return m_buckets.empty(); }
+	telemetry_histogram get_histogram(telemetry_time start, telemetry_time end) const; // Covers every second that overlaps [start, end]
+
+	size_t get_memory_usage() const;
+
+private:
+	int64_t get_bucket(telemetry_time time) const;
+
+	telemetry_time m_start; // Of the first bucket
+	std::vector<telemetry_histogram> m_buckets;
+};
+
+#endif //TELEMETRY_HISTOGRAM_H
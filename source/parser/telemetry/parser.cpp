@@ -16,235 +16,46 @@
 //  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //
 
-#include <cmath>
+#include <bitset>
 #include <stdexcept>
 #include <unordered_map>
 #include <algorithm>
 #include "parser.h"
+#include "columnar.h"
+#include "stream.h"
 
-struct file_reader
+void telemetry_field_selection::add_provider(const std::string &identifier)
 {
-	file_reader(const uint8_t *data, size_t size) :
-		m_data(data),
-		m_start(data),
-		m_end(data + size)
-	{}
-
-	file_reader(const uint8_t *data, size_t offset, size_t size) :
-		m_data(data + offset),
-		m_start(data),
-		m_end(data + size)
-	{}
-
-	size_t get_read() const { return m_data - m_start; }
-	size_t get_remaining() const { return m_end - m_data; }
-
-	bool at_end() const { return m_data >= m_end; }
-
-	void skip(size_t bytes)
-	{
-		m_data += bytes;
-	}
-
-
-	bool read_bool()
-	{
-		return *m_data ++;
-	}
-
-	uint8_t read_uint8()
-	{
-		return *m_data ++;
-	}
-
-	uint16_t read_uint16()
-	{
-		uint16_t data[2];
-
-		data[0] = *m_data ++;
-		data[1] = *m_data ++;
-
-		return (data[1] << 8) | data[0];
-	}
-	int16_t read_int16()
-	{
-		int16_t data[2];
-
-		data[0] = *m_data ++;
-		data[1] = *m_data ++;
-
-		return (data[1] << 8) | data[0];
-	}
-
-	uint32_t read_uint32()
-	{
-		uint32_t data[4];
-
-		for(int i = 0; i < 4; i++)
-			data[i] = *m_data ++;
-
-		return (data[3] << 24) | (data[2] << 16) | (data[1] << 8) | data[0];
-	}
-	int32_t read_int32()
-	{
-		int32_t data[4];
-
-		for(int i = 0; i < 4; i++)
-			data[i] = *m_data ++;
-
-		return (data[3] << 24) | (data[2] << 16) | (data[1] << 8) | data[0];
-	}
-
-	uint64_t read_uint64()
-	{
-		uint64_t data[8];
-
-		for(int i = 0; i < 8; i++)
-			data[i] = *m_data ++;
-
-		return (data[7] << 56) | (data[6] << 48) | (data[5] << 40) | (data[4] << 32) | (data[3] << 24) | (data[2] << 16) | (data[1] << 8) | data[0];
-	}
-	int64_t read_int64()
-	{
-		int64_t data[8];
-
-		for(int i = 0; i < 8; i++)
-			data[i] = *m_data ++;
-
-		return (data[7] << 56) | (data[6] << 48) | (data[5] << 40) | (data[4] << 32) | (data[3] << 24) | (data[2] << 16) | (data[1] << 8) | data[0];
-	}
-
-	float read_float()
-	{
-		union
-		{
-			uint8_t ival[4];
-			float fval;
-		} map;
-
-		for(int i = 0; i < 4; i++)
-			map.ival[i] = *m_data ++;
-
-		if(std::isinf(map.fval) || std::isnan(map.fval))
-			return 0.0f;
-
-		return map.fval;
-	}
-
-	double read_double()
-	{
-		union
-		{
-			uint8_t ival[8];
-			double fval;
-		} map;
-
-		for(int i = 0; i < 8; i++)
-			map.ival[i] = *m_data ++;
-
-		if(std::isinf(map.fval) || std::isnan(map.fval))
-			return 0.0f;
-
-		return map.fval;
-	}
-
-	std::string read_string()
-	{
-		const uint8_t length = *m_data ++;
-
-		std::string result(length, '\0');
-
-		for(uint8_t i = 0; i < length; i ++)
-			result[i] = *m_data ++;
-
-		return result;
-	}
-
-	telemetry_data_value read_value(telemetry_type type)
-	{
-		telemetry_data_value value;
-		value.type = type;
-
-		switch(type)
-		{
-			case telemetry_type::boolean:
-			{
-				value.b = read_bool();
-				break;
-			}
-
-			case telemetry_type::uint8:
-			{
-				value.u8 = read_uint8();
-				break;
-			}
-			case telemetry_type::uint16:
-			{
-				value.u16 = read_uint16();
-				break;
-			}
-			case telemetry_type::uint32:
-			{
-				value.u32 = read_uint32();
-				break;
-			}
-			case telemetry_type::uint64:
-			{
-				value.u64 = read_uint64();
-				break;
-			}
-
-
-			case telemetry_type::int32:
-			{
-				value.i32 = read_int32();
-				break;
-			}
-			case telemetry_type::int64:
-			{
-				value.i64 = read_int64();
-				break;
-			}
+	m_providers.insert(identifier);
+}
+void telemetry_field_selection::add_field(const std::string &identifier, uint8_t field)
+{
+	m_fields[identifier].insert(field);
+}
 
-			case telemetry_type::f32:
-			{
-				value.f32 = read_float();
-				break;
-			}
-			case telemetry_type::f64:
-			{
-				value.f64 = read_double();
-				break;
-			}
+bool telemetry_field_selection::contains_provider(const std::string &identifier) const
+{
+	return m_providers.contains(identifier) || m_fields.contains(identifier);
+}
+bool telemetry_field_selection::contains_field(const std::string &identifier, uint8_t field) const
+{
+	if(m_providers.contains(identifier))
+		return true;
 
-			case telemetry_type::vec2:
-			{
-				value.vec2[0] = read_float();
-				value.vec2[1] = read_float();
-				break;
-			}
-			case telemetry_type::dvec2:
-			{
-				value.dvec2[0] = read_double();
-				value.dvec2[1] = read_double();
-				break;
-			}
+	auto iterator = m_fields.find(identifier);
+	if(iterator == m_fields.end())
+		return false;
 
-			case telemetry_type::string:
-			{
-				value.string = read_string();
-				break;
-			}
-		}
+	return iterator->second.contains(field);
+}
 
-		return value;
-	}
+static bool is_field_selected(const telemetry_parser_options &options, const telemetry_provider &provider, const telemetry_field &field)
+{
+	if(!options.field_selection.has_value())
+		return true;
 
-private:
-	const uint8_t *m_data;
-	const uint8_t *m_start;
-	const uint8_t *m_end;
-};
+	return options.field_selection->contains_field(provider.get_identifier(), field.get_id());
+}
 
 
 
@@ -273,13 +84,62 @@ struct telemetry_event_temporary
 	std::vector<telemetry_event_entry> entries;
 };
 
+static bool is_before_time_range(const telemetry_parser_options &options, telemetry_time timestamp)
+{
+	return options.time_range && timestamp < options.time_range->start;
+}
+static bool is_after_time_range(const telemetry_parser_options &options, telemetry_time timestamp)
+{
+	return options.time_range && timestamp > options.time_range->end;
+}
+
+static void carry_over_value(telemetry_field &field, telemetry_data_value &&value, telemetry_time timestamp)
+{
+	const auto &data_points = field.get_data_points();
+
+	if(!data_points.empty() && data_points.front().timestamp <= timestamp)
+		return;
+
+	std::vector<telemetry_data_point> result;
+	result.reserve(data_points.size() + 1);
+
+	telemetry_data_point data_point;
+	data_point.timestamp = timestamp;
+	data_point.value = std::move(value);
+
+	result.push_back(std::move(data_point));
+	result.insert(result.end(), data_points.begin(), data_points.end());
+
+	field.set_data_points(std::move(result));
+}
+
+// The container range is always widened to full seconds
+static telemetry_time floor_to_second(telemetry_time time)
+{
+	int64_t seconds = time.ticks / telemetry_time::ticks_per_second;
+
+	if(time.ticks < 0 && (time.ticks % telemetry_time::ticks_per_second) != 0)
+		seconds -= 1;
+
+	return telemetry_time(seconds * telemetry_time::ticks_per_second);
+}
+static telemetry_time ceil_to_second(telemetry_time time)
+{
+	const telemetry_time floored = floor_to_second(time);
+
+	if(floored == time)
+		return time;
+
+	return floored + telemetry_time(telemetry_time::ticks_per_second);
+}
+
 void finalize_container(telemetry_container &container, const telemetry_parser_options &options)
 {
 	{
 		// Figure out the start and end time range
 
-		double start_time = 0.0;
-		double end_time = 0.0;
+		telemetry_time start_time = options.time_range ? options.time_range->start : telemetry_time();
+		telemetry_time end_time = start_time;
 
 		for(auto &provider : container.get_providers())
 		{
@@ -293,15 +153,27 @@ void finalize_container(telemetry_container &container, const telemetry_parser_o
 			}
 		}
 
-		container.set_start_time(std::floor(start_time));
-		container.set_end_time(std::ceil(end_time));
+		container.set_start_time(floor_to_second(start_time));
+		container.set_end_time(ceil_to_second(end_time));
+	}
+
+	if(options.build_histograms)
+	{
+		for(auto &provider : container.get_providers())
+		{
+			for(auto &field : provider.get_fields())
+			{
+				if(field.get_unit() == telemetry_unit::time || field.get_unit() == telemetry_unit::fps)
+					field.build_histograms();
+			}
+		}
 	}
 
 	if(options.data_point_processor)
 	{
 		// Run the data processor and do a final update of the start and end time, in case the processor nukes data points away
-		double start_time = 0.0;
-		double end_time = 0.0;
+		telemetry_time start_time = options.time_range ? options.time_range->start : telemetry_time();
+		telemetry_time end_time = start_time;
 
 		for(auto &provider : container.get_providers())
 		{
@@ -322,8 +194,22 @@ void finalize_container(telemetry_container &container, const telemetry_parser_o
 			}
 		}
 
-		container.set_start_time(std::floor(start_time));
-		container.set_end_time(std::ceil(end_time));
+		container.set_start_time(floor_to_second(start_time));
+		container.set_end_time(ceil_to_second(end_time));
+	}
+
+	if(options.compact_runs || options.compress_columns)
+	{
+		for(auto &provider : container.get_providers())
+		{
+			for(auto &field : provider.get_fields())
+			{
+				if(options.compact_runs)
+					field.compact();
+				if(options.compress_columns)
+					field.compress();
+			}
+		}
 	}
 }
 
@@ -332,6 +218,22 @@ telemetry_container parser_tlmv2_data(file_reader &reader, const telemetry_parse
 	telemetry_container container(2);
 
 	std::unordered_map<uint64_t, telemetry_event_temporary> events;
+	std::unordered_map<uint16_t, std::bitset<256>> selected_fields;
+	std::unordered_map<uint32_t, file_reader> carried_values; // Readers positioned at the last value of a field before the time range
+
+	auto update_selected_fields = [&](telemetry_provider &provider) {
+
+		std::bitset<256> &selection = selected_fields[provider.get_id()];
+
+		for(auto &field : provider.get_fields())
+		{
+			const bool selected = is_field_selected(options, provider, field);
+
+			field.set_loaded(selected);
+			selection.set(field.get_id(), selected);
+		}
+
+	};
 
 	auto get_event_data = [&](uint64_t id) -> telemetry_event_temporary & {
 
@@ -350,154 +252,208 @@ telemetry_container parser_tlmv2_data(file_reader &reader, const telemetry_parse
 
 	while(!reader.at_end())
 	{
-		telemetry_v2_command command = (telemetry_v2_command)reader.read_uint8();
-
-		switch(command)
+		// Commands are only ever appended, so a capture that was cut off mid-command is still good up to the last complete one
+		try
 		{
-			case telemetry_v2_command::register_provider:
-			{
-				const std::string identifier = reader.read_string();
-				const std::string title = reader.read_string();
-				const uint16_t version = reader.read_uint16();
-				const uint16_t id = reader.read_uint16();
-
-				telemetry_provider provider(id, version, identifier, title);
-
-				const uint32_t num_fields = reader.read_uint32();
-				for(uint32_t i = 0; i < num_fields; i ++)
-				{
-					const uint8_t id = reader.read_uint8();
-					const telemetry_type type = static_cast<telemetry_type>(reader.read_uint8());
-					const telemetry_unit unit = static_cast<telemetry_unit>(reader.read_uint8());
-					const std::string title = reader.read_string();
+			telemetry_v2_command command = (telemetry_v2_command)reader.read_uint8();
 
-					telemetry_field field(id, provider.get_id(), title, type, unit);
-					provider.add_field(std::move(field));
-				}
-
-				container.add_provider(std::move(provider));
-				break;
-			}
-
-			case telemetry_v2_command::amend_provider:
+			switch(command)
 			{
-				const uint16_t runtime_id = reader.read_uint16();
-				telemetry_provider &provider = container.get_provider(runtime_id);
-
-				const uint32_t fields = reader.read_uint32();
-
-				for(uint32_t i = 0; i < fields; ++ i)
+				case telemetry_v2_command::register_provider:
 				{
-					const uint8_t id = reader.read_uint8();
-					const telemetry_type type = static_cast<telemetry_type>(reader.read_uint8());
-					const telemetry_unit unit = static_cast<telemetry_unit>(reader.read_uint8());
+					const std::string identifier = reader.read_string();
 					const std::string title = reader.read_string();
+					const uint16_t version = reader.read_uint16();
+					const uint16_t id = reader.read_uint16();
+
+					telemetry_provider provider(id, version, identifier, title);
 
-					if(!provider.has_field(id))
+					const uint32_t num_fields = reader.read_uint32();
+					for(uint32_t i = 0; i < num_fields; i ++)
 					{
+						const uint8_t id = reader.read_uint8();
+						const telemetry_type type = static_cast<telemetry_type>(reader.read_uint8());
+						const telemetry_unit unit = static_cast<telemetry_unit>(reader.read_uint8());
+						const std::string title = reader.read_string();
+
 						telemetry_field field(id, provider.get_id(), title, type, unit);
 						provider.add_field(std::move(field));
 					}
+
+					update_selected_fields(provider);
+
+					container.add_provider(std::move(provider));
+					break;
 				}
 
-				break;
-			}
+				case telemetry_v2_command::amend_provider:
+				{
+					const uint16_t runtime_id = reader.read_uint16();
+					telemetry_provider &provider = container.get_provider(runtime_id);
 
-			case telemetry_v2_command::statistic:
-			{
-				const std::string title = reader.read_string();
+					const uint32_t fields = reader.read_uint32();
 
-				telemetry_statistic statistic(title);
+					for(uint32_t i = 0; i < fields; ++ i)
+					{
+						const uint8_t id = reader.read_uint8();
+						const telemetry_type type = static_cast<telemetry_type>(reader.read_uint8());
+						const telemetry_unit unit = static_cast<telemetry_unit>(reader.read_uint8());
+						const std::string title = reader.read_string();
+
+						if(!provider.has_field(id))
+						{
+							telemetry_field field(id, provider.get_id(), title, type, unit);
+							provider.add_field(std::move(field));
+						}
+					}
 
-				const size_t length = reader.read_uint32();
-				const size_t read_position = reader.get_read();
+					update_selected_fields(provider);
+					break;
+				}
 
-				while(reader.get_read() - read_position < length)
+				case telemetry_v2_command::statistic:
 				{
-					const telemetry_type type = static_cast<telemetry_type>(reader.read_uint8());
+					const std::string title = reader.read_string();
 
-					telemetry_statistic_entry entry;
-					entry.title = reader.read_string();
-					entry.value = reader.read_value(type);
+					telemetry_statistic statistic(title);
 
-					statistic.add_entry(std::move(entry));
-				}
+					const size_t length = reader.read_uint32();
+					const size_t read_position = reader.get_read();
 
-				container.add_statistic(std::move(statistic));
-				break;
-			}
-			case telemetry_v2_command::event:
-			{
-				const uint64_t id = reader.read_uint64();
-				const double timestamp = reader.read_double();
-				const telemetry_event_type event_type = static_cast<telemetry_event_type>(reader.read_uint8());
+					while(reader.get_read() - read_position < length)
+					{
+						const telemetry_type type = static_cast<telemetry_type>(reader.read_uint8());
 
-				auto &event = get_event_data(id);
+						telemetry_statistic_entry entry;
+						entry.title = reader.read_string();
+						entry.value = reader.read_value(type);
 
-				switch(event_type)
-				{
-					case telemetry_event_type::begin:
-						event.start_time = timestamp;
-						break;
-					case telemetry_event_type::end:
-						event.end_time = timestamp;
-						break;
-				}
-
-				const size_t length = reader.read_uint32();
-				const size_t read_position = reader.get_read();
+						statistic.add_entry(std::move(entry));
+					}
 
-				while(reader.get_read() - read_position < length)
+					container.add_statistic(std::move(statistic));
+					break;
+				}
+				case telemetry_v2_command::event:
 				{
-					const telemetry_type type = static_cast<telemetry_type>(reader.read_uint8());
+					const uint64_t id = reader.read_uint64();
+					const double timestamp = reader.read_double();
+					const telemetry_event_type event_type = static_cast<telemetry_event_type>(reader.read_uint8());
 
-					telemetry_event_entry entry;
-					entry.title = reader.read_string();
-					entry.value = reader.read_value(type);
+					auto &event = get_event_data(id);
 
-					// Weird in-band signalling
-					if(entry.title == "parent")
+					switch(event_type)
 					{
-						event.parent = entry.value.get<uint64_t>();
-						continue;
+						case telemetry_event_type::begin:
+							event.start_time = timestamp;
+							break;
+						case telemetry_event_type::end:
+							event.end_time = timestamp;
+							break;
 					}
 
-					event.entries.push_back(std::move(entry));
-				}
+					const size_t length = reader.read_uint32();
+					const size_t read_position = reader.get_read();
 
-				break;
-			}
+					while(reader.get_read() - read_position < length)
+					{
+						const telemetry_type type = static_cast<telemetry_type>(reader.read_uint8());
 
-			case telemetry_v2_command::packet:
-			{
-				const uint16_t runtime_id = reader.read_uint16();
-				const uint32_t count = reader.read_uint32();
+						telemetry_event_entry entry;
+						entry.title = reader.read_string();
+						entry.value = reader.read_value(type);
 
-				telemetry_provider &provider = container.get_provider(runtime_id);
+						// Weird in-band signalling
+						if(entry.title == "parent")
+						{
+							event.parent = entry.value.get<uint64_t>();
+							continue;
+						}
 
-				for(uint32_t i = 0; i < count; ++ i)
+						event.entries.push_back(std::move(entry));
+					}
+
+					break;
+				}
+
+				case telemetry_v2_command::packet:
 				{
-					const double timestamp = reader.read_double();
+					const uint16_t runtime_id = reader.read_uint16();
+					const uint32_t count = reader.read_uint32();
 
-					const size_t length = reader.read_uint32();
-					const size_t read = reader.get_read();
+					telemetry_provider &provider = container.get_provider(runtime_id);
+					const std::bitset<256> &selection = selected_fields[runtime_id];
 
-					while((reader.get_read() - read) < length)
+					if(selection.none())
 					{
-						const uint8_t id = reader.read_uint8();
-						telemetry_field &field = provider.get_field(id);
+						// Nothing of interest in here, skip straight past all samples
+						for(uint32_t i = 0; i < count; ++ i)
+						{
+							reader.skip(sizeof(double));
+							reader.skip(reader.read_uint32());
+						}
 
-						telemetry_data_point data_point;
-						data_point.timestamp = timestamp;
-						data_point.value = reader.read_value(field.get_type());
+						break;
+					}
 
-						field.add_data_point(std::move(data_point));
+					for(uint32_t i = 0; i < count; ++ i)
+					{
+						const telemetry_time timestamp = telemetry_time::from_seconds(reader.read_double());
+
+						const size_t length = reader.read_uint32();
+						const size_t read = reader.get_read();
+
+						if(is_after_time_range(options, timestamp))
+						{
+							reader.skip(length);
+							continue;
+						}
+
+						const bool is_before_range = is_before_time_range(options, timestamp);
+
+						while((reader.get_read() - read) < length)
+						{
+							const uint8_t id = reader.read_uint8();
+							telemetry_field &field = provider.get_field(id);
+
+							if(!selection.test(id))
+							{
+								reader.skip_value(field.get_type());
+								continue;
+							}
+
+							if(is_before_range)
+							{
+								const file_reader value_reader = reader;
+
+								// Skipped first, so that a value cut off by the end of the data is never carried over
+								reader.skip_value(field.get_type());
+								carried_values.insert_or_assign((uint32_t(runtime_id) << 8) | id, value_reader);
+								continue;
+							}
+
+							telemetry_data_point data_point;
+							data_point.timestamp = timestamp;
+							data_point.value = reader.read_value(field.get_type());
+
+							field.add_data_point(std::move(data_point));
+						}
 					}
-				}
 
-				break;
+					break;
+				}
 			}
 		}
+		catch(const telemetry_truncated_error &)
+		{
+			break;
+		}
+	}
+
+	for(auto &[ key, value_reader ] : carried_values)
+	{
+		telemetry_field &field = container.get_provider(uint16_t(key >> 8)).get_field(uint8_t(key & 0xff));
+		carry_over_value(field, value_reader.read_value(field.get_type()), options.time_range->start);
 	}
 
 	if(!events.empty())
@@ -536,8 +492,106 @@ telemetry_container parser_tlmv2_data(file_reader &reader, const telemetry_parse
 
 
 
+telemetry_container parser_columnar_data(const void *data, size_t size, const telemetry_parser_options &options)
+{
+	telemetry_columnar_reader reader(data, size);
+	telemetry_container container = reader.get_layout();
+
+	// Timestamps shared between the chunks of a provider, decoded once by the index of the chunk that stores them
+	std::unordered_map<uint32_t, std::vector<telemetry_time>> timestamps;
+
+	auto read_chunk = [&](uint32_t index) -> std::vector<telemetry_data_point> {
+
+		const telemetry_chunk_info &chunk = reader.get_chunks()[index];
+
+		if(chunk.timestamp_chunk == telemetry_columnar_own_timestamps)
+			return reader.read_chunk(chunk);
+
+		auto iterator = timestamps.find(chunk.timestamp_chunk);
+
+		if(iterator == timestamps.end())
+			iterator = timestamps.emplace(chunk.timestamp_chunk, reader.read_timestamps(chunk)).first;
+
+		return reader.read_chunk(chunk, iterator->second);
+
+	};
+
+	// Only the chunks of selected fields that overlap the time range are decoded, everything else is never touched
+	for(auto &provider : container.get_providers())
+	{
+		for(auto &field : provider.get_fields())
+		{
+			field.set_loaded(is_field_selected(options, provider, field));
+
+			if(!field.is_loaded())
+				continue;
+
+			const std::vector<uint32_t> &indices = reader.get_field_chunks(provider.get_id(), field.get_id());
+			const auto &chunks = reader.get_chunks();
+
+			auto begin = indices.begin();
+			auto end = indices.end();
+
+			if(options.time_range)
+			{
+				begin = std::partition_point(indices.begin(), indices.end(), [&](uint32_t index) {
+					return chunks[index].end_time < options.time_range->start;
+				});
+				end = std::partition_point(begin, indices.end(), [&](uint32_t index) {
+					return chunks[index].start_time <= options.time_range->end;
+				});
+			}
+
+			size_t count = 0;
+
+			for(auto iterator = begin; iterator != end; ++ iterator)
+				count += chunks[*iterator].count;
+
+			std::vector<telemetry_data_point> result;
+			result.reserve(count);
+
+			std::optional<telemetry_data_value> carried;
+
+			for(auto iterator = begin; iterator != end; ++ iterator)
+			{
+				for(auto &data_point : read_chunk(*iterator))
+				{
+					if(is_after_time_range(options, data_point.timestamp))
+						break;
+
+					if(is_before_time_range(options, data_point.timestamp))
+					{
+						carried = std::move(data_point.value);
+						continue;
+					}
+
+					result.push_back(std::move(data_point));
+				}
+			}
+
+			field.set_data_points(std::move(result));
+
+			// The value at the start of the range comes from the last chunk that ends before it
+			if(!carried && begin != indices.begin() && options.time_range)
+				carried = std::move(read_chunk(*(begin - 1)).back().value);
+
+			if(carried)
+				carry_over_value(field, std::move(*carried), options.time_range->start);
+		}
+	}
+
+	finalize_container(container, options);
+
+	return container;
+}
+
+
+
 telemetry_container parse_telemetry_data(const void *data, size_t size, const telemetry_parser_options &options)
 {
+	if(size < 8)
+		throw std::invalid_argument("Unsupported telemetry data");
+
 	file_reader reader(static_cast<const uint8_t *>(data), size);
 
 	const uint32_t telemetry_version = reader.read_uint32();
@@ -545,6 +599,54 @@ telemetry_container parse_telemetry_data(const void *data, size_t size, const te
 
 	if(telemetry_version == 2 && length == 8)
 		return parser_tlmv2_data(reader, options);
+	if(telemetry_version == telemetry_columnar_version && length == 8)
+		return parser_columnar_data(data, size, options);
 
 	throw std::invalid_argument("Unsupported telemetry data");
 }
+
+void load_telemetry_fields(telemetry_container &container, const void *data, size_t size, const telemetry_parser_options &options)
+{
+	telemetry_parser_options parse_options;
+	parse_options.field_selection = options.field_selection;
+	parse_options.time_range = options.time_range;
+	parse_options.build_histograms = options.build_histograms;
+	parse_options.compact_runs = false;
+	parse_options.compress_columns = false;
+
+	telemetry_container source = parse_telemetry_data(data, size, parse_options);
+
+	for(auto &provider : container.get_providers())
+	{
+		if(!source.has_provider(provider.get_id()))
+			continue;
+
+		auto &source_provider = source.get_provider(provider.get_id());
+
+		for(auto &field : provider.get_fields())
+		{
+			if(field.is_loaded() || !source_provider.has_field(field.get_id()))
+				continue;
+
+			auto &source_field = source_provider.get_field(field.get_id());
+			if(!source_field.is_loaded())
+				continue;
+
+			// Data points are processed against the existing container, so that they share its time range
+			if(options.data_point_processor && !source_field.empty())
+				field.set_data_points(options.data_point_processor(container, provider, field, source_field.get_data_points()));
+			else
+				field.set_data_points(std::vector<telemetry_data_point>(source_field.get_data_points()));
+
+			if(source_field.has_histograms())
+				field.set_histograms(telemetry_histogram_series(source_field.get_histograms()));
+
+			if(options.compact_runs)
+				field.compact();
+			if(options.compress_columns)
+				field.compress();
+
+			field.set_loaded(true);
+		}
+	}
+}
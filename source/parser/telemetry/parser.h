@@ -20,13 +20,58 @@
 #define TELEMETRY_PARSER_H
 
 #include <functional>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
 #include "container.h"
 
+class telemetry_field_selection
+{
+public:
+	void add_provider(const std::string &identifier);
+	void add_field(const std::string &identifier, uint8_t field);
+
+	bool contains_provider(const std::string &identifier) const; // True if any field of the provider is selected
+	bool contains_field(const std::string &identifier, uint8_t field) const;
+
+private:
+	std::unordered_set<std::string> m_providers;
+	std::unordered_map<std::string, std::unordered_set<uint8_t>> m_fields;
+};
+
+struct telemetry_time_range
+{
+	telemetry_time start;
+	telemetry_time end;
+};
+
 struct telemetry_parser_options
 {
 	std::function<std::vector<telemetry_data_point> (const telemetry_container &, const telemetry_provider &, const telemetry_field &, const std::vector<telemetry_data_point> &)> data_point_processor;
+
+	// Only the data points of selected fields are loaded, everything else is skipped without being decoded.
+	// Providers and fields are still registered, but unselected fields report is_loaded() as false. Loads all fields if not set
+	std::optional<telemetry_field_selection> field_selection;
+
+	// Only data points inside the time range are loaded. Registrations, statistics and events are always loaded in full.
+	// Since values are sticky, the last value of each field before the range is carried over to the start of the range
+	std::optional<telemetry_time_range> time_range;
+
+	// Calls telemetry_field::build_histograms() on every time and fps field before the data point processor runs, so that they cover every recorded sample
+	bool build_histograms = true;
+
+	// Calls telemetry_field::compact() on every field once all data points are loaded and processed.
+	// Off by default, statistics, percentiles, histograms and smoothing count every data point as one sample, which a compacted field no longer holds.
+	// Only enable it for containers whose fields are just looked up by time
+	bool compact_runs = false;
+
+	// Calls telemetry_field::compress() on every field after compacting, trading slower lookups for a fraction of the memory
+	bool compress_columns = false;
 };
 
 telemetry_container parse_telemetry_data(const void *data, size_t size, const telemetry_parser_options &options);
 
+// Loads the data points of the selected fields that aren't yet loaded in the container. The data must be the same that the container was parsed from
+void load_telemetry_fields(telemetry_container &container, const void *data, size_t size, const telemetry_parser_options &options);
+
 #endif //TELEMETRY_PARSER_H
@@ -17,7 +17,8 @@
 //
 
 #include <stdexcept>
-#include <cmath>
+#include <algorithm>
+#include <limits>
 #include "provider.h"
 
 telemetry_field::telemetry_field(uint8_t id, uint16_t provider, std::string title, telemetry_type type, telemetry_unit unit) :
@@ -28,65 +29,185 @@ telemetry_field::telemetry_field(uint8_t id, uint16_t provider, std::string titl
 	m_unit(unit)
 {}
 
-telemetry_data_point telemetry_field::get_data_point_closest_to_time(int32_t time) const
+// Data points are sorted by timestamp, so all lookups can binary search for the range they are interested in
+static std::vector<telemetry_data_point>::const_iterator lower_bound_time(const std::vector<telemetry_data_point> &data_points, telemetry_time time)
 {
-	for(size_t i = 0; i < m_data_points.size(); ++ i)
+	return std::lower_bound(data_points.begin(), data_points.end(), time, [](const telemetry_data_point &data, telemetry_time time) {
+		return data.timestamp < time;
+	});
+}
+static std::vector<telemetry_data_point>::const_iterator upper_bound_time(const std::vector<telemetry_data_point> &data_points, telemetry_time time)
+{
+	return std::upper_bound(data_points.begin(), data_points.end(), time, [](telemetry_time time, const telemetry_data_point &data) {
+		return time < data.timestamp;
+	});
+}
+
+const std::vector<telemetry_data_point> &telemetry_field::get_data_points() const
+{
+	if(m_encoding == telemetry_field_encoding::compressed)
+		throw std::invalid_argument("Data points of compressed fields can only be accessed through range queries");
+
+	return m_data_points;
+}
+
+size_t telemetry_field::get_memory_usage() const
+{
+	return m_data_points.capacity() * sizeof(telemetry_data_point) + m_column.get_memory_usage() + m_histograms.get_memory_usage();
+}
+
+telemetry_data_point telemetry_field::get_data_point_closest_to_time(telemetry_time time) const
+{
+	if(m_encoding == telemetry_field_encoding::compressed)
 	{
-		auto &data = m_data_points[i];
+		const size_t index = m_column.lower_bound(time);
 
-		if(data.timestamp >= time)
-		{
-			if(i > 0)
-			{
-				auto &previous = m_data_points[i - 1];
+		if(index == m_column.size())
+			throw std::invalid_argument("No data point before or at time");
 
-				if(std::fabs(data.timestamp - time) > std::fabs(previous.timestamp - time))
-					return previous;
-			}
+		telemetry_data_point data_point = m_column.get_data_point(index);
+
+		if(index > 0)
+		{
+			telemetry_data_point previous = m_column.get_data_point(index - 1);
 
-			return m_data_points[i];
+			if((data_point.timestamp - time) > (time - previous.timestamp))
+				return previous;
 		}
+
+		return data_point;
+	}
+
+	auto iterator = lower_bound_time(m_data_points, time);
+
+	if(iterator == m_data_points.end())
+		throw std::invalid_argument("No data point before or at time");
+
+	if(iterator != m_data_points.begin())
+	{
+		auto &previous = *(iterator - 1);
+
+		if((iterator->timestamp - time) > (time - previous.timestamp))
+			return previous;
 	}
 
-	throw std::invalid_argument("No data point before or at time");
+	return *iterator;
 }
 
-telemetry_data_point telemetry_field::get_data_point_after_time(int32_t time) const
+telemetry_data_point telemetry_field::get_data_point_after_time(telemetry_time time) const
 {
-	for(size_t i = 0; i < m_data_points.size(); ++ i)
+	if(m_encoding == telemetry_field_encoding::compressed)
 	{
-		auto &data = m_data_points[i];
+		const size_t index = m_column.lower_bound(time);
 
-		if(data.timestamp < time)
-			continue;
+		if(index == m_column.size())
+			throw std::invalid_argument("No data point after time");
 
-		if(i > 0)
-			return m_data_points[i - 1];
+		return m_column.get_data_point((index > 0) ? (index - 1) : index);
+	}
+
+	auto iterator = lower_bound_time(m_data_points, time);
+
+	if(iterator == m_data_points.end())
+		throw std::invalid_argument("No data point after time");
+
+	if(iterator != m_data_points.begin())
+		return *(iterator - 1);
+
+	return *iterator;
+}
+
+size_t telemetry_field::get_data_point_count() const
+{
+	if(m_encoding == telemetry_field_encoding::compressed)
+		return m_column.size();
 
-		return data;
+	return m_data_points.size();
+}
+
+telemetry_data_point telemetry_field::get_data_point(size_t index) const
+{
+	if(m_encoding == telemetry_field_encoding::compressed)
+		return m_column.get_data_point(index);
+
+	return m_data_points.at(index);
+}
+
+size_t telemetry_field::get_index_closest_to_time(telemetry_time time) const
+{
+	const size_t count = get_data_point_count();
+
+	if(count == 0)
+		throw std::out_of_range("Field has no data points");
+
+	size_t index;
+
+	if(m_encoding == telemetry_field_encoding::compressed)
+		index = m_column.lower_bound(time);
+	else
+		index = lower_bound_time(m_data_points, time) - m_data_points.begin();
+
+	if(index == count)
+		return count - 1;
+
+	// Same tie breaking as get_data_point_closest_to_time()
+	if(index > 0)
+	{
+		const telemetry_time previous = get_data_point(index - 1).timestamp;
+		const telemetry_time next = get_data_point(index).timestamp;
+
+		if((next - time) > (time - previous))
+			return index - 1;
 	}
 
-	throw std::invalid_argument("No data point after time");
+	return index;
 }
 
-std::vector<telemetry_data_point> telemetry_field::get_data_points_in_range(int32_t start, int32_t end) const
+// Run encoded fields don't store the samples that repeat a value, so a range that starts inside a run would miss its value
+static bool get_run_at_range_start(const std::vector<telemetry_data_point> &data_points, std::vector<telemetry_data_point>::const_iterator begin, telemetry_time start, telemetry_data_point &result)
 {
-	std::vector<telemetry_data_point> result;
+	if(begin == data_points.begin() || (begin != data_points.end() && begin->timestamp == start))
+		return false;
+
+	result = *(begin - 1);
+	result.timestamp = start;
 
-	for(auto &data : m_data_points)
+	return true;
+}
+
+std::vector<telemetry_data_point> telemetry_field::get_data_points_in_range(telemetry_time start, telemetry_time end) const
+{
+	if(end < start)
+		return {};
+
+	if(m_encoding == telemetry_field_encoding::compressed)
 	{
-		if(data.timestamp < start)
-			continue;
-		if(data.timestamp > end)
-			break;
+		std::vector<telemetry_data_point> result;
 
-		result.push_back(data);
+		m_column.for_each_in_range(start, end, [&](const telemetry_data_point &data_point) {
+			result.push_back(data_point);
+		});
+
+		return result;
 	}
 
+	const auto begin = lower_bound_time(m_data_points, start);
+	const auto end_iterator = upper_bound_time(m_data_points, end);
+
+	std::vector<telemetry_data_point> result;
+	result.reserve((end_iterator - begin) + 1);
+
+	telemetry_data_point run_start;
+
+	if(m_encoding == telemetry_field_encoding::runs && get_run_at_range_start(m_data_points, begin, start, run_start))
+		result.push_back(std::move(run_start));
+
+	result.insert(result.end(), begin, end_iterator);
+
 	return result;
 }
 
-std::pair<telemetry_data_point, telemetry_data_point> telemetry_field::get_extreme_data_point_in_range(int32_t start, int32_t end) const
+std::pair<telemetry_data_point, telemetry_data_point> telemetry_field::get_extreme_data_point_in_range(telemetry_time start, telemetry_time end) const
 {
 	telemetry_data_point min_value;
 	telemetry_data_point max_value;
@@ -106,12 +227,7 @@ std::pair<telemetry_data_point, telemetry_data_point> telemetry_field::get_extre
 
 	bool found_data_point = false;
 
-	for(auto &data : m_data_points)
-	{
-		if(data.timestamp < start)
-			continue;
-		if(data.timestamp > end)
-			break;
+	auto update_extremes = [&](const telemetry_data_point &data) {
 
 		if(!found_data_point)
 		{
@@ -120,7 +236,7 @@ std::pair<telemetry_data_point, telemetry_data_point> telemetry_field::get_extre
 			min_value = data;
 			max_value = data;
 
-			continue;
+			return;
 		}
 
 		switch(m_type)
@@ -218,21 +334,181 @@ std::pair<telemetry_data_point, telemetry_data_point> telemetry_field::get_extre
 				break;
 			}
 		}
+
+	};
+
+	if(m_encoding == telemetry_field_encoding::compressed)
+	{
+		if(!(end < start))
+			m_column.for_each_in_range(start, end, update_extremes);
+
+		if(!found_data_point)
+			return std::make_pair(get_data_point_closest_to_time(start), get_data_point_closest_to_time(start));
+
+		return std::make_pair(min_value, max_value);
 	}
 
+	const auto begin = lower_bound_time(m_data_points, start);
+	const auto end_iterator = (end < start) ? begin : upper_bound_time(m_data_points, end);
+
+	telemetry_data_point run_start;
+
+	if(m_encoding == telemetry_field_encoding::runs && !(end < start) && get_run_at_range_start(m_data_points, begin, start, run_start))
+		update_extremes(run_start);
+
+	for(auto iterator = begin; iterator != end_iterator; ++ iterator)
+		update_extremes(*iterator);
+
 	if(!found_data_point)
 		return std::make_pair(get_data_point_closest_to_time(start), get_data_point_closest_to_time(start));
 
 	return std::make_pair(min_value, max_value);
 }
 
+void telemetry_field::set_loaded(bool loaded)
+{
+	m_loaded = loaded;
+}
+
 void telemetry_field::set_data_points(std::vector<telemetry_data_point> &&data_points)
 {
 	m_data_points = std::move(data_points);
+	m_column = telemetry_compressed_column();
+	m_sample_count = m_data_points.size();
+	m_encoding = telemetry_field_encoding::samples;
 }
 void telemetry_field::add_data_point(telemetry_data_point &&data)
 {
+	if(m_encoding == telemetry_field_encoding::compressed)
+		decompress();
+
 	m_data_points.push_back(std::move(data));
+	m_sample_count ++;
+	m_encoding = telemetry_field_encoding::samples;
+}
+
+static bool is_same_value(telemetry_type type, const telemetry_data_value &lhs, const telemetry_data_value &rhs)
+{
+	switch(type)
+	{
+		case telemetry_type::string:
+			return lhs.string == rhs.string;
+		case telemetry_type::vec2:
+			return lhs.vec2[0] == rhs.vec2[0] && lhs.vec2[1] == rhs.vec2[1];
+		case telemetry_type::dvec2:
+			return lhs.dvec2[0] == rhs.dvec2[0] && lhs.dvec2[1] == rhs.dvec2[1];
+
+		case telemetry_type::boolean:
+			return lhs.b == rhs.b;
+		case telemetry_type::uint8:
+			return lhs.u8 == rhs.u8;
+		case telemetry_type::uint16:
+			return lhs.u16 == rhs.u16;
+		case telemetry_type::uint32:
+			return lhs.u32 == rhs.u32;
+		case telemetry_type::uint64:
+			return lhs.u64 == rhs.u64;
+		case telemetry_type::int32:
+			return lhs.i32 == rhs.i32;
+		case telemetry_type::int64:
+			return lhs.i64 == rhs.i64;
+		case telemetry_type::f32:
+			return lhs.f32 == rhs.f32;
+		case telemetry_type::f64:
+			return lhs.f64 == rhs.f64;
+	}
+
+	return false;
+}
+
+void telemetry_field::build_histograms()
+{
+	m_histograms = telemetry_histogram_series();
+
+	const telemetry_time start(std::numeric_limits<int64_t>::min());
+	const telemetry_time end(std::numeric_limits<int64_t>::max());
+
+	visit_telemetry_type(m_type, [&](auto tag) {
+
+		constexpr telemetry_type Type = decltype(tag)::value;
+
+		if constexpr (is_telemetry_type_convertible<double>(Type))
+		{
+			for_each_data_point_in_range(start, end, [&](const telemetry_data_point &data_point) {
+				m_histograms.add(data_point.timestamp, data_point.value.get_as<double, Type>());
+			});
+		}
+
+	});
+}
+
+void telemetry_field::set_histograms(telemetry_histogram_series &&histograms)
+{
+	m_histograms = std::move(histograms);
+}
+
+void telemetry_field::compact()
+{
+	// Not worth it for short fields or fields whose values change all the time
+	static constexpr size_t minimum_samples = 64;
+	static constexpr size_t minimum_run_length = 4;
+
+	if(m_encoding != telemetry_field_encoding::samples || m_data_points.size() < minimum_samples)
+		return;
+
+	// Timings and memory are summarized as distributions of their samples, which collapsing a run would skew towards the values that change
+	if(m_unit != telemetry_unit::value)
+		return;
+
+	size_t runs = 1;
+
+	for(size_t i = 1; i < m_data_points.size(); ++ i)
+	{
+		if(!is_same_value(m_type, m_data_points[i - 1].value, m_data_points[i].value))
+			runs ++;
+	}
+
+	if(runs * minimum_run_length > m_data_points.size())
+		return;
+
+	std::vector<telemetry_data_point> result;
+	result.reserve(runs * 2);
+
+	size_t run_start = 0;
+
+	for(size_t i = 1; i <= m_data_points.size(); ++ i)
+	{
+		if(i < m_data_points.size() && is_same_value(m_type, m_data_points[run_start].value, m_data_points[i].value))
+			continue;
+
+		// Keep the first and last sample of the run, so the time covered by the run stays the same
+		result.push_back(std::move(m_data_points[run_start]));
+
+		if(i - 1 > run_start)
+			result.push_back(std::move(m_data_points[i - 1]));
+
+		run_start = i;
+	}
+
+	m_data_points = std::move(result);
+	m_encoding = telemetry_field_encoding::runs;
+}
+
+void telemetry_field::compress()
+{
+	// A single block barely saves anything over the plain data points
+	if(m_encoding != telemetry_field_encoding::samples || !telemetry_compressed_column::is_supported_type(m_type) || m_data_points.size() < telemetry_compressed_column::block_size)
+		return;
+
+	m_column = telemetry_compressed_column(m_type, m_data_points);
+	m_data_points = std::vector<telemetry_data_point>();
+	m_encoding = telemetry_field_encoding::compressed;
+}
+void telemetry_field::decompress()
+{
+	m_data_points = m_column.decompress();
+	m_column = telemetry_compressed_column();
+	m_encoding = telemetry_field_encoding::samples;
 }
 
 
@@ -22,6 +22,15 @@
 #include <vector>
 #include <string>
 #include "data.h"
+#include "compressed_column.h"
+#include "histogram.h"
+
+enum class telemetry_field_encoding : uint8_t
+{
+	samples, // Every recorded sample is stored as its own data point
+	runs, // Repeated values are collapsed into runs, see telemetry_field::compact()
+	compressed // Data points live in a telemetry_compressed_column, see telemetry_field::compress()
+};
 
 class telemetry_field
 {
@@ -35,19 +44,84 @@ public:
 	telemetry_type get_type() const { return m_type; }
 	telemetry_unit get_unit() const { return m_unit; }
 
-	bool empty() const { return m_data_points.empty(); }
-	const std::vector<telemetry_data_point> &get_data_points() const { return m_data_points; }
+	bool is_loaded() const { return m_loaded; }
+	void set_loaded(bool loaded);
+
+	bool empty() const { return m_sample_count == 0; }
+	const std::vector<telemetry_data_point> &get_data_points() const; // Will throw std::invalid_argument() for compressed fields, use the range queries instead
+
+	telemetry_field_encoding get_encoding() const { return m_encoding; }
+	size_t get_sample_count() const { return m_sample_count; } // Number of recorded samples, which may be more than the stored data points
+	size_t get_memory_usage() const; // Approximate number of bytes used by the data points
+
+	telemetry_data_point get_data_point_closest_to_time(telemetry_time time) const;
+	telemetry_data_point get_data_point_after_time(telemetry_time time) const;
 
-	telemetry_data_point get_data_point_closest_to_time(int32_t time) const;
-	telemetry_data_point get_data_point_after_time(int32_t time) const;
+	// Index based access to the stored data points, which unlike get_data_points() works for every encoding
+	size_t get_data_point_count() const;
+	telemetry_data_point get_data_point(size_t index) const; // Will throw std::out_of_range() for invalid indices
+	size_t get_index_closest_to_time(telemetry_time time) const; // Clamped to the first and last data point, will throw std::out_of_range() for empty fields
 
-	std::vector<telemetry_data_point> get_data_points_in_range(int32_t start, int32_t end) const;
-	std::pair<telemetry_data_point, telemetry_data_point> get_extreme_data_point_in_range(int32_t start, int32_t end) const;
+	std::vector<telemetry_data_point> get_data_points_in_range(telemetry_time start, telemetry_time end) const;
+	std::pair<telemetry_data_point, telemetry_data_point> get_extreme_data_point_in_range(telemetry_time start, telemetry_time end) const;
+
+	// Convenience wrappers that take the time in seconds
+	telemetry_data_point get_data_point_closest_to_time(double time) const { return get_data_point_closest_to_time(telemetry_time::from_seconds(time)); }
+	telemetry_data_point get_data_point_after_time(double time) const { return get_data_point_after_time(telemetry_time::from_seconds(time)); }
+
+	std::vector<telemetry_data_point> get_data_points_in_range(double start, double end) const { return get_data_points_in_range(telemetry_time::from_seconds(start), telemetry_time::from_seconds(end)); }
+	std::pair<telemetry_data_point, telemetry_data_point> get_extreme_data_point_in_range(double start, double end) const { return get_extreme_data_point_in_range(telemetry_time::from_seconds(start), telemetry_time::from_seconds(end)); }
 
 	void set_data_points(std::vector<telemetry_data_point> &&data_points);
 	void add_data_point(telemetry_data_point &&data);
 
+	// Telemetry values are sticky until they change, so fields that rarely change can drop the samples that just repeat the previous value.
+	// If that shrinks the field enough, each run of identical values is reduced to its first and last sample and the encoding switches to runs.
+	// Lookups and range queries work directly on the runs, a range that starts inside a run reports the value in effect at its start.
+	// Only applies to fields with the value unit. Anything that counts data points as samples is skewed towards the values that change,
+	// so don't compact fields that feed statistics, see telemetry_parser_options::compact_runs.
+	void compact();
+
+	// Moves f32 and f64 data points into a telemetry_compressed_column, which needs a fraction of the memory. Lookups and range queries
+	// decode only the blocks they touch, but get_data_points() is no longer available. Any modification of the data points decompresses the field again
+	void compress();
+
+	// Builds a histogram of the values for every second of the field from the current data points, does nothing for non-numeric fields.
+	// The histograms describe the samples as they were recorded and are kept when the data points are replaced, compacted or compressed
+	// afterwards, e.g. by decimating them for display
+	void build_histograms();
+	void set_histograms(telemetry_histogram_series &&histograms);
+
+	bool has_histograms() const { return !m_histograms.empty(); }
+	const telemetry_histogram_series &get_histograms() const { return m_histograms; }
+
+	// Sum of the histograms of every second overlapping [start, end], empty if no histograms were built
+	telemetry_histogram get_histogram_in_range(telemetry_time start, telemetry_time end) const { return m_histograms.get_histogram(start, end); }
+
+	// Calls function for every stored data point in [start, end] without copying them out first, works for every encoding
+	template<class F>
+	void for_each_data_point_in_range(telemetry_time start, telemetry_time end, F &&function) const
+	{
+		if(m_encoding == telemetry_field_encoding::compressed)
+		{
+			m_column.for_each_in_range(start, end, function);
+			return;
+		}
+
+		for(auto &data_point : m_data_points)
+		{
+			if(data_point.timestamp < start)
+				continue;
+			if(data_point.timestamp > end)
+				break;
+
+			function(data_point);
+		}
+	}
+
 private:
+	void decompress();
+
 	uint8_t m_id;
 	uint16_t m_provider;
 	std::string m_title;
@@ -55,7 +129,14 @@ private:
 	telemetry_type m_type;
 	telemetry_unit m_unit;
 
+	bool m_loaded = true;
+	telemetry_field_encoding m_encoding = telemetry_field_encoding::samples;
+	size_t m_sample_count = 0;
+
 	std::vector<telemetry_data_point> m_data_points;
+	telemetry_compressed_column m_column;
+
+	telemetry_histogram_series m_histograms;
 };
 
 class telemetry_provider
@@ -0,0 +1,157 @@
+//
+//  resample.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "resample.h"
+
+telemetry_time_grid telemetry_time_grid::from_range(double start, double end, double interval)
+{
+	if(interval <= 0.0)
+		throw std::invalid_argument("Grid interval must be positive");
+
+	telemetry_time_grid grid;
+	grid.start = start;
+	grid.interval = interval;
+	grid.count = size_t(std::max(std::ceil((end - start) / interval), 1.0));
+
+	return grid;
+}
+
+std::vector<double> resample_telemetry_values(const double *timestamps, const double *values, size_t count, const telemetry_time_grid &grid, telemetry_resample_mode mode)
+{
+	if(count == 0)
+		throw std::invalid_argument("Can't resample an empty series");
+
+	std::vector<double> result(grid.count);
+	size_t index = 0; // First sample after the previous grid point
+
+	switch(mode)
+	{
+		case telemetry_resample_mode::hold:
+		{
+			for(size_t i = 0; i < grid.count; ++ i)
+			{
+				const double time = grid.get_time(i);
+
+				while(index < count && timestamps[index] <= time)
+					index ++;
+
+				result[i] = values[index > 0 ? index - 1 : 0];
+			}
+
+			break;
+		}
+
+		case telemetry_resample_mode::mean:
+		{
+			// Skip everything before the first cell, but remember it for holding
+			while(index < count && timestamps[index] < grid.start)
+				index ++;
+
+			for(size_t i = 0; i < grid.count; ++ i)
+			{
+				const double end = grid.get_time(i + 1);
+
+				double sum = 0.0;
+				size_t samples = 0;
+
+				for(; index < count && timestamps[index] < end; ++ index, ++ samples)
+					sum += values[index];
+
+				if(samples > 0)
+					result[i] = sum / samples;
+				else
+					result[i] = values[index > 0 ? index - 1 : 0];
+			}
+
+			break;
+		}
+	}
+
+	return result;
+}
+
+// Timestamps in seconds and values of the data points up to end
+static std::pair<std::vector<double>, std::vector<double>> extract_values(const telemetry_field &field, telemetry_time end)
+{
+	std::vector<double> timestamps;
+	std::vector<double> values;
+
+	timestamps.reserve(field.get_data_point_count());
+	values.reserve(field.get_data_point_count());
+
+	const bool is_duration = (field.get_unit() == telemetry_unit::duration);
+	const telemetry_time start(std::numeric_limits<int64_t>::min());
+
+	visit_telemetry_type(field.get_type(), [&](auto tag) {
+
+		constexpr telemetry_type Type = decltype(tag)::value;
+
+		field.for_each_data_point_in_range(start, end, [&](const telemetry_data_point &data) {
+
+			timestamps.push_back(data.timestamp.to_seconds());
+
+			if(is_duration)
+				values.push_back(data.value.vec2[1] - data.value.vec2[0]);
+			else if constexpr (is_telemetry_type_convertible<double>(Type))
+				values.push_back(data.value.get_as<double, Type>());
+			else
+				throw std::invalid_argument("Field isn't convertible to double");
+
+		});
+
+	});
+
+	return { std::move(timestamps), std::move(values) };
+}
+
+std::vector<double> resample_telemetry_field(const telemetry_field &field, const telemetry_time_grid &grid, telemetry_resample_mode mode)
+{
+	const auto [ timestamps, values ] = extract_values(field, telemetry_time::from_seconds(grid.get_time(grid.count)));
+	return resample_telemetry_values(timestamps.data(), values.data(), timestamps.size(), grid, mode);
+}
+
+std::vector<double> sample_telemetry_values(const double *timestamps, const double *values, size_t count, const double *times, size_t time_count)
+{
+	if(count == 0)
+		throw std::invalid_argument("Can't sample an empty series");
+
+	std::vector<double> result(time_count);
+	size_t index = 0;
+
+	for(size_t i = 0; i < time_count; ++ i)
+	{
+		while(index < count && timestamps[index] <= times[i])
+			index ++;
+
+		result[i] = values[index > 0 ? index - 1 : 0];
+	}
+
+	return result;
+}
+
+std::vector<double> sample_telemetry_field(const telemetry_field &field, const std::vector<double> &times)
+{
+	const telemetry_time end = times.empty() ? telemetry_time() : telemetry_time::from_seconds(times.back()) + telemetry_time(1);
+	const auto [ timestamps, values ] = extract_values(field, end);
+
+	return sample_telemetry_values(timestamps.data(), values.data(), timestamps.size(), times.data(), times.size());
+}
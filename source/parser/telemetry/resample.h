@@ -0,0 +1,56 @@
+//
+//  resample.h
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef TELEMETRY_RESAMPLE_H
+#define TELEMETRY_RESAMPLE_H
+
+#include <cstddef>
+#include <vector>
+#include "provider.h"
+
+enum class telemetry_resample_mode : uint8_t
+{
+	hold, // Value of the last sample at or before the grid point, the sticky values the charts draw between samples
+	mean // Average of the samples within the grid cell, empty cells hold the value of the last sample before them
+};
+
+// Evenly spaced points in seconds. In mean mode every point starts a cell that reaches up to the next one
+struct telemetry_time_grid
+{
+	double start = 0.0;
+	double interval = 1.0;
+	size_t count = 0;
+
+	double get_time(size_t index) const { return start + index * interval; }
+
+	static telemetry_time_grid from_range(double start, double end, double interval); // Covers [start, end), at least one point
+};
+
+// Resamples a series with sorted timestamps in seconds onto the grid in a single walk, returns grid.count values.
+// Grid points before the first sample take its value, will throw std::invalid_argument() if there are no samples
+std::vector<double> resample_telemetry_values(const double *timestamps, const double *values, size_t count, const telemetry_time_grid &grid, telemetry_resample_mode mode);
+
+// Same for the data points of a field, duration fields are resolved to their length. Will throw std::invalid_argument() for empty fields
+// and fields that aren't convertible to double
+std::vector<double> resample_telemetry_field(const telemetry_field &field, const telemetry_time_grid &grid, telemetry_resample_mode mode);
+
+// Holds the values at arbitrary points in time, which have to be sorted. Used to line up fields that were recorded at different timestamps
+std::vector<double> sample_telemetry_values(const double *timestamps, const double *values, size_t count, const double *times, size_t time_count);
+std::vector<double> sample_telemetry_field(const telemetry_field &field, const std::vector<double> &times);
+
+#endif //TELEMETRY_RESAMPLE_H
@@ -0,0 +1,491 @@
+//
+//  stream.h
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef TELEMETRY_STREAM_H
+#define TELEMETRY_STREAM_H
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include "data.h"
+
+// Thrown by file_reader when a read runs past the end of the data. TLMv2 captures are cut off mid-command when X-Plane crashes,
+// so their parser catches it and keeps everything up to the last complete command
+struct telemetry_truncated_error : std::invalid_argument
+{
+	telemetry_truncated_error() :
+		std::invalid_argument("Telemetry data is truncated")
+	{}
+};
+
+struct file_reader
+{
+	file_reader(const uint8_t *data, size_t size) :
+		m_data(data),
+		m_start(data),
+		m_end(data + size)
+	{}
+
+	file_reader(const uint8_t *data, size_t offset, size_t size) :
+		m_data(data + offset),
+		m_start(data),
+		m_end(data + size)
+	{}
+
+	size_t get_read() const { return m_data - m_start; }
+	const uint8_t *get_position() const { return m_data; }
+	size_t get_remaining() const { return m_data < m_end ? size_t(m_end - m_data) : 0; }
+
+	bool at_end() const { return m_data >= m_end; }
+
+	void skip(size_t bytes)
+	{
+		require(bytes);
+		m_data += bytes;
+	}
+
+
+	bool read_bool()
+	{
+		require(1);
+		return *m_data ++;
+	}
+
+	uint8_t read_uint8()
+	{
+		require(1);
+		return *m_data ++;
+	}
+
+	uint16_t read_uint16()
+	{
+		require(2);
+
+		uint16_t data[2];
+
+		data[0] = *m_data ++;
+		data[1] = *m_data ++;
+
+		return (data[1] << 8) | data[0];
+	}
+	int16_t read_int16()
+	{
+		require(2);
+
+		int16_t data[2];
+
+		data[0] = *m_data ++;
+		data[1] = *m_data ++;
+
+		return (data[1] << 8) | data[0];
+	}
+
+	uint32_t read_uint32()
+	{
+		require(4);
+
+		uint32_t data[4];
+
+		for(int i = 0; i < 4; i++)
+			data[i] = *m_data ++;
+
+		return (data[3] << 24) | (data[2] << 16) | (data[1] << 8) | data[0];
+	}
+	int32_t read_int32()
+	{
+		require(4);
+
+		int32_t data[4];
+
+		for(int i = 0; i < 4; i++)
+			data[i] = *m_data ++;
+
+		return (data[3] << 24) | (data[2] << 16) | (data[1] << 8) | data[0];
+	}
+
+	uint64_t read_uint64()
+	{
+		require(8);
+
+		uint64_t data[8];
+
+		for(int i = 0; i < 8; i++)
+			data[i] = *m_data ++;
+
+		return (data[7] << 56) | (data[6] << 48) | (data[5] << 40) | (data[4] << 32) | (data[3] << 24) | (data[2] << 16) | (data[1] << 8) | data[0];
+	}
+	int64_t read_int64()
+	{
+		require(8);
+
+		int64_t data[8];
+
+		for(int i = 0; i < 8; i++)
+			data[i] = *m_data ++;
+
+		return (data[7] << 56) | (data[6] << 48) | (data[5] << 40) | (data[4] << 32) | (data[3] << 24) | (data[2] << 16) | (data[1] << 8) | data[0];
+	}
+
+	float read_float()
+	{
+		union
+		{
+			uint8_t ival[4];
+			float fval;
+		} map;
+
+		require(4);
+
+		for(int i = 0; i < 4; i++)
+			map.ival[i] = *m_data ++;
+
+		if(std::isinf(map.fval) || std::isnan(map.fval))
+			return 0.0f;
+
+		return map.fval;
+	}
+
+	double read_double()
+	{
+		union
+		{
+			uint8_t ival[8];
+			double fval;
+		} map;
+
+		require(8);
+
+		for(int i = 0; i < 8; i++)
+			map.ival[i] = *m_data ++;
+
+		if(std::isinf(map.fval) || std::isnan(map.fval))
+			return 0.0f;
+
+		return map.fval;
+	}
+
+	std::string read_string()
+	{
+		const uint8_t length = read_uint8();
+		require(length);
+
+		std::string result(length, '\0');
+
+		for(uint8_t i = 0; i < length; i ++)
+			result[i] = *m_data ++;
+
+		return result;
+	}
+
+	void skip_value(telemetry_type type)
+	{
+		switch(type)
+		{
+			case telemetry_type::boolean:
+			case telemetry_type::uint8:
+				skip(1);
+				break;
+
+			case telemetry_type::uint16:
+				skip(2);
+				break;
+
+			case telemetry_type::uint32:
+			case telemetry_type::int32:
+			case telemetry_type::f32:
+				skip(4);
+				break;
+
+			case telemetry_type::uint64:
+			case telemetry_type::int64:
+			case telemetry_type::f64:
+			case telemetry_type::vec2:
+				skip(8);
+				break;
+
+			case telemetry_type::dvec2:
+				skip(16);
+				break;
+
+			case telemetry_type::string:
+				skip(read_uint8());
+				break;
+		}
+	}
+
+	telemetry_data_value read_value(telemetry_type type)
+	{
+		telemetry_data_value value;
+		value.type = type;
+
+		switch(type)
+		{
+			case telemetry_type::boolean:
+			{
+				value.b = read_bool();
+				break;
+			}
+
+			case telemetry_type::uint8:
+			{
+				value.u8 = read_uint8();
+				break;
+			}
+			case telemetry_type::uint16:
+			{
+				value.u16 = read_uint16();
+				break;
+			}
+			case telemetry_type::uint32:
+			{
+				value.u32 = read_uint32();
+				break;
+			}
+			case telemetry_type::uint64:
+			{
+				value.u64 = read_uint64();
+				break;
+			}
+
+
+			case telemetry_type::int32:
+			{
+				value.i32 = read_int32();
+				break;
+			}
+			case telemetry_type::int64:
+			{
+				value.i64 = read_int64();
+				break;
+			}
+
+			case telemetry_type::f32:
+			{
+				value.f32 = read_float();
+				break;
+			}
+			case telemetry_type::f64:
+			{
+				value.f64 = read_double();
+				break;
+			}
+
+			case telemetry_type::vec2:
+			{
+				value.vec2[0] = read_float();
+				value.vec2[1] = read_float();
+				break;
+			}
+			case telemetry_type::dvec2:
+			{
+				value.dvec2[0] = read_double();
+				value.dvec2[1] = read_double();
+				break;
+			}
+
+			case telemetry_type::string:
+			{
+				value.string = read_string();
+				break;
+			}
+		}
+
+		return value;
+	}
+
+	uint64_t read_varint()
+	{
+		uint64_t result = 0;
+
+		// A 64bit value needs at most 10 bytes, anything longer is corrupt data
+		for(uint32_t shift = 0; shift < 70; shift += 7)
+		{
+			const uint8_t byte = read_uint8();
+			result |= uint64_t(byte & 0x7f) << shift;
+
+			if(!(byte & 0x80))
+				return result;
+		}
+
+		throw std::invalid_argument("Malformed varint in telemetry data");
+	}
+	int64_t read_signed_varint()
+	{
+		const uint64_t value = read_varint();
+		return int64_t(value >> 1) ^ -int64_t(value & 0x1);
+	}
+
+private:
+	void require(size_t bytes) const
+	{
+		if(bytes > get_remaining())
+			throw telemetry_truncated_error();
+	}
+
+	const uint8_t *m_data;
+	const uint8_t *m_start;
+	const uint8_t *m_end;
+};
+
+struct file_writer
+{
+	const std::vector<uint8_t> &get_data() const { return m_data; }
+	std::vector<uint8_t> &get_data() { return m_data; }
+
+	size_t get_written() const { return m_data.size(); }
+
+	void write_bytes(const void *bytes, size_t size)
+	{
+		const uint8_t *data = static_cast<const uint8_t *>(bytes);
+		m_data.insert(m_data.end(), data, data + size);
+	}
+
+	void write_bool(bool value)
+	{
+		m_data.push_back(value ? 1 : 0);
+	}
+
+	void write_uint8(uint8_t value)
+	{
+		m_data.push_back(value);
+	}
+
+	void write_uint16(uint16_t value)
+	{
+		for(int i = 0; i < 2; i++)
+			m_data.push_back(uint8_t(value >> (i * 8)));
+	}
+
+	void write_uint32(uint32_t value)
+	{
+		for(int i = 0; i < 4; i++)
+			m_data.push_back(uint8_t(value >> (i * 8)));
+	}
+	void write_int32(int32_t value)
+	{
+		write_uint32(uint32_t(value));
+	}
+
+	void write_uint64(uint64_t value)
+	{
+		for(int i = 0; i < 8; i++)
+			m_data.push_back(uint8_t(value >> (i * 8)));
+	}
+	void write_int64(int64_t value)
+	{
+		write_uint64(uint64_t(value));
+	}
+
+	void write_float(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		write_uint32(bits);
+	}
+
+	void write_double(double value)
+	{
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		write_uint64(bits);
+	}
+
+	void write_string(const std::string &string)
+	{
+		const uint8_t length = uint8_t(std::min(string.size(), size_t(UINT8_MAX)));
+
+		m_data.push_back(length);
+		m_data.insert(m_data.end(), string.begin(), string.begin() + length);
+	}
+
+	void write_varint(uint64_t value)
+	{
+		while(value >= 0x80)
+		{
+			m_data.push_back(uint8_t(value) | 0x80);
+			value >>= 7;
+		}
+
+		m_data.push_back(uint8_t(value));
+	}
+	void write_signed_varint(int64_t value)
+	{
+		// Zig-zag encoding, so that small negative values also end up as short varints
+		write_varint((uint64_t(value) << 1) ^ uint64_t(value >> 63));
+	}
+
+	void write_value(const telemetry_data_value &value)
+	{
+		switch(value.type)
+		{
+			case telemetry_type::boolean:
+				write_bool(value.b);
+				break;
+
+			case telemetry_type::uint8:
+				write_uint8(value.u8);
+				break;
+			case telemetry_type::uint16:
+				write_uint16(value.u16);
+				break;
+			case telemetry_type::uint32:
+				write_uint32(value.u32);
+				break;
+			case telemetry_type::uint64:
+				write_uint64(value.u64);
+				break;
+
+			case telemetry_type::int32:
+				write_uint32(value.i32);
+				break;
+			case telemetry_type::int64:
+				write_uint64(value.i64);
+				break;
+
+			case telemetry_type::f32:
+				write_float(value.f32);
+				break;
+			case telemetry_type::f64:
+				write_double(value.f64);
+				break;
+
+			case telemetry_type::vec2:
+				write_float(value.vec2[0]);
+				write_float(value.vec2[1]);
+				break;
+			case telemetry_type::dvec2:
+				write_double(value.dvec2[0]);
+				write_double(value.dvec2[1]);
+				break;
+
+			case telemetry_type::string:
+				write_string(value.string);
+				break;
+		}
+	}
+
+private:
+	std::vector<uint8_t> m_data;
+};
+
+#endif //TELEMETRY_STREAM_H
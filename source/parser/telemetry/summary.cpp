@@ -0,0 +1,240 @@
+//
+//  summary.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <numeric>
+#include "summary.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TELEMETRY_SUMMARY_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define TELEMETRY_SUMMARY_NEON 1
+#endif
+
+struct value_extremes
+{
+	double sum = 0.0;
+	double minimum = 0.0;
+	double maximum = 0.0;
+};
+
+// Both kernels work on four values per iteration in two independent vector accumulators, the scalar loops pick up the remainder
+static value_extremes accumulate_extremes(const double *values, size_t count)
+{
+	value_extremes result;
+	result.minimum = values[0];
+	result.maximum = values[0];
+
+	size_t i = 0;
+
+#if TELEMETRY_SUMMARY_SSE2
+	if(count >= 4)
+	{
+		__m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+		__m128d min0 = _mm_set1_pd(values[0]), min1 = min0;
+		__m128d max0 = min0, max1 = min0;
+
+		for(; i + 4 <= count; i += 4)
+		{
+			const __m128d a = _mm_loadu_pd(values + i);
+			const __m128d b = _mm_loadu_pd(values + i + 2);
+
+			sum0 = _mm_add_pd(sum0, a);
+			sum1 = _mm_add_pd(sum1, b);
+			min0 = _mm_min_pd(min0, a);
+			min1 = _mm_min_pd(min1, b);
+			max0 = _mm_max_pd(max0, a);
+			max1 = _mm_max_pd(max1, b);
+		}
+
+		double lanes[2];
+
+		_mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+		result.sum = lanes[0] + lanes[1];
+
+		_mm_storeu_pd(lanes, _mm_min_pd(min0, min1));
+		result.minimum = std::min(lanes[0], lanes[1]);
+
+		_mm_storeu_pd(lanes, _mm_max_pd(max0, max1));
+		result.maximum = std::max(lanes[0], lanes[1]);
+	}
+#elif TELEMETRY_SUMMARY_NEON
+	if(count >= 4)
+	{
+		float64x2_t sum0 = vdupq_n_f64(0.0), sum1 = sum0;
+		float64x2_t min0 = vdupq_n_f64(values[0]), min1 = min0;
+		float64x2_t max0 = min0, max1 = min0;
+
+		for(; i + 4 <= count; i += 4)
+		{
+			const float64x2_t a = vld1q_f64(values + i);
+			const float64x2_t b = vld1q_f64(values + i + 2);
+
+			sum0 = vaddq_f64(sum0, a);
+			sum1 = vaddq_f64(sum1, b);
+			min0 = vminq_f64(min0, a);
+			min1 = vminq_f64(min1, b);
+			max0 = vmaxq_f64(max0, a);
+			max1 = vmaxq_f64(max1, b);
+		}
+
+		result.sum = vaddvq_f64(vaddq_f64(sum0, sum1));
+		result.minimum = vminvq_f64(vminq_f64(min0, min1));
+		result.maximum = vmaxvq_f64(vmaxq_f64(max0, max1));
+	}
+#endif
+
+	for(; i < count; ++ i)
+	{
+		result.sum += values[i];
+		result.minimum = std::min(result.minimum, values[i]);
+		result.maximum = std::max(result.maximum, values[i]);
+	}
+
+	return result;
+}
+
+static double accumulate_squared_deviations(const double *values, size_t count, double mean)
+{
+	double result = 0.0;
+	size_t i = 0;
+
+#if TELEMETRY_SUMMARY_SSE2
+	if(count >= 4)
+	{
+		const __m128d center = _mm_set1_pd(mean);
+		__m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+
+		for(; i + 4 <= count; i += 4)
+		{
+			const __m128d a = _mm_sub_pd(_mm_loadu_pd(values + i), center);
+			const __m128d b = _mm_sub_pd(_mm_loadu_pd(values + i + 2), center);
+
+			sum0 = _mm_add_pd(sum0, _mm_mul_pd(a, a));
+			sum1 = _mm_add_pd(sum1, _mm_mul_pd(b, b));
+		}
+
+		double lanes[2];
+		_mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+
+		result = lanes[0] + lanes[1];
+	}
+#elif TELEMETRY_SUMMARY_NEON
+	if(count >= 4)
+	{
+		const float64x2_t center = vdupq_n_f64(mean);
+		float64x2_t sum0 = vdupq_n_f64(0.0), sum1 = sum0;
+
+		for(; i + 4 <= count; i += 4)
+		{
+			const float64x2_t a = vsubq_f64(vld1q_f64(values + i), center);
+			const float64x2_t b = vsubq_f64(vld1q_f64(values + i + 2), center);
+
+			sum0 = vfmaq_f64(sum0, a, a);
+			sum1 = vfmaq_f64(sum1, b, b);
+		}
+
+		result = vaddvq_f64(vaddq_f64(sum0, sum1));
+	}
+#endif
+
+	for(; i < count; ++ i)
+	{
+		const double deviation = values[i] - mean;
+		result += deviation * deviation;
+	}
+
+	return result;
+}
+
+telemetry_summary summarize_telemetry_values(const double *values, size_t count, const std::vector<double> &weighted_percentiles)
+{
+	telemetry_summary summary;
+	summary.count = count;
+	summary.weighted_percentiles.resize(weighted_percentiles.size(), 0.0);
+
+	if(count == 0)
+		return summary;
+
+	const value_extremes extremes = accumulate_extremes(values, count);
+
+	summary.sum = extremes.sum;
+	summary.mean = extremes.sum / count;
+	summary.minimum = extremes.minimum;
+	summary.maximum = extremes.maximum;
+	summary.variance = accumulate_squared_deviations(values, count, summary.mean) / count;
+
+	if(weighted_percentiles.empty())
+		return summary;
+
+	// Answering the requests in ascending order lets them all share one walk over the running sum
+	std::vector<size_t> order(weighted_percentiles.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+		return weighted_percentiles[lhs] < weighted_percentiles[rhs];
+	});
+
+	size_t next = 0;
+	double running_sum = 0.0;
+
+	for(size_t i = 0; i < count && next < order.size(); ++ i)
+	{
+		while(next < order.size() && running_sum >= summary.sum * weighted_percentiles[order[next]])
+			summary.weighted_percentiles[order[next ++]] = values[i];
+
+		running_sum += values[i];
+	}
+
+	for(; next < order.size(); ++ next)
+		summary.weighted_percentiles[order[next]] = values[count - 1];
+
+	return summary;
+}
+
+
+telemetry_sorted_values::telemetry_sorted_values(std::vector<double> &&values) :
+	m_values(std::move(values))
+{
+	std::sort(m_values.begin(), m_values.end());
+
+	m_prefix_sums.resize(m_values.size());
+	std::partial_sum(m_values.begin(), m_values.end(), m_prefix_sums.begin());
+
+	m_summary = summarize_telemetry_values(m_values.data(), m_values.size());
+}
+
+double telemetry_sorted_values::get_weighted_percentile(double percentile) const
+{
+	if(m_values.empty())
+		return 0.0;
+
+	const double needle = m_prefix_sums.back() * percentile;
+
+	// The first value whose exclusive prefix sum reaches the needle, which is one past the first inclusive prefix sum that does
+	if(needle <= 0.0)
+		return m_values.front();
+
+	const size_t index = std::lower_bound(m_prefix_sums.begin(), m_prefix_sums.end(), needle) - m_prefix_sums.begin() + 1;
+
+	if(index >= m_values.size())
+		return m_values.back();
+
+	return m_values[index];
+}
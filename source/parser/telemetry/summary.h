@@ -0,0 +1,66 @@
+//
+//  summary.h
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef TELEMETRY_SUMMARY_H
+#define TELEMETRY_SUMMARY_H
+
+#include <cstddef>
+#include <vector>
+
+struct telemetry_summary
+{
+	size_t count = 0;
+
+	double sum = 0.0;
+	double mean = 0.0;
+	double variance = 0.0; // Population variance
+	double minimum = 0.0;
+	double maximum = 0.0;
+
+	std::vector<double> weighted_percentiles; // In the order they were requested
+};
+
+// Summarizes a contiguous column of values in two vectorized passes, one for the sum and the extremes and one for the variance around the mean.
+// Time weighted percentiles are the first value at which the running sum of all values before it reaches percentile * sum, which weighs every
+// sample by its value the way frame times add up to the time spent in them. They need the values sorted in ascending order and are all answered
+// by a single shared walk over the running sum, no matter how many are requested
+telemetry_summary summarize_telemetry_values(const double *values, size_t count, const std::vector<double> &weighted_percentiles = {});
+
+// Values sorted in ascending order with their prefix sums, for callers that query time weighted percentiles one at a time.
+// Every query is a binary search into the shared prefix sums instead of a walk over the values
+class telemetry_sorted_values
+{
+public:
+	telemetry_sorted_values() = default;
+	explicit telemetry_sorted_values(std::vector<double> &&values);
+
+	bool empty() const { return m_values.empty(); }
+	size_t size() const { return m_values.size(); }
+
+	const std::vector<double> &get_values() const { return m_values; }
+	const telemetry_summary &get_summary() const { return m_summary; }
+
+	double get_weighted_percentile(double percentile) const; // Returns 0.0 if there are no values
+
+private:
+	std::vector<double> m_values;
+	std::vector<double> m_prefix_sums; // Inclusive
+	telemetry_summary m_summary;
+};
+
+#endif //TELEMETRY_SUMMARY_H
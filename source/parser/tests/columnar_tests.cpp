@@ -0,0 +1,142 @@
+//
+//  columnar_tests.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <limits>
+#include <telemetry/columnar.h>
+#include <telemetry/parser.h>
+#include "test.h"
+
+static telemetry_container create_container()
+{
+	telemetry_container container(2);
+	telemetry_provider provider(1, 1, "com.laminarresearch.test", "Test");
+
+	telemetry_field time(0, 1, "Frame time", telemetry_type::f64, telemetry_unit::time);
+	telemetry_field counter(1, 1, "Counter", telemetry_type::int32, telemetry_unit::value);
+	telemetry_field irregular(2, 1, "Irregular", telemetry_type::f64, telemetry_unit::value);
+	telemetry_field empty(3, 1, "Empty", telemetry_type::f64, telemetry_unit::value);
+
+	std::vector<telemetry_data_point> time_points;
+	std::vector<telemetry_data_point> counter_points;
+	std::vector<telemetry_data_point> irregular_points;
+
+	// More than two chunks, time and counter share their timestamps
+	for(int32_t i = 0; i < 10000; ++ i)
+	{
+		time_points.push_back(make_data_point(i * 16667, 0.016 + (i % 17) * 0.0001));
+		counter_points.push_back(make_data_point(i * 16667, -5000 + i * 3));
+		irregular_points.push_back(make_data_point(i * 16667 + (i * i) % 1000, std::sin(i * 0.01)));
+	}
+
+	time.set_data_points(std::move(time_points));
+	counter.set_data_points(std::move(counter_points));
+	irregular.set_data_points(std::move(irregular_points));
+
+	provider.add_field(std::move(time));
+	provider.add_field(std::move(counter));
+	provider.add_field(std::move(irregular));
+	provider.add_field(std::move(empty));
+
+	container.add_provider(std::move(provider));
+
+	return container;
+}
+
+static void check_same_fields(const telemetry_container &expected, const telemetry_container &actual)
+{
+	const telemetry_time start(std::numeric_limits<int64_t>::min());
+	const telemetry_time end(std::numeric_limits<int64_t>::max());
+
+	for(auto &provider : expected.get_providers())
+	{
+		TLM_CHECK(actual.has_provider(provider.get_identifier()));
+		auto &actual_provider = actual.get_provider(provider.get_identifier());
+
+		for(auto &field : provider.get_fields())
+		{
+			auto &actual_field = actual_provider.get_field(field.get_id());
+
+			TLM_CHECK(actual_field.get_title() == field.get_title());
+			TLM_CHECK(actual_field.get_type() == field.get_type());
+			TLM_CHECK(actual_field.get_unit() == field.get_unit());
+
+			const std::vector<telemetry_data_point> expected_points = field.get_data_points_in_range(start, end);
+			const std::vector<telemetry_data_point> actual_points = actual_field.get_data_points_in_range(start, end);
+
+			TLM_CHECK(actual_points.size() == expected_points.size());
+
+			for(size_t i = 0; i < expected_points.size(); ++ i)
+				TLM_CHECK(is_same_data_point(expected_points[i], actual_points[i]));
+		}
+	}
+}
+
+TLM_TEST(columnar_round_trips_fields)
+{
+	const telemetry_container container = create_container();
+	const std::vector<uint8_t> data = write_columnar_telemetry(container);
+
+	check_same_fields(container, parse_telemetry_data(data.data(), data.size(), {}));
+}
+
+TLM_TEST(columnar_round_trips_compressed_fields)
+{
+	telemetry_container container = create_container();
+
+	for(auto &field : container.get_providers().front().get_fields())
+		field.compress();
+
+	TLM_CHECK(container.get_providers().front().get_field(0).get_encoding() == telemetry_field_encoding::compressed);
+
+	const std::vector<uint8_t> data = write_columnar_telemetry(container);
+	check_same_fields(create_container(), parse_telemetry_data(data.data(), data.size(), {}));
+}
+
+TLM_TEST(columnar_refuses_compacted_fields)
+{
+	telemetry_container container = create_container();
+	telemetry_field &field = container.get_providers().front().get_field(1);
+
+	std::vector<telemetry_data_point> data_points;
+
+	for(int32_t i = 0; i < 1000; ++ i)
+		data_points.push_back(make_data_point(i * 1000, i / 100));
+
+	field.set_data_points(std::move(data_points));
+	field.compact();
+
+	TLM_CHECK(field.get_encoding() == telemetry_field_encoding::runs);
+	TLM_CHECK_THROWS(write_columnar_telemetry(container), std::invalid_argument);
+}
+
+TLM_TEST(columnar_rejects_truncated_files)
+{
+	const std::vector<uint8_t> data = write_columnar_telemetry(create_container());
+
+	// The footer is at the end, so unlike TLMv2 captures a cut off columnar file has nothing to recover
+	for(size_t size : { size_t(0), size_t(7), size_t(20), data.size() / 2, data.size() - 1 })
+		TLM_CHECK_THROWS(parse_telemetry_data(data.data(), size, {}), std::invalid_argument);
+}
+
+TLM_TEST(columnar_converts_the_sample_capture)
+{
+	const std::vector<uint8_t> &capture = get_sample_capture();
+	const std::vector<uint8_t> data = convert_telemetry_to_columnar(capture.data(), capture.size());
+
+	check_same_fields(parse_telemetry_data(capture.data(), capture.size(), {}), parse_telemetry_data(data.data(), data.size(), {}));
+}
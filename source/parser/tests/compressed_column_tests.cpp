@@ -0,0 +1,161 @@
+//
+//  compressed_column_tests.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <telemetry/compressed_column.h>
+#include <telemetry/provider.h>
+#include "test.h"
+
+// Frame times with jittered timestamps, repeats, a gap and the special values
+static std::vector<telemetry_data_point> create_frame_times(size_t count)
+{
+	std::mt19937 random(3);
+	std::vector<telemetry_data_point> data_points;
+
+	int64_t ticks = 1000;
+
+	for(size_t i = 0; i < count; ++ i)
+	{
+		double value = 0.016 + std::uniform_real_distribution<double>(-0.002, 0.002)(random);
+
+		if(i % 100 < 10)
+			value = 0.0166;
+		if(i == 500)
+			value = std::numeric_limits<double>::quiet_NaN();
+		if(i == 501)
+			value = -std::numeric_limits<double>::infinity();
+
+		data_points.push_back(make_data_point(ticks, value));
+
+		ticks += 16667 + int64_t(random() % 200);
+
+		if(i == 3000)
+			ticks += 10 * telemetry_time::ticks_per_second;
+	}
+
+	return data_points;
+}
+
+TLM_TEST(compressed_column_round_trips_doubles)
+{
+	const std::vector<telemetry_data_point> data_points = create_frame_times(5000);
+	const telemetry_compressed_column column(telemetry_type::f64, data_points);
+
+	TLM_CHECK(column.size() == data_points.size());
+	TLM_CHECK(column.get_memory_usage() < data_points.size() * sizeof(telemetry_data_point) / 4);
+
+	const std::vector<telemetry_data_point> result = column.decompress();
+	TLM_CHECK(result.size() == data_points.size());
+
+	for(size_t i = 0; i < data_points.size(); ++ i)
+	{
+		TLM_CHECK(is_same_data_point(result[i], data_points[i]));
+		TLM_CHECK(is_same_data_point(column.get_data_point(i), data_points[i]));
+	}
+}
+
+TLM_TEST(compressed_column_round_trips_floats)
+{
+	std::vector<telemetry_data_point> data_points;
+
+	for(int32_t i = 0; i < 3000; ++ i)
+	{
+		telemetry_data_point data;
+		data.timestamp = telemetry_time(int64_t(i) * 33333);
+		data.value.type = telemetry_type::f32;
+		data.value.f32 = float(i / 7) * 0.5f - 100.0f;
+
+		data_points.push_back(data);
+	}
+
+	const std::vector<telemetry_data_point> result = telemetry_compressed_column(telemetry_type::f32, data_points).decompress();
+	TLM_CHECK(result.size() == data_points.size());
+
+	for(size_t i = 0; i < data_points.size(); ++ i)
+		TLM_CHECK(is_same_data_point(result[i], data_points[i]));
+}
+
+TLM_TEST(compressed_column_finds_ranges)
+{
+	const std::vector<telemetry_data_point> data_points = create_frame_times(5000);
+	const telemetry_compressed_column column(telemetry_type::f64, data_points);
+
+	const telemetry_time last = data_points.back().timestamp;
+
+	for(int64_t ticks = -1000; ticks < last.ticks + 1000; ticks += 123457)
+	{
+		const telemetry_time start(ticks);
+		const telemetry_time end(ticks + 2 * telemetry_time::ticks_per_second);
+
+		const auto lower = std::lower_bound(data_points.begin(), data_points.end(), start, [](const telemetry_data_point &data, telemetry_time time) {
+			return data.timestamp < time;
+		});
+
+		TLM_CHECK(column.lower_bound(start) == size_t(lower - data_points.begin()));
+
+		size_t index = lower - data_points.begin();
+
+		column.for_each_in_range(start, end, [&](const telemetry_data_point &data) {
+			TLM_CHECK(index < data_points.size() && is_same_data_point(data, data_points[index]));
+			index ++;
+		});
+
+		TLM_CHECK(index == data_points.size() || data_points[index].timestamp > end);
+	}
+}
+
+TLM_TEST(compressed_column_rejects_unsupported_types)
+{
+	TLM_CHECK(!telemetry_compressed_column::is_supported_type(telemetry_type::int32));
+	TLM_CHECK(!telemetry_compressed_column::is_supported_type(telemetry_type::string));
+	TLM_CHECK_THROWS(telemetry_compressed_column(telemetry_type::int32, { make_data_point(0, 1) }), std::invalid_argument);
+}
+
+TLM_TEST(compressed_column_backs_field_queries)
+{
+	telemetry_field samples(0, 1, "Frame time", telemetry_type::f64, telemetry_unit::time);
+	samples.set_data_points(create_frame_times(5000));
+
+	telemetry_field compressed(0, 1, "Frame time", telemetry_type::f64, telemetry_unit::time);
+	compressed.set_data_points(create_frame_times(5000));
+	compressed.compress();
+
+	TLM_CHECK(compressed.get_encoding() == telemetry_field_encoding::compressed);
+	TLM_CHECK(compressed.get_sample_count() == samples.get_sample_count());
+	TLM_CHECK_THROWS(compressed.get_data_points(), std::invalid_argument);
+
+	for(int64_t ticks = 0; ticks < 60 * telemetry_time::ticks_per_second; ticks += 777777)
+	{
+		const telemetry_time time(ticks);
+
+		TLM_CHECK(is_same_data_point(compressed.get_data_point_closest_to_time(time), samples.get_data_point_closest_to_time(time)));
+		TLM_CHECK(compressed.get_index_closest_to_time(time) == samples.get_index_closest_to_time(time));
+
+		const telemetry_time end = time + telemetry_time::from_seconds(1.5);
+
+		const std::vector<telemetry_data_point> expected = samples.get_data_points_in_range(time, end);
+		const std::vector<telemetry_data_point> actual = compressed.get_data_points_in_range(time, end);
+
+		TLM_CHECK(actual.size() == expected.size());
+
+		for(size_t i = 0; i < expected.size(); ++ i)
+			TLM_CHECK(is_same_data_point(actual[i], expected[i]));
+	}
+}
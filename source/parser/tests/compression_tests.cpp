@@ -0,0 +1,104 @@
+//
+//  compression_tests.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <random>
+#include <telemetry/compression.h>
+#include "test.h"
+
+static std::vector<uint8_t> round_trip(const std::vector<uint8_t> &data)
+{
+	const std::vector<uint8_t> compressed = compress_telemetry_block(data.data(), data.size());
+
+	std::vector<uint8_t> result(data.size());
+	decompress_telemetry_block(compressed.data(), compressed.size(), result.data(), result.size());
+
+	return result;
+}
+
+TLM_TEST(compression_round_trips_random_data)
+{
+	std::mt19937 random(1);
+	std::vector<uint8_t> data(100000);
+
+	for(auto &byte : data)
+		byte = uint8_t(random());
+
+	TLM_CHECK(round_trip(data) == data);
+}
+
+TLM_TEST(compression_shrinks_repetitive_data)
+{
+	std::vector<uint8_t> data(100000);
+
+	for(size_t i = 0; i < data.size(); ++ i)
+		data[i] = uint8_t((i / 7) % 5);
+
+	const std::vector<uint8_t> compressed = compress_telemetry_block(data.data(), data.size());
+	TLM_CHECK(compressed.size() < data.size() / 10);
+
+	TLM_CHECK(round_trip(data) == data);
+}
+
+TLM_TEST(compression_round_trips_short_blocks)
+{
+	for(size_t size = 0; size < 64; ++ size)
+	{
+		std::vector<uint8_t> data(size, uint8_t(size));
+		TLM_CHECK(round_trip(data) == data);
+	}
+}
+
+TLM_TEST(compression_reuses_the_match_table)
+{
+	telemetry_block_compressor compressor;
+	std::mt19937 random(2);
+
+	// Matches must never reach into the blocks compressed before
+	for(size_t block = 0; block < 32; ++ block)
+	{
+		std::vector<uint8_t> data(1000 + block * 100);
+
+		for(size_t i = 0; i < data.size(); ++ i)
+			data[i] = (block % 2) ? uint8_t(random()) : uint8_t(i % 13);
+
+		const std::vector<uint8_t> compressed = compressor.compress(data.data(), data.size());
+
+		std::vector<uint8_t> result(data.size());
+		decompress_telemetry_block(compressed.data(), compressed.size(), result.data(), result.size());
+
+		TLM_CHECK(result == data);
+	}
+}
+
+TLM_TEST(compression_rejects_corrupt_blocks)
+{
+	std::vector<uint8_t> data(10000);
+
+	for(size_t i = 0; i < data.size(); ++ i)
+		data[i] = uint8_t(i % 11);
+
+	const std::vector<uint8_t> compressed = compress_telemetry_block(data.data(), data.size());
+	std::vector<uint8_t> result(data.size());
+
+	TLM_CHECK_THROWS(decompress_telemetry_block(compressed.data(), compressed.size() / 2, result.data(), result.size()), std::invalid_argument);
+	TLM_CHECK_THROWS(decompress_telemetry_block(compressed.data(), compressed.size(), result.data(), result.size() - 1), std::invalid_argument);
+
+	// Offsets that point before the start of the output
+	const uint8_t bad_offset[] = { 0x0f, 0xff, 0x00 };
+	TLM_CHECK_THROWS(decompress_telemetry_block(bad_offset, sizeof(bad_offset), result.data(), result.size()), std::invalid_argument);
+}
@@ -0,0 +1,122 @@
+//
+//  correlation_tests.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <random>
+#include <telemetry/correlation.h>
+#include <telemetry/resample.h>
+#include "test.h"
+
+static std::vector<double> create_noise(size_t count, uint32_t seed)
+{
+	std::mt19937 random(seed);
+	std::vector<double> values(count);
+
+	for(auto &value : values)
+		value = std::normal_distribution<double>(0.0, 1.0)(random);
+
+	return values;
+}
+
+TLM_TEST(correlation_detects_linear_and_monotonic_relations)
+{
+	const std::vector<double> a = create_noise(1000, 9);
+
+	std::vector<double> linear(a.size());
+	std::vector<double> inverse(a.size());
+	std::vector<double> cubic(a.size());
+
+	for(size_t i = 0; i < a.size(); ++ i)
+	{
+		linear[i] = 3.0 * a[i] + 7.0;
+		inverse[i] = -a[i];
+		cubic[i] = a[i] * a[i] * a[i];
+	}
+
+	const telemetry_correlation_series series(a);
+
+	const telemetry_correlation with_linear = correlate_telemetry_series(series, telemetry_correlation_series(linear), 0);
+	TLM_CHECK_NEAR(with_linear.pearson, 1.0, 1e-9);
+	TLM_CHECK_NEAR(with_linear.spearman, 1.0, 1e-9);
+	TLM_CHECK(with_linear.lags.size() == 1);
+
+	const telemetry_correlation with_inverse = correlate_telemetry_series(series, telemetry_correlation_series(inverse), 0);
+	TLM_CHECK_NEAR(with_inverse.pearson, -1.0, 1e-9);
+	TLM_CHECK_NEAR(with_inverse.spearman, -1.0, 1e-9);
+
+	// Ranks don't care about the shape, only the order
+	const telemetry_correlation with_cubic = correlate_telemetry_series(series, telemetry_correlation_series(cubic), 0);
+	TLM_CHECK(with_cubic.pearson < 0.95);
+	TLM_CHECK_NEAR(with_cubic.spearman, 1.0, 1e-9);
+
+	const telemetry_correlation with_noise = correlate_telemetry_series(series, telemetry_correlation_series(create_noise(1000, 10)), 0);
+	TLM_CHECK(std::abs(with_noise.pearson) < 0.1);
+}
+
+TLM_TEST(correlation_finds_the_lag)
+{
+	const std::vector<double> noise = create_noise(2000, 11);
+
+	// b follows a by 25 grid points
+	const std::vector<double> a(noise.begin() + 100, noise.begin() + 1100);
+	const std::vector<double> b(noise.begin() + 75, noise.begin() + 1075);
+
+	const telemetry_correlation correlation = correlate_telemetry_series(telemetry_correlation_series(a), telemetry_correlation_series(b), 50);
+
+	TLM_CHECK(correlation.lags.size() == 101);
+	TLM_CHECK(correlation.peak_lag == 25);
+	TLM_CHECK_NEAR(correlation.peak_correlation, 1.0, 1e-9);
+	TLM_CHECK_NEAR(correlation.lags[50 + 25], 1.0, 1e-9);
+
+	// Clamped to half of the series
+	TLM_CHECK(correlate_telemetry_series(telemetry_correlation_series(a), telemetry_correlation_series(b), 100000).lags.size() == 1001);
+}
+
+TLM_TEST(correlation_of_constant_series_is_nan)
+{
+	const telemetry_correlation_series constant(std::vector<double>(100, 4.0));
+	const telemetry_correlation_series noise(create_noise(100, 12));
+
+	TLM_CHECK(constant.is_constant());
+	TLM_CHECK(!noise.is_constant());
+
+	const telemetry_correlation correlation = correlate_telemetry_series(constant, noise, 5);
+
+	TLM_CHECK(std::isnan(correlation.pearson));
+	TLM_CHECK(std::isnan(correlation.spearman));
+	TLM_CHECK_THROWS(correlate_telemetry_series(noise, telemetry_correlation_series(create_noise(99, 13)), 5), std::invalid_argument);
+}
+
+TLM_TEST(resample_holds_and_averages_samples)
+{
+	const double timestamps[] = { 1.0, 1.2, 1.4, 3.5, 3.6 };
+	const double values[] = { 10.0, 20.0, 30.0, 40.0, 50.0 };
+
+	const telemetry_time_grid grid = telemetry_time_grid::from_range(0.0, 5.0, 1.0);
+	TLM_CHECK(grid.count == 5);
+
+	// Grid points before the first sample take its value
+	const std::vector<double> hold = resample_telemetry_values(timestamps, values, 5, grid, telemetry_resample_mode::hold);
+	TLM_CHECK(hold == std::vector<double>({ 10.0, 10.0, 30.0, 30.0, 50.0 }));
+
+	// Empty cells keep the value of the last sample before them
+	const std::vector<double> mean = resample_telemetry_values(timestamps, values, 5, grid, telemetry_resample_mode::mean);
+	TLM_CHECK(mean == std::vector<double>({ 10.0, 20.0, 30.0, 45.0, 50.0 }));
+
+	TLM_CHECK_THROWS(resample_telemetry_values(timestamps, values, 0, grid, telemetry_resample_mode::hold), std::invalid_argument);
+	TLM_CHECK_THROWS(telemetry_time_grid::from_range(0.0, 1.0, 0.0), std::invalid_argument);
+}
@@ -0,0 +1,154 @@
+//
+//  data_tests.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <limits>
+#include <telemetry/parser.h>
+#include "test.h"
+
+TLM_TEST(time_rounds_seconds_to_the_nearest_tick)
+{
+	TLM_CHECK(telemetry_time::from_seconds(0.0).ticks == 0);
+	TLM_CHECK(telemetry_time::from_seconds(1.0).ticks == 1000000);
+	TLM_CHECK(telemetry_time::from_seconds(0.1).ticks == 100000);
+	TLM_CHECK(telemetry_time::from_seconds(0.0000004).ticks == 0);
+	TLM_CHECK(telemetry_time::from_seconds(0.0000006).ticks == 1);
+
+	// Symmetric around zero, so that aligned timelines with negative offsets round the same way
+	TLM_CHECK(telemetry_time::from_seconds(-0.1).ticks == -100000);
+	TLM_CHECK(telemetry_time::from_seconds(-0.0000006).ticks == -1);
+
+	// Microsecond ticks stay exact far beyond the length of any recording
+	const telemetry_time week = telemetry_time::from_seconds(7 * 24 * 3600.0 + 0.000001);
+	TLM_CHECK(week.ticks == int64_t(7) * 24 * 3600 * 1000000 + 1);
+	TLM_CHECK(telemetry_time::from_seconds(week.to_seconds()) == week);
+}
+
+TLM_TEST(time_arithmetic_is_exact)
+{
+	telemetry_time time = telemetry_time::from_seconds(0.1);
+
+	for(int i = 0; i < 9; ++ i)
+		time += telemetry_time::from_seconds(0.1);
+
+	TLM_CHECK(time == telemetry_time::from_seconds(1.0));
+	TLM_CHECK(time - telemetry_time::from_seconds(0.25) == telemetry_time(750000));
+	TLM_CHECK(-time < telemetry_time());
+}
+
+TLM_TEST(time_orders_the_data_points_of_the_sample_capture)
+{
+	const std::vector<uint8_t> &capture = get_sample_capture();
+	const telemetry_container container = parse_telemetry_data(capture.data(), capture.size(), {});
+
+	const telemetry_time start(std::numeric_limits<int64_t>::min());
+	const telemetry_time end(std::numeric_limits<int64_t>::max());
+
+	for(auto &provider : container.get_providers())
+	{
+		for(auto &field : provider.get_fields())
+		{
+			const std::vector<telemetry_data_point> data_points = field.get_data_points_in_range(start, end);
+
+			for(size_t i = 1; i < data_points.size(); ++ i)
+				TLM_CHECK(data_points[i - 1].timestamp <= data_points[i].timestamp);
+
+			if(!data_points.empty())
+			{
+				TLM_CHECK(data_points.front().timestamp >= container.get_start_time());
+				TLM_CHECK(data_points.back().timestamp <= container.get_end_time());
+			}
+		}
+	}
+}
+
+TLM_TEST(value_converts_numeric_types)
+{
+	telemetry_data_value value;
+
+	value.type = telemetry_type::boolean;
+	value.b = true;
+	TLM_CHECK(value.get<double>() == 1.0);
+
+	value.type = telemetry_type::uint16;
+	value.u16 = 60000;
+	TLM_CHECK(value.get<int64_t>() == 60000);
+
+	value.type = telemetry_type::uint64;
+	value.u64 = uint64_t(1) << 40;
+	TLM_CHECK(value.get<double>() == 1099511627776.0);
+
+	value.type = telemetry_type::f32;
+	value.f32 = 2.5f;
+	TLM_CHECK(value.get<double>() == 2.5);
+	TLM_CHECK(value.get<int32_t>() == 2);
+
+	value.type = telemetry_type::f64;
+	value.f64 = -0.25;
+	TLM_CHECK(value.try_get<double>() == -0.25);
+	TLM_CHECK(!value.try_get<std::string>());
+}
+
+TLM_TEST(value_refuses_unsupported_conversions)
+{
+	telemetry_data_value value;
+	value.type = telemetry_type::string;
+	value.string = "Cessna";
+
+	TLM_CHECK(!value.can_convert_to<double>());
+	TLM_CHECK(!value.try_get<double>());
+	TLM_CHECK_THROWS(value.get<double>(), std::runtime_error);
+	TLM_CHECK(value.get<std::string>() == "Cessna");
+
+	value.type = telemetry_type::dvec2;
+	TLM_CHECK(!value.try_get<double>());
+	TLM_CHECK(!value.try_get<std::string>());
+
+	static_assert(is_telemetry_type_convertible<float>(telemetry_type::int64));
+	static_assert(!is_telemetry_type_convertible<float>(telemetry_type::vec2));
+}
+
+TLM_TEST(value_dispatches_on_the_type)
+{
+	for(telemetry_type type : { telemetry_type::uint8, telemetry_type::int32, telemetry_type::f64, telemetry_type::string, telemetry_type::dvec2 })
+	{
+		const telemetry_type visited = visit_telemetry_type(type, [](auto tag) {
+			return decltype(tag)::value;
+		});
+
+		TLM_CHECK(visited == type);
+	}
+
+	// Kernels resolve the type once and then read every value with get_as()
+	telemetry_data_value value;
+	value.type = telemetry_type::uint32;
+	value.u32 = 123456;
+
+	const double result = visit_telemetry_type(value.type, [&](auto tag) -> double {
+
+		constexpr telemetry_type Type = decltype(tag)::value;
+
+		if constexpr (is_telemetry_type_convertible<double>(Type))
+			return value.get_as<double, Type>();
+		else
+			return 0.0;
+
+	});
+
+	TLM_CHECK(result == 123456.0);
+	TLM_CHECK_THROWS(visit_telemetry_type(static_cast<telemetry_type>(99), [](auto) { return 0; }), std::invalid_argument);
+}
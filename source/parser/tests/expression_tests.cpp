@@ -0,0 +1,142 @@
+//
+//  expression_tests.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <limits>
+#include <telemetry/expression.h>
+#include "test.h"
+
+static bool fails_at(const std::string &source, size_t position)
+{
+	try
+	{
+		telemetry_expression expression(source);
+	}
+	catch(const std::invalid_argument &e)
+	{
+		return std::string(e.what()).ends_with("at position " + std::to_string(position));
+	}
+
+	return false;
+}
+
+TLM_TEST(expression_collects_references)
+{
+	const telemetry_expression expression("Frame_Time * 1000 + gpu@2 - frame_time + GPU");
+	const std::vector<telemetry_expression_reference> &references = expression.get_references();
+
+	// Deduplicated by normalized name and document, in the order they first appear
+	TLM_CHECK(references.size() == 3);
+	TLM_CHECK((references[0] == telemetry_expression_reference{ "frame_time", 0 }));
+	TLM_CHECK((references[1] == telemetry_expression_reference{ "gpu", 2 }));
+	TLM_CHECK((references[2] == telemetry_expression_reference{ "gpu", 0 }));
+
+	TLM_CHECK(telemetry_expression::normalize_name("Cloud Update (GPU)") == "cloud_update_gpu");
+	TLM_CHECK(telemetry_expression::normalize_name("  FPS  ") == "fps");
+}
+
+TLM_TEST(expression_tracks_whether_it_keeps_the_unit)
+{
+	TLM_CHECK(telemetry_expression("cpu + gpu - 0.001").is_additive());
+	TLM_CHECK(telemetry_expression("-max(cpu, gpu) + abs(delta(cpu))").is_additive());
+	TLM_CHECK(!telemetry_expression("cpu * 2").is_additive());
+	TLM_CHECK(!telemetry_expression("1 / time").is_additive());
+	TLM_CHECK(!telemetry_expression("sqrt(cpu)").is_additive());
+}
+
+TLM_TEST(expression_evaluates_like_scalar_code)
+{
+	// Several blocks with a partial one at the end, so that delta() has to carry its previous value across blocks
+	const size_t count = 1500;
+
+	std::vector<double> a(count);
+	std::vector<double> b(count);
+
+	for(size_t i = 0; i < count; ++ i)
+	{
+		a[i] = std::sin(i * 0.1) * 10.0;
+		b[i] = 1.0 + (i % 13);
+	}
+
+	const telemetry_expression expression("min(a, b) * 2 + abs(-a) - sqrt(b) / (4 - 1) + delta(a * b)");
+	const std::vector<double> result = expression.evaluate({ a.data(), b.data() }, count);
+
+	TLM_CHECK(result.size() == count);
+	TLM_CHECK(std::isnan(result[0]));
+
+	for(size_t i = 1; i < count; ++ i)
+	{
+		const double expected = std::min(a[i], b[i]) * 2 + std::abs(-a[i]) - std::sqrt(b[i]) / (4 - 1) + (a[i] * b[i] - a[i - 1] * b[i - 1]);
+		TLM_CHECK_NEAR(result[i], expected, 1e-12);
+	}
+}
+
+TLM_TEST(expression_turns_division_by_zero_into_nan)
+{
+	const std::vector<double> a = { 1.0, 2.0, 0.0 };
+	const std::vector<double> b = { 0.0, 4.0, 0.0 };
+
+	const std::vector<double> result = telemetry_expression("a / b").evaluate({ a.data(), b.data() }, a.size());
+
+	TLM_CHECK(std::isnan(result[0]));
+	TLM_CHECK(result[1] == 0.5);
+	TLM_CHECK(std::isnan(result[2]));
+
+	TLM_CHECK_THROWS(telemetry_expression("a / b").evaluate({ a.data() }, a.size()), std::invalid_argument);
+}
+
+TLM_TEST(expression_reports_syntax_errors)
+{
+	TLM_CHECK(fails_at("a +", 4));
+	TLM_CHECK(fails_at("a + )", 5));
+	TLM_CHECK(fails_at("(a + b", 7));
+	TLM_CHECK(fails_at("a b", 3));
+	TLM_CHECK(fails_at("a + foo(b)", 5));
+	TLM_CHECK(fails_at("min(a)", 6));
+	TLM_CHECK(fails_at("a@", 3));
+	TLM_CHECK(fails_at("a@99999999999", 3));
+
+	TLM_CHECK_THROWS(telemetry_expression("1 + 2"), std::invalid_argument);
+	TLM_CHECK_THROWS(telemetry_expression(""), std::invalid_argument);
+}
+
+TLM_TEST(expression_limits_nesting)
+{
+	const auto nest = [](size_t depth, const std::string &open, const std::string &close) {
+
+		std::string result;
+
+		for(size_t i = 0; i < depth; ++ i)
+			result += open;
+
+		result += "a";
+
+		for(size_t i = 0; i < depth; ++ i)
+			result += close;
+
+		return result;
+
+	};
+
+	TLM_CHECK(telemetry_expression(nest(200, "(", ")")).get_references().size() == 1);
+	TLM_CHECK(telemetry_expression(nest(200, "abs(", ")")).get_references().size() == 1);
+
+	// Deep enough to overflow the stack if the parser recursed without a limit
+	TLM_CHECK_THROWS(telemetry_expression(nest(100000, "(", ")")), std::invalid_argument);
+	TLM_CHECK_THROWS(telemetry_expression(nest(100000, "-", "")), std::invalid_argument);
+	TLM_CHECK_THROWS(telemetry_expression(nest(100000, "sqrt(", ")")), std::invalid_argument);
+}
@@ -0,0 +1,133 @@
+//
+//  field_tests.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <telemetry/provider.h>
+#include "test.h"
+
+// A state that holds its value for 50 samples at a time, with a single sample blip every 400 samples
+static telemetry_field create_state_field(telemetry_unit unit)
+{
+	telemetry_field field(0, 1, "State", telemetry_type::int32, unit);
+
+	std::vector<telemetry_data_point> data_points;
+
+	for(int32_t i = 0; i < 2000; ++ i)
+		data_points.push_back(make_data_point(i * 1000, (i % 400 == 399) ? -1 : i / 50));
+
+	field.set_data_points(std::move(data_points));
+
+	return field;
+}
+
+// Consecutive repeats removed, which is all a compacted field can still tell apart
+static std::vector<uint32_t> get_value_changes(const std::vector<telemetry_data_point> &data_points)
+{
+	std::vector<uint32_t> result;
+
+	for(auto &data : data_points)
+	{
+		if(result.empty() || result.back() != data.value.i32)
+			result.push_back(data.value.i32);
+	}
+
+	return result;
+}
+
+TLM_TEST(field_compacts_runs_of_values)
+{
+	telemetry_field field = create_state_field(telemetry_unit::value);
+	field.compact();
+
+	TLM_CHECK(field.get_encoding() == telemetry_field_encoding::runs);
+	TLM_CHECK(field.get_sample_count() == 2000);
+	TLM_CHECK(field.get_data_point_count() < 2000 / 4);
+
+	// Keeps the first and the last sample of every run
+	TLM_CHECK(field.get_data_point(0).timestamp == telemetry_time(0));
+	TLM_CHECK(field.get_data_point(field.get_data_point_count() - 1).timestamp == telemetry_time(1999 * 1000));
+}
+
+TLM_TEST(field_keeps_statistics_fields_as_samples)
+{
+	telemetry_field time = create_state_field(telemetry_unit::time);
+	time.compact();
+
+	TLM_CHECK(time.get_encoding() == telemetry_field_encoding::samples);
+	TLM_CHECK(time.get_data_point_count() == 2000);
+
+	// Values that change with every sample don't shrink enough to be worth it
+	telemetry_field noise(0, 1, "Noise", telemetry_type::int32, telemetry_unit::value);
+	std::vector<telemetry_data_point> data_points;
+
+	for(int32_t i = 0; i < 2000; ++ i)
+		data_points.push_back(make_data_point(i * 1000, i % 3));
+
+	noise.set_data_points(std::move(data_points));
+	noise.compact();
+
+	TLM_CHECK(noise.get_encoding() == telemetry_field_encoding::samples);
+}
+
+TLM_TEST(field_looks_up_values_inside_runs)
+{
+	const telemetry_field samples = create_state_field(telemetry_unit::value);
+
+	telemetry_field runs = create_state_field(telemetry_unit::value);
+	runs.compact();
+
+	// Before, on and between the samples. Both throw past the last one
+	for(int64_t ticks = -500; ticks <= 1999 * 1000; ticks += 250)
+	{
+		const telemetry_time time(ticks);
+
+		TLM_CHECK(runs.get_data_point_closest_to_time(time).value.i32 == samples.get_data_point_closest_to_time(time).value.i32);
+		TLM_CHECK(runs.get_data_point_after_time(time).value.i32 == samples.get_data_point_after_time(time).value.i32);
+	}
+
+	TLM_CHECK_THROWS(runs.get_data_point_closest_to_time(telemetry_time(1999 * 1000 + 1)), std::invalid_argument);
+}
+
+TLM_TEST(field_queries_ranges_that_start_inside_runs)
+{
+	const telemetry_field samples = create_state_field(telemetry_unit::value);
+
+	telemetry_field runs = create_state_field(telemetry_unit::value);
+	runs.compact();
+
+	for(int64_t first = 0; first < 2000; first += 37)
+	{
+		for(int64_t length : { 0, 1, 10, 49, 50, 120, 777 })
+		{
+			const telemetry_time start(first * 1000);
+			const telemetry_time end((first + length) * 1000);
+
+			const std::vector<telemetry_data_point> expected = samples.get_data_points_in_range(start, end);
+			const std::vector<telemetry_data_point> actual = runs.get_data_points_in_range(start, end);
+
+			TLM_CHECK(!actual.empty());
+			TLM_CHECK(actual.front().timestamp == start);
+			TLM_CHECK(get_value_changes(actual) == get_value_changes(expected));
+
+			const auto [ expected_min, expected_max ] = samples.get_extreme_data_point_in_range(start, end);
+			const auto [ actual_min, actual_max ] = runs.get_extreme_data_point_in_range(start, end);
+
+			TLM_CHECK(actual_min.value.i32 == expected_min.value.i32);
+			TLM_CHECK(actual_max.value.i32 == expected_max.value.i32);
+		}
+	}
+}
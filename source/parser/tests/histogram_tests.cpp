@@ -0,0 +1,155 @@
+//
+//  histogram_tests.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <telemetry/histogram.h>
+#include <telemetry/provider.h>
+#include "test.h"
+
+static std::vector<double> create_frame_times(size_t count, uint32_t seed)
+{
+	std::mt19937 random(seed);
+	std::lognormal_distribution<double> distribution(std::log(0.016), 0.4);
+
+	std::vector<double> values(count);
+
+	for(auto &value : values)
+		value = distribution(random);
+
+	return values;
+}
+
+static void check_same_histogram(const telemetry_histogram &a, const telemetry_histogram &b)
+{
+	TLM_CHECK(a.get_count() == b.get_count());
+	TLM_CHECK(a.get_minimum() == b.get_minimum());
+	TLM_CHECK(a.get_maximum() == b.get_maximum());
+	TLM_CHECK_NEAR(a.get_sum(), b.get_sum(), 1e-9);
+	TLM_CHECK(a.get_bins().size() == b.get_bins().size());
+
+	for(size_t i = 0; i < a.get_bins().size(); ++ i)
+	{
+		TLM_CHECK(a.get_bins()[i].index == b.get_bins()[i].index);
+		TLM_CHECK(a.get_bins()[i].count == b.get_bins()[i].count);
+	}
+}
+
+TLM_TEST(histogram_bins_bound_their_values)
+{
+	std::mt19937 random(5);
+
+	for(int i = 0; i < 10000; ++ i)
+	{
+		const double value = std::ldexp(std::uniform_real_distribution<double>(1.0, 2.0)(random), int(random() % 40) - 20);
+		const uint32_t index = telemetry_histogram::get_bin_index(value);
+
+		const double lower = telemetry_histogram::get_bin_lower_bound(index);
+		const double upper = telemetry_histogram::get_bin_upper_bound(index);
+
+		TLM_CHECK(lower <= value && value < upper);
+		TLM_CHECK((upper - lower) <= value / telemetry_histogram::sub_bins);
+	}
+
+	TLM_CHECK(telemetry_histogram::get_bin_index(0.0) == 0);
+	TLM_CHECK(telemetry_histogram::get_bin_index(-1.0) == 0);
+	TLM_CHECK(telemetry_histogram::get_bin_index(std::numeric_limits<double>::quiet_NaN()) == 0);
+	TLM_CHECK(telemetry_histogram::get_bin_index(1e30) == telemetry_histogram::bin_count - 1);
+}
+
+TLM_TEST(histogram_merges_like_adding_everything)
+{
+	const std::vector<double> values = create_frame_times(10000, 6);
+
+	telemetry_histogram whole;
+	telemetry_histogram parts[4];
+
+	for(size_t i = 0; i < values.size(); ++ i)
+	{
+		whole.add(values[i]);
+		parts[(i * 7) % 4].add(values[i]);
+	}
+
+	telemetry_histogram merged;
+	merged.merge(telemetry_histogram());
+
+	for(auto &part : parts)
+		merged.merge(part);
+
+	merged.merge(telemetry_histogram());
+
+	check_same_histogram(merged, whole);
+}
+
+TLM_TEST(histogram_percentiles_stay_within_a_bin)
+{
+	std::vector<double> values = create_frame_times(20000, 7);
+
+	telemetry_histogram histogram;
+
+	for(double value : values)
+		histogram.add(value);
+
+	std::sort(values.begin(), values.end());
+
+	for(double percentile : { 0.01, 0.1, 0.5, 0.9, 0.99 })
+	{
+		const double exact = values[size_t(std::ceil(percentile * values.size())) - 1];
+		TLM_CHECK_NEAR(histogram.get_percentile(percentile), exact, exact * 2.0 / telemetry_histogram::sub_bins);
+	}
+
+	// The weighted percentile moves towards the long frames, which take up more of the time
+	TLM_CHECK(histogram.get_weighted_percentile(0.5) > histogram.get_percentile(0.5));
+	TLM_CHECK(telemetry_histogram().get_percentile(0.5) == 0.0);
+}
+
+TLM_TEST(histogram_series_sums_the_seconds_of_a_range)
+{
+	telemetry_field field(0, 1, "Frame time", telemetry_type::f64, telemetry_unit::time);
+
+	const std::vector<double> values = create_frame_times(3000, 8);
+	std::vector<telemetry_data_point> data_points;
+
+	for(size_t i = 0; i < values.size(); ++ i)
+		data_points.push_back(make_data_point(int64_t(i) * 16667 + 250000, values[i]));
+
+	field.set_data_points(std::move(data_points));
+	field.build_histograms();
+
+	TLM_CHECK(field.has_histograms());
+
+	for(auto [ first, last ] : { std::pair(0, 0), std::pair(3, 7), std::pair(10, 60), std::pair(-5, 100) })
+	{
+		const telemetry_time start = telemetry_time::from_seconds(first + 0.5);
+		const telemetry_time end = telemetry_time::from_seconds(last + 0.7);
+
+		// Whole seconds, from the one containing start to the one containing end
+		telemetry_histogram expected;
+
+		for(size_t i = 0; i < values.size(); ++ i)
+		{
+			const int64_t second = (int64_t(i) * 16667 + 250000) / telemetry_time::ticks_per_second;
+
+			if(second >= first && second <= last)
+				expected.add(values[i]);
+		}
+
+		check_same_histogram(field.get_histogram_in_range(start, end), expected);
+	}
+}
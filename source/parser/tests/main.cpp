@@ -0,0 +1,72 @@
+//
+//  main.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "test.h"
+
+std::vector<test_case> &get_test_cases()
+{
+	static std::vector<test_case> test_cases;
+	return test_cases;
+}
+
+const std::vector<uint8_t> &get_sample_capture()
+{
+	static const std::vector<uint8_t> data = []() {
+
+		std::ifstream file(TLM_SAMPLE_CAPTURE, std::ios::binary);
+		if(!file)
+			throw test_failure("Failed to open " TLM_SAMPLE_CAPTURE);
+
+		return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	}();
+
+	return data;
+}
+
+// Runs every test, or only the ones whose name contains the first argument
+int main(int argc, char *argv[])
+{
+	size_t failed = 0;
+	size_t run = 0;
+
+	for(auto &test : get_test_cases())
+	{
+		if(argc > 1 && !std::strstr(test.name, argv[1]))
+			continue;
+
+		run ++;
+
+		try
+		{
+			test.function();
+		}
+		catch(const std::exception &e)
+		{
+			std::printf("FAILED %s: %s\n", test.name, e.what());
+			failed ++;
+		}
+	}
+
+	std::printf("%zu of %zu tests passed\n", run - failed, run);
+	return (failed == 0) ? 0 : 1;
+}
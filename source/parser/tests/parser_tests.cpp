@@ -0,0 +1,132 @@
+//
+//  parser_tests.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <limits>
+#include <telemetry/columnar.h>
+#include <telemetry/parser.h>
+#include "test.h"
+
+TLM_TEST(parser_loads_truncated_captures)
+{
+	const std::vector<uint8_t> &capture = get_sample_capture();
+	const telemetry_container complete = parse_telemetry_data(capture.data(), capture.size(), {});
+
+	// Captures of a crashed sim end in the middle of a command, everything before it has to load
+	for(size_t size : { capture.size() - 1, capture.size() - 3, capture.size() * 9 / 10 })
+	{
+		const telemetry_container container = parse_telemetry_data(capture.data(), size, {});
+
+		TLM_CHECK(container.get_providers().size() == complete.get_providers().size());
+		TLM_CHECK(container.get_end_time() > telemetry_time::from_seconds(complete.get_end_time().to_seconds() * 0.8));
+		TLM_CHECK(container.get_end_time() <= complete.get_end_time());
+	}
+}
+
+// Every field holds exactly its data points inside the range, preceded by the value it had when the range started
+static void check_time_range(const telemetry_container &complete, const telemetry_container &container, const telemetry_time_range &range)
+{
+	const telemetry_time first(std::numeric_limits<int64_t>::min());
+
+	size_t carried = 0;
+
+	for(auto &provider : complete.get_providers())
+	{
+		auto &ranged_provider = container.get_provider(provider.get_id());
+
+		for(auto &field : provider.get_fields())
+		{
+			std::vector<telemetry_data_point> expected = field.get_data_points_in_range(range.start, range.end);
+			const std::vector<telemetry_data_point> before = field.get_data_points_in_range(first, range.start);
+
+			if(!before.empty() && before.back().timestamp < range.start)
+			{
+				telemetry_data_point data = before.back();
+				data.timestamp = range.start;
+
+				expected.insert(expected.begin(), data);
+				carried ++;
+			}
+
+			const std::vector<telemetry_data_point> actual = ranged_provider.get_field(field.get_id()).get_data_points_in_range(first, telemetry_time(std::numeric_limits<int64_t>::max()));
+
+			TLM_CHECK(actual.size() == expected.size());
+
+			for(size_t i = 0; i < expected.size(); ++ i)
+				TLM_CHECK(is_same_data_point(expected[i], actual[i]));
+		}
+	}
+
+	TLM_CHECK(carried > 0);
+}
+
+TLM_TEST(parser_loads_time_ranges)
+{
+	const std::vector<uint8_t> &capture = get_sample_capture();
+	const telemetry_container complete = parse_telemetry_data(capture.data(), capture.size(), {});
+
+	for(auto &range : { telemetry_time_range{ telemetry_time::from_seconds(120.0), telemetry_time::from_seconds(121.0) }, telemetry_time_range{ telemetry_time::from_seconds(10.25), telemetry_time::from_seconds(90.5) } })
+	{
+		telemetry_parser_options options;
+		options.time_range = range;
+
+		check_time_range(complete, parse_telemetry_data(capture.data(), capture.size(), options), range);
+	}
+}
+
+TLM_TEST(parser_loads_time_ranges_of_columnar_files)
+{
+	const std::vector<uint8_t> &capture = get_sample_capture();
+	const std::vector<uint8_t> data = convert_telemetry_to_columnar(capture.data(), capture.size());
+	const telemetry_container complete = parse_telemetry_data(data.data(), data.size(), {});
+
+	// Starts in the middle of chunks, carried values come from the chunk overlapping the start or, for fields without one, the chunk before it
+	const telemetry_time_range range = { telemetry_time::from_seconds(60.0), telemetry_time::from_seconds(75.0) };
+
+	telemetry_parser_options options;
+	options.time_range = range;
+
+	check_time_range(complete, parse_telemetry_data(data.data(), data.size(), options), range);
+}
+
+TLM_TEST(parser_skips_unselected_fields)
+{
+	const std::vector<uint8_t> &capture = get_sample_capture();
+	const telemetry_container complete = parse_telemetry_data(capture.data(), capture.size(), {});
+
+	const telemetry_provider &provider = complete.get_providers().front();
+	const telemetry_field &field = provider.get_fields().front();
+
+	telemetry_field_selection selection;
+	selection.add_field(provider.get_identifier(), field.get_id());
+
+	telemetry_parser_options options;
+	options.field_selection = selection;
+
+	const telemetry_container container = parse_telemetry_data(capture.data(), capture.size(), options);
+
+	for(auto &other : container.get_providers())
+	{
+		for(auto &other_field : other.get_fields())
+		{
+			const bool selected = (other.get_id() == provider.get_id() && other_field.get_id() == field.get_id());
+			TLM_CHECK(other_field.is_loaded() == selected);
+		}
+	}
+
+	TLM_CHECK(container.get_provider(provider.get_id()).get_field(field.get_id()).get_data_point_count() == field.get_data_point_count());
+}
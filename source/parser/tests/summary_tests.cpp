@@ -0,0 +1,135 @@
+//
+//  summary_tests.cpp
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <algorithm>
+#include <random>
+#include <telemetry/summary.h>
+#include "test.h"
+
+// The first sorted value whose preceding values add up to the percentile of the sum
+static double get_naive_weighted_percentile(std::vector<double> values, double percentile)
+{
+	std::sort(values.begin(), values.end());
+
+	double sum = 0.0;
+	for(double value : values)
+		sum += value;
+
+	double running_sum = 0.0;
+
+	for(double value : values)
+	{
+		if(running_sum >= sum * percentile)
+			return value;
+
+		running_sum += value;
+	}
+
+	return values.back();
+}
+
+// Halves, so that every sum is exact no matter the order the kernel adds them up in
+static std::vector<double> create_frame_times(size_t count, uint32_t seed)
+{
+	std::mt19937 random(seed);
+	std::vector<double> values(count);
+
+	for(auto &value : values)
+		value = (1 + random() % 100) * 0.5;
+
+	return values;
+}
+
+TLM_TEST(summary_matches_the_naive_statistics)
+{
+	std::mt19937 random(4);
+
+	// Every remainder of the four wide vector loop
+	for(size_t count = 1; count < 40; ++ count)
+	{
+		std::vector<double> values(count);
+
+		for(auto &value : values)
+			value = std::uniform_real_distribution<double>(-10.0, 100.0)(random);
+
+		const telemetry_summary summary = summarize_telemetry_values(values.data(), values.size());
+
+		double sum = 0.0;
+		for(double value : values)
+			sum += value;
+
+		const double mean = sum / count;
+
+		double variance = 0.0;
+		for(double value : values)
+			variance += (value - mean) * (value - mean);
+
+		variance /= count;
+
+		TLM_CHECK(summary.count == count);
+		TLM_CHECK_NEAR(summary.sum, sum, 1e-9);
+		TLM_CHECK_NEAR(summary.mean, mean, 1e-9);
+		TLM_CHECK_NEAR(summary.variance, variance, 1e-9);
+		TLM_CHECK(summary.minimum == *std::min_element(values.begin(), values.end()));
+		TLM_CHECK(summary.maximum == *std::max_element(values.begin(), values.end()));
+	}
+
+	const telemetry_summary empty = summarize_telemetry_values(nullptr, 0, { 0.5 });
+
+	TLM_CHECK(empty.count == 0);
+	TLM_CHECK(empty.weighted_percentiles.size() == 1);
+}
+
+TLM_TEST(summary_answers_weighted_percentiles)
+{
+	const std::vector<double> percentiles = { 0.99, 0.0, 0.5, 0.01, 0.95, 1.0, 0.5 };
+
+	for(size_t count : { 1, 2, 7, 1000 })
+	{
+		std::vector<double> values = create_frame_times(count, uint32_t(count));
+		std::sort(values.begin(), values.end());
+
+		const telemetry_summary summary = summarize_telemetry_values(values.data(), values.size(), percentiles);
+		const telemetry_sorted_values sorted(create_frame_times(count, uint32_t(count)));
+
+		TLM_CHECK(sorted.get_values() == values);
+
+		// Requested out of order and with duplicates, answered in the order they were requested
+		for(size_t i = 0; i < percentiles.size(); ++ i)
+		{
+			const double expected = get_naive_weighted_percentile(values, percentiles[i]);
+
+			TLM_CHECK(summary.weighted_percentiles[i] == expected);
+			TLM_CHECK(sorted.get_weighted_percentile(percentiles[i]) == expected);
+		}
+	}
+
+	TLM_CHECK(telemetry_sorted_values().get_weighted_percentile(0.5) == 0.0);
+}
+
+TLM_TEST(summary_weighs_percentiles_by_value)
+{
+	// 90 short frames and 10 long ones, which take up half of the time
+	std::vector<double> values(90, 1.0);
+	values.insert(values.end(), 10, 9.0);
+
+	const telemetry_sorted_values sorted(std::move(values));
+
+	TLM_CHECK(sorted.get_weighted_percentile(0.4) == 1.0);
+	TLM_CHECK(sorted.get_weighted_percentile(0.6) == 9.0);
+}
@@ -0,0 +1,130 @@
+//
+//  test.h
+//  libtlm
+//
+//  Created by Sidney Just
+//  Copyright (c) 2024 by Laminar Research
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+//  documentation files (the "Software"), to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+//  and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+//  The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+//  INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+//  PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+//  FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+//  ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef TELEMETRY_TEST_H
+#define TELEMETRY_TEST_H
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <telemetry/data.h>
+
+// Minimal test registry, every TLM_TEST() registers itself before main() runs. Checks throw a test_failure, which fails the current test
+struct test_failure : std::runtime_error
+{
+	using std::runtime_error::runtime_error;
+};
+
+struct test_case
+{
+	const char *name;
+	void (*function)();
+};
+
+std::vector<test_case> &get_test_cases();
+
+struct test_registration
+{
+	test_registration(const char *name, void (*function)())
+	{
+		get_test_cases().push_back({ name, function });
+	}
+};
+
+#define TLM_TEST(name) \
+	static void name(); \
+	static test_registration name##_registration(#name, name); \
+	static void name()
+
+#define TLM_FAIL(message) \
+	throw test_failure(std::string(__FILE__) + ":" + std::to_string(__LINE__) + ": " + (message))
+
+#define TLM_CHECK(condition) \
+	do { if(!(condition)) TLM_FAIL(#condition); } while(0)
+
+#define TLM_CHECK_NEAR(value, expected, tolerance) \
+	do { if(!(std::abs(double(value) - double(expected)) <= (tolerance))) TLM_FAIL(#value " is " + std::to_string(double(value)) + ", expected " + std::to_string(double(expected))); } while(0)
+
+#define TLM_CHECK_THROWS(expression, exception) \
+	do { \
+		bool thrown = false; \
+		try { (void)(expression); } catch(const exception &) { thrown = true; } \
+		if(!thrown) TLM_FAIL(#expression " didn't throw " #exception); \
+	} while(0)
+
+inline telemetry_data_point make_data_point(int64_t ticks, double value)
+{
+	telemetry_data_point data;
+	data.timestamp = telemetry_time(ticks);
+	data.value.type = telemetry_type::f64;
+	data.value.f64 = value;
+
+	return data;
+}
+
+inline telemetry_data_point make_data_point(int64_t ticks, int32_t value)
+{
+	telemetry_data_point data;
+	data.timestamp = telemetry_time(ticks);
+	data.value.type = telemetry_type::int32;
+	data.value.i32 = uint32_t(value);
+
+	return data;
+}
+
+// Bitwise for floating point values, so that NaNs compare equal to themselves
+inline bool is_same_data_point(const telemetry_data_point &a, const telemetry_data_point &b)
+{
+	if(a.timestamp != b.timestamp || a.value.type != b.value.type)
+		return false;
+
+	switch(a.value.type)
+	{
+		case telemetry_type::string:
+			return a.value.string == b.value.string;
+		case telemetry_type::boolean:
+			return a.value.b == b.value.b;
+		case telemetry_type::uint8:
+			return a.value.u8 == b.value.u8;
+		case telemetry_type::uint16:
+			return a.value.u16 == b.value.u16;
+		case telemetry_type::uint32:
+		case telemetry_type::int32:
+			return a.value.u32 == b.value.u32;
+		case telemetry_type::uint64:
+		case telemetry_type::int64:
+			return a.value.u64 == b.value.u64;
+		case telemetry_type::f32:
+			return std::memcmp(&a.value.f32, &b.value.f32, sizeof(float)) == 0;
+		case telemetry_type::f64:
+			return std::memcmp(&a.value.f64, &b.value.f64, sizeof(double)) == 0;
+		case telemetry_type::vec2:
+			return std::memcmp(a.value.vec2, b.value.vec2, sizeof(float) * 2) == 0;
+		case telemetry_type::dvec2:
+			return std::memcmp(a.value.dvec2, b.value.dvec2, sizeof(double) * 2) == 0;
+	}
+
+	return false;
+}
+
+// The TLMv2 capture shipped in the samples directory, loaded once
+const std::vector<uint8_t> &get_sample_capture();
+
+#endif //TELEMETRY_TEST_H
@@ -2,6 +2,7 @@
 // Created by Sidney on 13/12/2024.
 //
 
+#include <limits>
 #include <QFile>
 #include <QFileInfo>
 #include <telemetry/known_providers.h>
@@ -11,33 +12,47 @@
 
 TelemetryDocument *TelemetryDocument::load_file(const QString &path)
 {
-	QFile file(path);
+	auto file = std::make_unique<QFile>(path);
 
-	if(!file.open(QIODevice::ReadOnly))
+	if(!file->open(QIODevice::ReadOnly))
 		return {};
 
-	const size_t length = file.bytesAvailable();
+	const size_t length = file->size();
+	const uchar *mapping = length > 0 ? file->map(0, length) : nullptr;
 
-	std::vector<uint8_t> data;
-	data.resize(length);
+	QFileInfo info(path);
 
-	file.read((char *)data.data(), length);
-	file.close();
+	if(!mapping)
+	{
+		std::vector<uint8_t> data;
+		data.resize(length);
 
-	QFileInfo info(path);
+		file->read((char *)data.data(), length);
+		file->close();
 
-	TelemetryDocument *result = load_file(std::move(data), info.fileName());
+		TelemetryDocument *result = load_file(std::move(data), info.fileName());
+		result->m_path = path;
+
+		return result;
+	}
+
+	std::unique_ptr<TelemetryDocument> result(new TelemetryDocument());
+	result->m_mapped_file = std::move(file);
+	result->m_mapped_data = mapping;
+	result->m_mapped_size = length;
+	result->load(info.fileName());
 	result->m_path = path;
 
-	return result;
+	return result.release();
 }
 
 TelemetryDocument *TelemetryDocument::load_file(std::vector<uint8_t> &&data, const QString &name)
 {
-	TelemetryDocument *result = new TelemetryDocument();
-	result->load(std::move(data), name);
+	std::unique_ptr<TelemetryDocument> result(new TelemetryDocument());
+	result->m_binary_data = std::move(data);
+	result->load(name);
 
-	return result;
+	return result.release();
 }
 
 void TelemetryDocument::set_name(const QString &name)
@@ -45,12 +60,12 @@ void TelemetryDocument::set_name(const QString &name)
 	m_name = name;
 }
 
-void TelemetryDocument::load(std::vector<uint8_t> &&data, const QString &name)
+static telemetry_parser_options create_parser_options(bool full_resolution)
 {
 	telemetry_parser_options options;
-	options.data_point_processor = [](const telemetry_container &container, const telemetry_provider &provider, const telemetry_field &field, const std::vector<telemetry_data_point> &data_points) {
+	options.data_point_processor = [full_resolution](const telemetry_container &container, const telemetry_provider &provider, const telemetry_field &field, const std::vector<telemetry_data_point> &data_points) {
 
-		std::vector<telemetry_data_point> result = decimate_data(data_points, 1000);
+		std::vector<telemetry_data_point> result = full_resolution ? data_points : decimate_data(data_points, 1000);
 
 		// Expand the first and last point to the very end of the telemetry range
 		if(!result.empty())
@@ -74,10 +89,204 @@ void TelemetryDocument::load(std::vector<uint8_t> &&data, const QString &name)
 
 	};
 
-	m_data = parse_telemetry_data(data.data(), data.size(), options);
+	// Full resolution data is only requested for the raster and spectrum views, keep it block compressed instead of as plain data points
+	options.compress_columns = full_resolution;
+
+	return options;
+}
+
+static telemetry_field_selection create_field_selection()
+{
+	// Only decode what is needed for the initial view and the region detection, everything else is loaded when enabled in the UI
+	telemetry_field_selection selection;
+	selection.add_provider(provider_timing::identifier);
+	selection.add_provider(provider_sim_apup::identifier);
+
+	return selection;
+}
+
+bool TelemetryDocument::load_field(const std::string &identifier, uint8_t field_id)
+{
+	if(!m_data.has_provider(identifier))
+		return false;
+
+	const telemetry_provider &provider = m_data.get_provider(identifier);
+
+	if(!provider.has_field(field_id))
+		return false;
+
+	load_fields({ { identifier, field_id } });
+
+	return provider.get_field(field_id).is_loaded();
+}
+
+void TelemetryDocument::load_fields(const std::vector<std::pair<std::string, uint8_t>> &fields)
+{
+	telemetry_field_selection selection;
+	bool has_selection = false;
+
+	for(auto &[ identifier, field_id ] : fields)
+	{
+		// Derived fields aren't in the file, they are only loaded through set_derived_data_points()
+		if(identifier == derived_provider_identifier || !m_data.has_provider(identifier))
+			continue;
+
+		const telemetry_provider &provider = m_data.get_provider(identifier);
+
+		if(!provider.has_field(field_id) || provider.get_field(field_id).is_loaded())
+			continue;
+
+		selection.add_field(identifier, field_id);
+		has_selection = true;
+	}
+
+	if(!has_selection)
+		return;
+
+	telemetry_parser_options options = create_parser_options(m_full_resolution);
+	options.field_selection = selection;
+	options.time_range = m_time_range;
+
+	load_telemetry_fields(m_data, get_binary_data(), get_binary_size(), options);
+}
+
+uint8_t TelemetryDocument::add_derived_field(const std::string &title, telemetry_unit unit)
+{
+	if(m_derived_fields.size() > std::numeric_limits<uint8_t>::max())
+		throw std::length_error("Too many derived fields");
+
+	const uint8_t field_id = uint8_t(m_derived_fields.size());
+	m_derived_fields.push_back({ title, unit });
+
+	telemetry_provider &provider = m_data.get_provider(derived_provider_identifier);
+
+	telemetry_field field(field_id, provider.get_id(), title, telemetry_type::f64, unit);
+	field.set_loaded(false);
+
+	provider.add_field(std::move(field));
+
+	return field_id;
+}
+
+void TelemetryDocument::set_derived_data_points(uint8_t field_id, std::vector<telemetry_data_point> &&data_points)
+{
+	telemetry_field &field = m_data.get_provider(derived_provider_identifier).get_field(field_id);
+
+	field.set_data_points(std::move(data_points));
+	field.set_loaded(true);
+}
+
+void TelemetryDocument::unload_derived_fields()
+{
+	for(auto &field : m_data.get_provider(derived_provider_identifier).get_fields())
+	{
+		field.set_data_points({});
+		field.set_loaded(false);
+	}
+}
+
+void TelemetryDocument::add_derived_provider()
+{
+	telemetry_provider provider(std::numeric_limits<uint16_t>::max(), 1, derived_provider_identifier, "Derived Fields");
+
+	// Fields are referenced by address, so adding one must never move the others
+	provider.get_fields().reserve(size_t(std::numeric_limits<uint8_t>::max()) + 1);
+
+	for(size_t i = 0; i < m_derived_fields.size(); ++ i)
+	{
+		telemetry_field field(uint8_t(i), provider.get_id(), m_derived_fields[i].title, telemetry_type::f64, m_derived_fields[i].unit);
+		field.set_loaded(false);
+
+		provider.add_field(std::move(field));
+	}
+
+	m_data.add_provider(std::move(provider));
+}
+
+void TelemetryDocument::load_region(const TelemetryRegion &region)
+{
+	std::optional<telemetry_time_range> time_range;
+
+	if(region.type != TelemetryRegion::Type::Everything)
+		time_range = telemetry_time_range{ region.start, region.end };
+
+	parse_region(time_range);
+}
+
+void TelemetryDocument::set_full_resolution(bool full_resolution)
+{
+	if(m_full_resolution == full_resolution)
+		return;
+
+	m_full_resolution = full_resolution;
+	parse_region(m_time_range);
+}
+
+std::vector<HitchEpisode> TelemetryDocument::detect_hitches(const HitchSettings &settings) const
+{
+	telemetry_field_selection selection;
+	selection.add_field(provider_timing::identifier, provider_timing::cpu);
+	selection.add_field(provider_timing::identifier, provider_timing::gpu);
+	selection.add_field(provider_timing::identifier, provider_timing::time);
+
+	telemetry_parser_options options;
+	options.field_selection = selection;
+	options.build_histograms = false;
+
+	const telemetry_container container = parse_telemetry_data(get_binary_data(), get_binary_size(), options);
+	return ::detect_hitches(container, settings);
+}
+
+telemetry_container TelemetryDocument::load_alignment_signals() const
+{
+	telemetry_field_selection selection;
+	selection.add_field(provider_timing::identifier, provider_timing::fps);
+	selection.add_field(provider_sim_apup::identifier, provider_sim_apup::do_world);
+
+	telemetry_parser_options options;
+	options.field_selection = selection;
+	options.build_histograms = false;
+
+	return parse_telemetry_data(get_binary_data(), get_binary_size(), options);
+}
+
+void TelemetryDocument::parse_region(const std::optional<telemetry_time_range> &time_range)
+{
+	telemetry_field_selection selection = create_field_selection();
+
+	// Keep everything that was loaded on demand so far
+	for(auto &provider : m_data.get_providers())
+	{
+		if(provider.get_identifier() == derived_provider_identifier)
+			continue;
+
+		for(auto &field : provider.get_fields())
+		{
+			if(field.is_loaded())
+				selection.add_field(provider.get_identifier(), field.get_id());
+		}
+	}
+
+	telemetry_parser_options options = create_parser_options(m_full_resolution);
+	options.field_selection = selection;
+	options.time_range = time_range;
+
+	m_data = parse_telemetry_data(get_binary_data(), get_binary_size(), options);
+	m_time_range = time_range;
+
+	add_derived_provider();
+}
+
+void TelemetryDocument::load(const QString &name)
+{
+	telemetry_parser_options options = create_parser_options(m_full_resolution);
+	options.field_selection = create_field_selection();
+
+	m_data = parse_telemetry_data(get_binary_data(), get_binary_size(), options);
+	add_derived_provider();
 
 	m_path.clear();
-	m_binary_data = std::move(data);
+	m_time_range.reset();
 	m_name = name;
 
 	TelemetryRegion everything;
@@ -95,12 +304,12 @@ void TelemetryDocument::load(std::vector<uint8_t> &&data, const QString &name)
 		auto &aircraft_events = provider_sim_apup::get_field(m_data, provider_sim_apup::loaded_aircraft);
 
 		bool previous_state = false;
-		double previous_timestamp = m_data.get_start_time();
+		telemetry_time previous_timestamp = m_data.get_start_time();
 
-		auto flush_range = [this, &aircraft_events](double start, double end, TelemetryRegion::Type type) {
+		auto flush_range = [this, &aircraft_events](telemetry_time start, telemetry_time end, TelemetryRegion::Type type) {
 
 			// We want at least 12 seconds worth of data to add it to the timeline
-			if((end - start) > 12.0)
+			if((end - start) > telemetry_time::from_seconds(12.0))
 			{
 				QString title;
 
@@ -135,11 +344,11 @@ void TelemetryDocument::load(std::vector<uint8_t> &&data, const QString &name)
 
 			if(is_doing_world != previous_state)
 			{
-				double timestamp = data.timestamp;
+				telemetry_time timestamp = data.timestamp;
 
 				// Add 10 seconds of padding to the end of in menu regions to give the sim time to stabilize
 				if(is_doing_world)
-					timestamp += 10.0;
+					timestamp += telemetry_time::from_seconds(10.0);
 
 				flush_range(previous_timestamp, timestamp, previous_state ? TelemetryRegion::Type::Flying : TelemetryRegion::Type::InMenu);
 
@@ -155,11 +364,15 @@ void TelemetryDocument::load(std::vector<uint8_t> &&data, const QString &name)
 
 bool TelemetryDocument::save(const QString &path)
 {
+	// The mapped file is already on disk, writing it back into itself would truncate the mapping
+	if(m_mapped_data && path == m_path)
+		return true;
+
 	QFile file(path);
 
 	if(file.open(QIODevice::WriteOnly))
 	{
-		file.write((const char *)m_binary_data.data(), m_binary_data.size());
+		file.write((const char *)get_binary_data(), get_binary_size());
 		m_path = path;
 
 		return true;
@@ -5,8 +5,11 @@
 #ifndef TELEMETRY_DOCUMENT_H
 #define TELEMETRY_DOCUMENT_H
 
+#include <memory>
+#include <QFile>
 #include <QString>
-#include <telemetry/container.h>
+#include <telemetry/parser.h>
+#include "../utilities/HitchDetector.h"
 
 struct TelemetryRegion
 {
@@ -17,7 +20,7 @@ struct TelemetryRegion
 		Flying
 	};
 
-	double start, end;
+	telemetry_time start, end;
 	QString name;
 	Type type;
 };
@@ -25,14 +28,44 @@ struct TelemetryRegion
 class TelemetryDocument
 {
 public:
+	// Fields computed from other fields live in a provider of their own, which is added to every document. See add_derived_field()
+	static inline const char *derived_provider_identifier = "com.laminarresearch.derived";
+
 	static TelemetryDocument *load_file(const QString &path);
 	static TelemetryDocument *load_file(std::vector<uint8_t> &&data, const QString &name);
 
 	void set_name(const QString &name);
 
+	// Fields outside of the timing and sim providers are only decoded on demand. Returns false if the field doesn't exist
+	bool load_field(const std::string &identifier, uint8_t field_id);
+	void load_fields(const std::vector<std::pair<std::string, uint8_t>> &fields); // Decodes all fields that aren't loaded yet in a single pass over the file
+
+	// Adds an unloaded field to the derived provider and returns its id. The field survives reparsing, but is unloaded again every time, since
+	// its data depends on the fields it's derived from. Will throw std::length_error() once all field ids are taken
+	uint8_t add_derived_field(const std::string &title, telemetry_unit unit);
+	void set_derived_data_points(uint8_t field_id, std::vector<telemetry_data_point> &&data_points); // Marks the field as loaded
+	void unload_derived_fields(); // For when the fields they are derived from changed without reparsing this document
+
+	// Reloads the document with only the data points inside of the region, loading the Everything region loads all data points again.
+	// This invalidates all fields previously returned by get_data()
+	void load_region(const TelemetryRegion &region);
+	bool is_partial() const { return m_time_range.has_value(); }
+
+	// Data points are decimated by default so that Qt Charts can keep up, the raster chart renderer can show all of them.
+	// Changing it parses the document again with the same fields and region, which invalidates all fields previously returned by get_data()
+	void set_full_resolution(bool full_resolution);
+	bool is_full_resolution() const { return m_full_resolution; }
+
+	// Parses the frame timing of the whole file again at full resolution and looks for stutters in it, independent of the loaded region.
+	// Only reads the file data, so it can run on a worker thread for as long as the document is alive
+	std::vector<HitchEpisode> detect_hitches(const HitchSettings &settings) const;
+
+	// The fields runs are aligned by at full resolution and over the whole file, see align_runs(). Like detect_hitches() it only reads the file data
+	telemetry_container load_alignment_signals() const;
+
 	bool save(const QString &path);
 	bool is_draft() const { return m_path.isEmpty(); }
-	bool has_data() const { return !m_binary_data.empty(); }
+	bool has_data() const { return get_binary_size() > 0; }
 
 	const QString &get_name() const { return m_name; }
 	const QString &get_path() const { return m_path; }
@@ -42,15 +75,34 @@ public:
 protected:
 	TelemetryDocument() = default;
 
-	void load(std::vector<uint8_t> &&data, const QString &name);
+	void load(const QString &name);
+	void parse_region(const std::optional<telemetry_time_range> &time_range);
+	void add_derived_provider();
 
 private:
+	struct derived_field
+	{
+		std::string title;
+		telemetry_unit unit;
+	};
+
+	const uint8_t *get_binary_data() const { return m_mapped_data ? m_mapped_data : m_binary_data.data(); }
+	size_t get_binary_size() const { return m_mapped_data ? m_mapped_size : m_binary_data.size(); }
+
 	QString m_path;
 	QString m_name;
 	telemetry_container m_data;
+	std::optional<telemetry_time_range> m_time_range;
+	bool m_full_resolution = false;
+
+	// Files opened from disk are memory mapped, so that only the parts that are actually parsed need to be paged in
 	std::vector<uint8_t> m_binary_data;
+	std::unique_ptr<QFile> m_mapped_file;
+	const uint8_t *m_mapped_data = nullptr;
+	size_t m_mapped_size = 0;
 
 	QVector<TelemetryRegion> m_regions;
+	std::vector<derived_field> m_derived_fields; // Index is the field id
 };
 
 #endif //TELEMETRY_DOCUMENT_H
@@ -0,0 +1,86 @@
+//
+// BackgroundJob.cpp
+//
+
+#include "BackgroundJob.h"
+
+BackgroundJob::BackgroundJob(QObject *context, int32_t delay) :
+	m_context(context)
+{
+	// One thread, so that a superseded job can't hold up its successor by competing for cores
+	m_pool.setMaxThreadCount(1);
+
+	m_timer.setSingleShot(true);
+	m_timer.setInterval(delay);
+
+	QObject::connect(&m_timer, &QTimer::timeout, context, [this]() {
+		start();
+	});
+}
+
+BackgroundJob::~BackgroundJob()
+{
+	cancel();
+}
+
+void BackgroundJob::schedule(prepare_function prepare)
+{
+	m_generation ++;
+	m_prepare = std::move(prepare);
+
+	// Its result would be discarded anyway, so it shouldn't keep the worker busy any longer
+	if(m_cancelled)
+		*m_cancelled = true;
+
+	m_timer.start();
+}
+
+bool BackgroundJob::cancel()
+{
+	const bool pending = m_prepare || m_running != 0;
+
+	m_generation ++;
+	m_prepare = {};
+	m_running = 0;
+
+	m_timer.stop();
+
+	if(m_cancelled)
+		*m_cancelled = true;
+
+	m_pool.clear();
+	m_pool.waitForDone();
+
+	return pending;
+}
+
+void BackgroundJob::start()
+{
+	if(!m_prepare)
+		return;
+
+	compute_function compute = std::exchange(m_prepare, {})();
+	const uint64_t generation = m_generation;
+
+	m_running = generation;
+	m_cancelled = std::make_shared<std::atomic<bool>>(false);
+
+	m_pool.start([this, compute = std::move(compute), generation, cancelled = m_cancelled]() {
+
+		apply_function apply;
+
+		if(generation == m_generation && !*cancelled)
+			apply = compute(*cancelled);
+
+		QMetaObject::invokeMethod(m_context, [this, apply = std::move(apply), generation]() {
+
+			if(m_running == generation)
+				m_running = 0;
+
+			if(apply && generation == m_generation)
+				apply();
+
+		}, Qt::QueuedConnection);
+
+	});
+}
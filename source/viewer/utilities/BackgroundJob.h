@@ -0,0 +1,53 @@
+//
+// BackgroundJob.h
+//
+
+#ifndef BACKGROUNDJOB_H
+#define BACKGROUNDJOB_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+
+// Runs the newest of a series of computations on a worker thread, for work that is triggered by UI changes faster than it can be done.
+// Every schedule() supersedes the previous one: if it hasn't started yet it is dropped, if it is already running it is cancelled and its result
+// is discarded. A job goes through three steps:
+//   prepare runs on the UI thread once no other job was scheduled for the delay, and gathers the inputs into the compute function
+//   compute runs on the worker thread and returns the apply function holding the results. It gets a flag that is set once the job is
+//           superseded or cancelled, and is expected to check it between its units of work and return an empty function once it's set
+//   apply runs back on the UI thread, but only if no newer job was scheduled in the meantime
+class BackgroundJob
+{
+public:
+	using apply_function = std::function<void ()>;
+	using compute_function = std::function<apply_function (const std::atomic<bool> &cancelled)>;
+	using prepare_function = std::function<compute_function ()>;
+
+	BackgroundJob(QObject *context, int32_t delay);
+	~BackgroundJob();
+
+	void schedule(prepare_function prepare);
+
+	// Drops the scheduled job and cancels a running one. Needs to be called before destroying anything the compute step reads, so it still
+	// waits for the running compute step to return, which it does at its next check of the cancelled flag.
+	// Returns true if a job was pending, so that the caller can schedule a new one
+	bool cancel();
+
+private:
+	void start();
+
+	QObject *m_context;
+	QTimer m_timer;
+	QThreadPool m_pool;
+
+	prepare_function m_prepare;
+	uint64_t m_running = 0; // Generation of the job that was started but hasn't delivered its result yet, 0 if there is none
+	std::shared_ptr<std::atomic<bool>> m_cancelled; // Of the most recently started job
+
+	std::atomic<uint64_t> m_generation = 0;
+};
+
+#endif //BACKGROUNDJOB_H
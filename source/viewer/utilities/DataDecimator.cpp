@@ -5,10 +5,12 @@
 #include <cmath>
 #include "DataDecimator.h"
 
-std::vector<telemetry_data_point> decimate_data(const std::vector<telemetry_data_point> &input, uint32_t threshold)
+template<telemetry_type Type>
+static std::vector<telemetry_data_point> decimate_data(const std::vector<telemetry_data_point> &input, uint32_t threshold)
 {
-	if(threshold >= input.size() || threshold == 0)
-		return input;
+	auto get_value = [&](size_t index) {
+		return input[index].value.get_as<double, Type>();
+	};
 
 	const float increment = float(input.size() - 2) / (threshold - 2);
 
@@ -30,8 +32,8 @@ std::vector<telemetry_data_point> decimate_data(const std::vector<telemetry_data
 
 		for(size_t j = range_start; j < range_end; ++ j)
 		{
-			average_x += input[j].timestamp;
-			average_y += input[j].value.get<double>();
+			average_x += input[j].timestamp.to_seconds();
+			average_y += get_value(j);
 		}
 
 		average_x /= (range_end - range_start);
@@ -42,15 +44,15 @@ std::vector<telemetry_data_point> decimate_data(const std::vector<telemetry_data
 		range_start = std::floor((i + 0) * increment) + 1;
 		range_end = std::min((size_t)(std::floor((i + 1) * increment) + 1), input.size());
 
-		const double point_a_x = input[a].timestamp;
-		const double point_a_y = input[a].value.get<double>();
+		const double point_a_x = input[a].timestamp.to_seconds();
+		const double point_a_y = get_value(a);
 
 		int32_t max_area = -1;
 		size_t max_area_index;
 
 		for(size_t j = range_start; j < range_end; ++ j)
 		{
-			int32_t area = abs((point_a_x - average_x) * (input[j].value.get<double>() - point_a_y) - (point_a_x - input[j].timestamp) * (average_y - point_a_y)) * 0.5;
+			int32_t area = abs((point_a_x - average_x) * (get_value(j) - point_a_y) - (point_a_x - input[j].timestamp.to_seconds()) * (average_y - point_a_y)) * 0.5;
 
 			if(area > max_area)
 			{
@@ -70,3 +72,21 @@ std::vector<telemetry_data_point> decimate_data(const std::vector<telemetry_data
 
 	return result;
 }
+
+std::vector<telemetry_data_point> decimate_data(const std::vector<telemetry_data_point> &input, uint32_t threshold)
+{
+	if(threshold >= input.size() || threshold == 0)
+		return input;
+
+	// All data points of a field share its type, so it is resolved once instead of for every sample
+	return visit_telemetry_type(input.front().value.type, [&](auto tag) -> std::vector<telemetry_data_point> {
+
+		constexpr telemetry_type Type = decltype(tag)::value;
+
+		if constexpr (is_telemetry_type_convertible<double>(Type))
+			return decimate_data<Type>(input, threshold);
+		else
+			throw std::runtime_error("Unsupported type conversion");
+
+	});
+}
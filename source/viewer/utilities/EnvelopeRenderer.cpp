@@ -0,0 +1,197 @@
+//
+// EnvelopeRenderer.cpp
+//
+
+#include <algorithm>
+#include "EnvelopeRenderer.h"
+#include "ParallelFor.h"
+
+namespace
+{
+	constexpr size_t columns_per_task = 64;
+	constexpr double sticky_gap = 1.0; // Same threshold as ChartWidget::build_line_points()
+}
+
+static EnvelopeBins bin_layer(const EnvelopeLayer &layer, size_t width, double start, double end)
+{
+	EnvelopeBins result;
+	result.columns.resize(width);
+
+	std::vector<EnvelopeColumn> &columns = result.columns;
+
+	const double column_duration = (end - start) / width;
+	const size_t tasks = (width + columns_per_task - 1) / columns_per_task;
+
+	const double *timestamps_end = layer.timestamps + layer.count;
+
+	// Every task owns a contiguous block of columns and finds its samples with a binary search, so no two threads ever write the same column
+	parallel_for(tasks, [&](size_t task) {
+
+		const size_t first_column = task * columns_per_task;
+		const size_t last_column = std::min(first_column + columns_per_task, width);
+
+		const double task_start = start + first_column * column_duration + layer.time_offset;
+		const double task_end = start + last_column * column_duration + layer.time_offset;
+
+		const double *begin = std::lower_bound(layer.timestamps, timestamps_end, task_start);
+		const double *end = std::lower_bound(begin, timestamps_end, task_end);
+
+		for(const double *timestamp = begin; timestamp != end; ++ timestamp)
+		{
+			const double time = *timestamp - layer.time_offset;
+			const double value = layer.values[timestamp - layer.timestamps] * layer.scale;
+
+			// Clamped, because rounding can put samples right on a block boundary into the neighbouring column
+			size_t index = size_t(std::max(0.0, (time - start) / column_duration));
+			index = std::clamp(index, first_column, last_column - 1);
+
+			EnvelopeColumn &column = columns[index];
+
+			if(!column.used)
+			{
+				column.minimum = column.maximum = column.first = column.last = value;
+				column.first_time = column.last_time = time;
+				column.used = true;
+
+				continue;
+			}
+
+			column.minimum = std::min(column.minimum, value);
+			column.maximum = std::max(column.maximum, value);
+			column.last = value;
+			column.last_time = time;
+		}
+
+	});
+
+	const double *first_visible = std::lower_bound(layer.timestamps, timestamps_end, start + layer.time_offset);
+	const double *last_visible = std::lower_bound(first_visible, timestamps_end, end + layer.time_offset);
+
+	if(first_visible != layer.timestamps)
+	{
+		const size_t index = first_visible - layer.timestamps - 1;
+		result.previous = EnvelopeSample{ layer.timestamps[index] - layer.time_offset, layer.values[index] * layer.scale };
+	}
+
+	if(last_visible != timestamps_end)
+	{
+		const size_t index = last_visible - layer.timestamps;
+		result.next = EnvelopeSample{ layer.timestamps[index] - layer.time_offset, layer.values[index] * layer.scale };
+	}
+
+	return result;
+}
+
+// Samples outside of the image can be arbitrarily far away, which the raster paint engine doesn't handle well
+static QLineF clip_line(QPointF from, QPointF to, double min_x, double max_x)
+{
+	auto interpolate = [&](double x) {
+		const double t = (x - from.x()) / (to.x() - from.x());
+		return QPointF(x, from.y() + (to.y() - from.y()) * t);
+	};
+
+	if(from.x() < min_x && to.x() > min_x)
+		from = interpolate(min_x);
+	if(to.x() > max_x && from.x() < max_x)
+		to = interpolate(max_x);
+
+	return QLineF(from, to);
+}
+
+static void draw_layer(QPainter &painter, const EnvelopeLayer &layer, const EnvelopeBins &bins, QSize size, double start, double end)
+{
+	const std::vector<EnvelopeColumn> &columns = bins.columns;
+
+	const double column_duration = (end - start) / size.width();
+	const double range = layer.maximum - layer.minimum;
+
+	const double min_x = -1.0;
+	const double max_x = size.width() + 1.0;
+
+	auto to_x = [&](double time) { return (time - start) / column_duration; };
+	auto to_y = [&](double value) { return (layer.maximum - value) / range * size.height(); };
+
+	std::optional<QPointF> previous;
+	double previous_time = 0.0;
+
+	auto connect = [&](double time, QPointF point) {
+
+		if(!previous)
+			return;
+
+		if(time - previous_time >= sticky_gap)
+		{
+			const QPointF corner(point.x(), previous->y());
+
+			painter.drawLine(clip_line(*previous, corner, min_x, max_x));
+			painter.drawLine(clip_line(corner, point, min_x, max_x));
+		}
+		else
+			painter.drawLine(clip_line(*previous, point, min_x, max_x));
+
+	};
+
+	// Enter from the last sample before the visible range, so that the line doesn't start in the middle of the image
+	if(bins.previous)
+	{
+		previous_time = bins.previous->time;
+		previous = QPointF(to_x(previous_time), to_y(bins.previous->value));
+	}
+
+	for(size_t i = 0; i < columns.size(); ++ i)
+	{
+		const EnvelopeColumn &column = columns[i];
+
+		if(!column.used)
+			continue;
+
+		const double x = i + 0.5;
+
+		connect(column.first_time, QPointF(x, to_y(column.first)));
+
+		if(column.minimum != column.maximum)
+			painter.drawLine(QPointF(x, to_y(column.minimum)), QPointF(x, to_y(column.maximum)));
+		else if(!previous)
+			painter.drawPoint(QPointF(x, to_y(column.first)));
+
+		previous = QPointF(x, to_y(column.last));
+		previous_time = column.last_time;
+	}
+
+	// And leave towards the first sample after it
+	if(bins.next)
+		connect(bins.next->time, QPointF(to_x(bins.next->time), to_y(bins.next->value)));
+}
+
+std::vector<EnvelopeBins> bin_envelopes(const std::vector<EnvelopeLayer> &layers, size_t width, double start, double end)
+{
+	std::vector<EnvelopeBins> result(layers.size());
+
+	if(width == 0 || end <= start)
+		return result;
+
+	for(size_t i = 0; i < layers.size(); ++ i)
+	{
+		if(layers[i].count > 0)
+			result[i] = bin_layer(layers[i], width, start, end);
+	}
+
+	return result;
+}
+
+void draw_envelopes(QPainter &painter, const std::vector<EnvelopeLayer> &layers, const std::vector<EnvelopeBins> &bins, QSize size, double start, double end)
+{
+	if(size.isEmpty() || end <= start)
+		return;
+
+	for(size_t i = 0; i < layers.size() && i < bins.size(); ++ i)
+	{
+		const EnvelopeLayer &layer = layers[i];
+
+		if(bins[i].columns.empty() || layer.maximum <= layer.minimum)
+			continue;
+
+		painter.setPen(QPen(layer.color, layer.line_width));
+		draw_layer(painter, layer, bins[i], size, start, end);
+	}
+}
@@ -0,0 +1,74 @@
+//
+// EnvelopeRenderer.h
+//
+
+#ifndef ENVELOPERENDERER_H
+#define ENVELOPERENDERER_H
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+#include <QColor>
+#include <QPainter>
+
+// A single line to draw, the arrays are borrowed and have to outlive the call to bin_envelopes()
+struct EnvelopeLayer
+{
+	const double *timestamps = nullptr; // Seconds, sorted
+	const double *values = nullptr;
+	size_t count = 0;
+
+	double time_offset = 0.0; // Subtracted from the timestamps
+	double scale = 1.0; // Applied to the values
+
+	double minimum = 0.0; // Vertical range mapped to the bottom and top of the image, only used by draw_envelopes()
+	double maximum = 1.0;
+
+	QColor color;
+	qreal line_width = 2.0;
+};
+
+struct EnvelopeSample
+{
+	double time; // Seconds, with the time offset of the layer already removed
+	double value; // Scaled
+};
+
+// The samples of one pixel column
+struct EnvelopeColumn
+{
+	double minimum = 0.0;
+	double maximum = 0.0;
+	double first = 0.0;
+	double last = 0.0;
+
+	double first_time = 0.0;
+	double last_time = 0.0;
+
+	bool used = false;
+};
+
+// One layer binned into pixel columns. It only holds times and values, so the same bins can be drawn at any vertical range
+struct EnvelopeBins
+{
+	std::vector<EnvelopeColumn> columns;
+
+	std::optional<EnvelopeSample> previous; // Last sample before the binned range, the line enters from it
+	std::optional<EnvelopeSample> next; // First sample after the binned range, the line leaves towards it
+
+	size_t get_size_in_bytes() const { return sizeof(EnvelopeBins) + columns.size() * sizeof(EnvelopeColumn); }
+};
+
+// Bins every layer into width pixel columns covering [start, end]. This is the only step whose cost depends on the number of samples,
+// the columns are binned on all cores
+std::vector<EnvelopeBins> bin_envelopes(const std::vector<EnvelopeLayer> &layers, size_t width, double start, double end);
+
+// Draws the bins of bin_envelopes() into size pixels of the painter, covering [start, end] horizontally. The layers have to be the ones
+// the bins were created from, but only their vertical range, color and line width are used.
+// Every pixel column gets a vertical line covering the minimum and maximum of its samples, and neighbouring columns are connected from the
+// last sample of one to the first sample of the next. This keeps spikes visible no matter how many samples fall into a column, and the cost only
+// depends on the number of columns and not on the number of points a QLineSeries would have to lay out.
+// Values are treated as sticky for gaps of a second or more just like the line series.
+void draw_envelopes(QPainter &painter, const std::vector<EnvelopeLayer> &layers, const std::vector<EnvelopeBins> &bins, QSize size, double start, double end);
+
+#endif //ENVELOPERENDERER_H
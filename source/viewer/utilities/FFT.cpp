@@ -0,0 +1,80 @@
+//
+// FFT.cpp
+//
+
+#include <bit>
+#include <numbers>
+#include <stdexcept>
+#include "FFT.h"
+
+FFTPlan::FFTPlan(size_t size) :
+	m_size(size),
+	m_twiddles(size / 2),
+	m_reversed(size)
+{
+	if(size == 0 || !std::has_single_bit(size))
+		throw std::invalid_argument("FFT size must be a power of two");
+
+	const int bits = std::countr_zero(size);
+
+	for(size_t i = 0; i < size / 2; ++ i)
+		m_twiddles[i] = std::polar(1.0, -2.0 * std::numbers::pi * double(i) / double(size));
+
+	for(size_t i = 0; i < size; ++ i)
+	{
+		uint32_t reversed_index = 0;
+
+		for(int bit = 0; bit < bits; ++ bit)
+			reversed_index |= uint32_t((i >> bit) & 1) << (bits - 1 - bit);
+
+		m_reversed[i] = reversed_index;
+	}
+}
+
+void FFTPlan::forward(std::vector<std::complex<double>> &data) const
+{
+	transform(data, false);
+}
+
+void FFTPlan::inverse(std::vector<std::complex<double>> &data) const
+{
+	transform(data, true);
+
+	const double scale = 1.0 / double(m_size);
+
+	for(auto &value : data)
+		value *= scale;
+}
+
+void FFTPlan::transform(std::vector<std::complex<double>> &data, bool inverse) const
+{
+	const size_t size = m_size;
+
+	if(data.size() != size)
+		throw std::invalid_argument("FFT input doesn't match the plan size");
+
+	for(size_t i = 0; i < size; ++ i)
+	{
+		if(i < m_reversed[i])
+			std::swap(data[i], data[m_reversed[i]]);
+	}
+
+	for(size_t length = 2; length <= size; length *= 2)
+	{
+		const size_t half = length / 2;
+		const size_t stride = size / length;
+
+		for(size_t start = 0; start < size; start += length)
+		{
+			for(size_t i = 0; i < half; ++ i)
+			{
+				const std::complex<double> twiddle = inverse ? std::conj(m_twiddles[i * stride]) : m_twiddles[i * stride];
+				const std::complex<double> odd = data[start + i + half] * twiddle;
+				const std::complex<double> even = data[start + i];
+
+				data[start + i] = even + odd;
+				data[start + i + half] = even - odd;
+			}
+		}
+	}
+}
@@ -0,0 +1,33 @@
+//
+// FFT.h
+//
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Iterative radix-2 fast Fourier transform. The plan only depends on the size, so a single plan can be shared by any number of threads
+class FFTPlan
+{
+public:
+	explicit FFTPlan(size_t size); // Will throw std::invalid_argument() unless size is a power of two
+
+	size_t get_size() const { return m_size; }
+
+	// Both work in place on get_size() values in their natural order. The inverse is scaled by 1 / size, so it undoes forward() exactly
+	void forward(std::vector<std::complex<double>> &data) const;
+	void inverse(std::vector<std::complex<double>> &data) const;
+
+private:
+	void transform(std::vector<std::complex<double>> &data, bool inverse) const;
+
+	size_t m_size;
+	std::vector<std::complex<double>> m_twiddles; // size / 2
+	std::vector<uint32_t> m_reversed; // Bit reversed index of every element
+};
+
+#endif //FFT_H
@@ -0,0 +1,176 @@
+//
+// HitchDetector.cpp
+//
+
+#include <algorithm>
+#include <telemetry/known_providers.h>
+#include "HitchDetector.h"
+#include "SmoothingCache.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HITCH_DETECTOR_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define HITCH_DETECTOR_NEON 1
+#endif
+
+// A frame is a hitch if it is slower than min(absolute_threshold, max(minimum_duration, median * median_multiple)).
+// Both kernels compare two frames per iteration, the scalar loop picks up the remainder
+static std::vector<uint8_t> flag_hitches(const double *values, const double *medians, size_t count, const HitchSettings &settings)
+{
+	std::vector<uint8_t> flags(count);
+
+	size_t i = 0;
+
+#if HITCH_DETECTOR_SSE2
+	const __m128d absolute = _mm_set1_pd(settings.absolute_threshold);
+	const __m128d minimum = _mm_set1_pd(settings.minimum_duration);
+	const __m128d multiple = _mm_set1_pd(settings.median_multiple);
+
+	for(; i + 2 <= count; i += 2)
+	{
+		const __m128d threshold = _mm_min_pd(absolute, _mm_max_pd(minimum, _mm_mul_pd(multiple, _mm_loadu_pd(medians + i))));
+		const int mask = _mm_movemask_pd(_mm_cmpgt_pd(_mm_loadu_pd(values + i), threshold));
+
+		flags[i] = uint8_t(mask & 1);
+		flags[i + 1] = uint8_t(mask >> 1);
+	}
+#elif HITCH_DETECTOR_NEON
+	const float64x2_t absolute = vdupq_n_f64(settings.absolute_threshold);
+	const float64x2_t minimum = vdupq_n_f64(settings.minimum_duration);
+	const float64x2_t multiple = vdupq_n_f64(settings.median_multiple);
+
+	for(; i + 2 <= count; i += 2)
+	{
+		const float64x2_t threshold = vminq_f64(absolute, vmaxq_f64(minimum, vmulq_f64(multiple, vld1q_f64(medians + i))));
+		const uint64x2_t mask = vcgtq_f64(vld1q_f64(values + i), threshold);
+
+		flags[i] = uint8_t(vgetq_lane_u64(mask, 0) & 1);
+		flags[i + 1] = uint8_t(vgetq_lane_u64(mask, 1) & 1);
+	}
+#endif
+
+	for(; i < count; ++ i)
+	{
+		const double threshold = std::min(settings.absolute_threshold, std::max(settings.minimum_duration, medians[i] * settings.median_multiple));
+		flags[i] = values[i] > threshold;
+	}
+
+	return flags;
+}
+
+std::vector<HitchEpisode> detect_hitches(HitchEpisode::Source source, const double *timestamps, const double *values, const double *medians, size_t count, const HitchSettings &settings)
+{
+	const std::vector<uint8_t> flags = flag_hitches(values, medians, count, settings);
+
+	std::vector<HitchEpisode> episodes;
+	double episode_end = 0.0;
+
+	for(size_t i = 0; i < count; ++ i)
+	{
+		if(!flags[i])
+			continue;
+
+		const double end = timestamps[i];
+		const double start = end - values[i];
+
+		if(episodes.empty() || start - episode_end > settings.episode_gap)
+		{
+			HitchEpisode episode;
+			episode.source = source;
+			episode.start = telemetry_time::from_seconds(start);
+
+			episodes.push_back(episode);
+		}
+
+		HitchEpisode &episode = episodes.back();
+		episode.end = telemetry_time::from_seconds(end);
+		episode.frame_count ++;
+		episode.worst_frame = std::max(episode.worst_frame, values[i]);
+		episode.stall_time += std::max(0.0, values[i] - medians[i]);
+
+		episode_end = end;
+	}
+
+	return episodes;
+}
+
+std::vector<HitchEpisode> detect_hitches(const telemetry_container &container, const HitchSettings &settings)
+{
+	std::vector<HitchEpisode> result;
+
+	if(!container.has_provider(provider_timing::identifier))
+		return result;
+
+	const telemetry_provider &provider = container.get_provider(provider_timing::identifier);
+
+	const std::pair<provider_timing::field_id, HitchEpisode::Source> sources[] = {
+		{ provider_timing::time, HitchEpisode::Source::Frame },
+		{ provider_timing::cpu, HitchEpisode::Source::Cpu },
+		{ provider_timing::gpu, HitchEpisode::Source::Gpu }
+	};
+
+	SmoothingSettings median;
+	median.kernel = SmoothingSettings::Kernel::Median;
+	median.window = settings.median_window;
+
+	// Only lives for this call, it's just the quickest way to get the values and their rolling median as contiguous arrays
+	SmoothingCache cache;
+
+	for(auto &[field_id, source] : sources)
+	{
+		if(!provider.has_field(field_id))
+			continue;
+
+		const telemetry_field &field = provider.get_field(field_id);
+
+		if(field.empty() || !field.is_loaded())
+			continue;
+
+		const SmoothingSeries &raw = cache.get_raw(&field);
+		const std::vector<double> &medians = cache.get_smoothed(&field, median);
+
+		std::vector<HitchEpisode> episodes = detect_hitches(source, raw.timestamps.data(), raw.values.data(), medians.data(), raw.values.size(), settings);
+		result.insert(result.end(), episodes.begin(), episodes.end());
+	}
+
+	std::stable_sort(result.begin(), result.end(), [](const HitchEpisode &lhs, const HitchEpisode &rhs) {
+		return lhs.start < rhs.start;
+	});
+
+	return result;
+}
+
+HitchReport summarize_hitches(const std::vector<HitchEpisode> &episodes, HitchEpisode::Source source, telemetry_time start, telemetry_time end)
+{
+	HitchReport report;
+
+	for(auto &episode : episodes)
+	{
+		if(episode.source != source || episode.start < start || episode.start > end)
+			continue;
+
+		report.episode_count ++;
+		report.frame_count += episode.frame_count;
+		report.worst_frame = std::max(report.worst_frame, episode.worst_frame);
+		report.stall_time += episode.stall_time;
+	}
+
+	return report;
+}
+
+const char *get_hitch_source_name(HitchEpisode::Source source)
+{
+	switch(source)
+	{
+		case HitchEpisode::Source::Frame:
+			return "Frame";
+		case HitchEpisode::Source::Cpu:
+			return "CPU";
+		case HitchEpisode::Source::Gpu:
+			return "GPU";
+	}
+
+	return "Unknown";
+}
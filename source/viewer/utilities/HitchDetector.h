@@ -0,0 +1,64 @@
+//
+// HitchDetector.h
+//
+
+#ifndef HITCHDETECTOR_H
+#define HITCHDETECTOR_H
+
+#include <cstddef>
+#include <vector>
+#include <telemetry/container.h>
+
+struct HitchSettings
+{
+	double absolute_threshold = 0.05; // Seconds, frames at least this slow are always hitches
+	double median_multiple = 2.0; // Frames slower than this multiple of the rolling median are hitches too...
+	double minimum_duration = 1.0 / 30.0; // ...if they are also slower than this, so that jitter at high frame rates doesn't count
+	uint32_t median_window = 31; // Frames
+	double episode_gap = 0.5; // Seconds, hitches closer together than this belong to the same episode
+
+	bool operator ==(const HitchSettings &other) const = default;
+};
+
+// A run of slow frames close enough together to be felt as a single stutter
+struct HitchEpisode
+{
+	enum class Source : uint8_t
+	{
+		Frame,
+		Cpu,
+		Gpu
+	};
+
+	Source source;
+
+	telemetry_time start; // Start of the first slow frame
+	telemetry_time end; // End of the last slow frame
+
+	uint32_t frame_count = 0;
+	double worst_frame = 0.0; // Seconds
+	double stall_time = 0.0; // Seconds the slow frames took on top of the rolling median
+};
+
+struct HitchReport
+{
+	uint32_t episode_count = 0;
+	uint32_t frame_count = 0;
+	double worst_frame = 0.0;
+	double stall_time = 0.0;
+};
+
+// Flags the frames of one contiguous frame time series and groups them into episodes. The timestamps are in seconds and mark the end of
+// each frame, the medians are the rolling median of the values and all three arrays have count entries
+std::vector<HitchEpisode> detect_hitches(HitchEpisode::Source source, const double *timestamps, const double *values, const double *medians, size_t count, const HitchSettings &settings);
+
+// Runs the detection over the time, cpu and gpu fields of provider_timing. Returns the episodes of all three sorted by their start,
+// the container should hold the fields at full resolution
+std::vector<HitchEpisode> detect_hitches(const telemetry_container &container, const HitchSettings &settings);
+
+// Combines the episodes of the source that start within [start, end]
+HitchReport summarize_hitches(const std::vector<HitchEpisode> &episodes, HitchEpisode::Source source, telemetry_time start, telemetry_time end);
+
+const char *get_hitch_source_name(HitchEpisode::Source source);
+
+#endif //HITCHDETECTOR_H
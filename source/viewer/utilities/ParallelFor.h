@@ -0,0 +1,96 @@
+//
+// ParallelFor.h
+//
+
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <QThreadPool>
+
+// Calls function(i) for every i in [0, count) on the threads of QThreadPool::globalInstance() and blocks until all calls are done.
+// The calling thread takes part in the work and helpers are only started on threads that are idle right now, so nested calls and calls
+// from other pools neither wait on queued work nor start more threads than the global pool has.
+// The first exception thrown by function is rethrown on the calling thread once all helpers are done, the remaining items are skipped
+template<class F>
+void parallel_for(size_t count, F &&function)
+{
+	if(count == 0)
+		return;
+
+	QThreadPool *pool = QThreadPool::globalInstance();
+	const size_t helpers = std::min<size_t>(count, std::max(pool->maxThreadCount(), 1)) - 1;
+
+	if(helpers == 0)
+	{
+		for(size_t i = 0; i < count; ++ i)
+			function(i);
+
+		return;
+	}
+
+	std::atomic<size_t> next = 0;
+
+	std::mutex lock;
+	std::condition_variable done;
+	size_t running = 0; // Helpers that were started and haven't left the worker loop yet
+	std::exception_ptr exception;
+
+	auto worker = [&]() {
+		try
+		{
+			for(size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+				function(i);
+		}
+		catch(...)
+		{
+			std::lock_guard guard(lock);
+
+			if(!exception)
+				exception = std::current_exception();
+
+			next = count;
+		}
+	};
+
+	for(size_t i = 0; i < helpers; ++ i)
+	{
+		{
+			std::lock_guard guard(lock);
+			running ++;
+		}
+
+		const bool started = pool->tryStart([&]() {
+
+			worker();
+
+			std::lock_guard guard(lock);
+
+			if((-- running) == 0)
+				done.notify_all();
+
+		});
+
+		if(!started)
+		{
+			std::lock_guard guard(lock);
+			running --;
+
+			break;
+		}
+	}
+
+	worker();
+
+	std::unique_lock guard(lock);
+	done.wait(guard, [&]() { return running == 0; });
+
+	if(exception)
+		std::rethrow_exception(exception);
+}
+
+#endif //PARALLELFOR_H
@@ -6,68 +6,59 @@
 #include <algorithm>
 #include "PerformanceCalculator.h"
 
-PerformanceCalculator::PerformanceCalculator(const telemetry_field &field, uint32_t start, uint32_t end)
+PerformanceCalculator::PerformanceCalculator(const telemetry_field &field, telemetry_time start, telemetry_time end)
 {
-	m_samples = field.get_data_points_in_range(start, end);
+	const std::vector<telemetry_data_point> samples = field.get_data_points_in_range(start, end);
+
+	std::vector<double> values;
+
+	// Converted once with the type resolved up front, so that sorting and all the statistics work on plain doubles
+	visit_telemetry_type(field.get_type(), [&](auto tag) {
+
+		constexpr telemetry_type Type = decltype(tag)::value;
+
+		if constexpr (is_telemetry_type_convertible<double>(Type))
+		{
+			values.resize(samples.size());
+
+			for(size_t i = 0; i < samples.size(); ++ i)
+				values[i] = samples[i].value.get_as<double, Type>();
+		}
+		else if(!samples.empty())
+			throw std::runtime_error("Unsupported type conversion");
 
-	std::sort(m_samples.begin(), m_samples.end(), [](const telemetry_data_point &lhs, const telemetry_data_point &rhs) {
-		return lhs.value.get<double>() < rhs.value.get<double>();
 	});
+
+	m_values = telemetry_sorted_values(std::move(values));
 }
 
 double PerformanceCalculator::calculate_average() const
 {
-	if(m_samples.empty())
-		return 0.0;
-
-	double sum = 0.0;
-
-	for(const auto &sample : m_samples)
-		sum += sample.value.get<double>();
-
-	return sum / m_samples.size();
+	return m_values.get_summary().mean;
 }
 
 double PerformanceCalculator::calculate_percentile(float percentile) const
 {
-	if(m_samples.empty())
-		return 0.0;
-
-	double total_time = 0.0;
-
-	for(const auto &sample : m_samples)
-		total_time += sample.value.get<double>();
-
-	const double needle = total_time * percentile;
-
-	total_time = 0.0;
-
-	for(const auto &sample : m_samples)
-	{
-		if(total_time >= needle)
-			return sample.value.get<double>();
-
-		total_time += sample.value.get<double>();
-	}
-
-	return m_samples.back().value.get<double>();
+	return m_values.get_weighted_percentile(percentile);
 }
 
 double PerformanceCalculator::get_median_value(size_t start, size_t end) const
 {
-	Q_ASSERT(start < m_samples.size());
-	Q_ASSERT(end <= m_samples.size());
+	const std::vector<double> &values = m_values.get_values();
+
+	Q_ASSERT(start < values.size());
+	Q_ASSERT(end <= values.size());
 
 	const size_t count = end - start;
 	const size_t half = count / 2;
 
 	if(count & 0x1 && count > 1)
 	{
-		const double right = m_samples[half + start].value.get<double>();
-		const double left = m_samples[half - 1 + start].value.get<double>();
+		const double right = values[half + start];
+		const double left = values[half - 1 + start];
 
 		return (right + left) / 2.0;
 	}
 
-	return m_samples[half + start].value.get<double>();
+	return values[half + start];
 }
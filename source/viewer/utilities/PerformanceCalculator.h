@@ -6,25 +6,27 @@
 #define PERFORMANCE_DATA_H
 
 #include <telemetry/container.h>
+#include <telemetry/summary.h>
 
 class PerformanceCalculator
 {
 public:
-	PerformanceCalculator(const telemetry_field &field, uint32_t start, uint32_t end);
+	PerformanceCalculator(const telemetry_field &field, telemetry_time start, telemetry_time end);
 
-	size_t get_sample_count() const { return m_samples.size(); }
+	size_t get_sample_count() const { return m_values.size(); }
 
 	double calculate_average() const;
 	double calculate_percentile(float percentile) const;
 
-	double get_sample(size_t index) const { return m_samples.at(index).value.get<double>(); }
+	double get_sample(size_t index) const { return m_values.get_values().at(index); }
 	double get_median_value(size_t start, size_t end) const;
 
-	double get_minimum() const { return m_samples.front().value.get<double>(); }
-	double get_maximum() const { return m_samples.back().value.get<double>(); }
+	double get_minimum() const { return m_values.get_summary().minimum; }
+	double get_maximum() const { return m_values.get_summary().maximum; }
+	double get_variance() const { return m_values.get_summary().variance; }
 
 private:
-	std::vector<telemetry_data_point> m_samples;
+	telemetry_sorted_values m_values;
 };
 
 #endif //PERFORMANCE_DATA_H
@@ -0,0 +1,178 @@
+//
+// Periodogram.cpp
+//
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include "FFT.h"
+#include "Periodogram.h"
+#include "ParallelFor.h"
+
+namespace
+{
+	constexpr size_t minimum_window_size = 64;
+	constexpr size_t maximum_window_size = 16384;
+	constexpr double peak_threshold = 4.0; // Multiple of the average bin a peak needs to reach to count as dominant
+	constexpr size_t harmonic_count = 8;
+}
+
+// Hann window
+static std::vector<double> create_taper(size_t size)
+{
+	std::vector<double> taper(size);
+
+	for(size_t i = 0; i < size; ++ i)
+		taper[i] = 0.5 - 0.5 * std::cos(2.0 * std::numbers::pi * double(i) / double(size - 1));
+
+	return taper;
+}
+
+static std::vector<double> window_power(const double *values, const FFTPlan &plan, const std::vector<double> &taper)
+{
+	const size_t size = plan.get_size();
+
+	double mean = 0.0;
+
+	for(size_t i = 0; i < size; ++ i)
+		mean += values[i];
+
+	mean /= size;
+
+	std::vector<std::complex<double>> data(size);
+
+	for(size_t i = 0; i < size; ++ i)
+		data[i] = (values[i] - mean) * taper[i];
+
+	plan.forward(data);
+
+	std::vector<double> power(size / 2 + 1);
+
+	for(size_t i = 0; i <= size / 2; ++ i)
+		power[i] = std::norm(data[i]);
+
+	return power;
+}
+
+// Periodic stutters are spikes rather than waves, which spread their power over all multiples of their frequency in about equal parts.
+// Peaks are therefore ranked by the power summed over their harmonics, which singles out the fundamental, and harmonics of a period that was
+// already picked are skipped
+static std::vector<double> find_dominant_periods(const Periodogram &periodogram, size_t count)
+{
+	const std::vector<double> &power = periodogram.power;
+	const size_t last = power.size() - 1;
+
+	auto power_near = [&](size_t bin) {
+		return std::max({ power[bin - 1], power[bin], bin < last ? power[bin + 1] : 0.0 });
+	};
+
+	struct peak
+	{
+		size_t bin;
+		double harmonic_power;
+	};
+
+	// The lowest bins are mostly leakage from slow trends, they don't make for a meaningful period
+	std::vector<peak> peaks;
+	const double threshold = peak_threshold * 100.0 / last;
+
+	for(size_t i = 2; i < last; ++ i)
+	{
+		if(power[i] <= power[i - 1] || power[i] < power[i + 1] || power[i] < threshold)
+			continue;
+
+		double harmonic_power = 0.0;
+
+		for(size_t harmonic = 1; harmonic <= harmonic_count && i * harmonic <= last; ++ harmonic)
+			harmonic_power += power_near(i * harmonic);
+
+		peaks.push_back({ i, harmonic_power });
+	}
+
+	std::sort(peaks.begin(), peaks.end(), [&](const peak &lhs, const peak &rhs) {
+		return lhs.harmonic_power > rhs.harmonic_power;
+	});
+
+	std::vector<size_t> picked;
+
+	for(auto &candidate : peaks)
+	{
+		if(picked.size() >= count)
+			break;
+
+		const bool is_harmonic = std::any_of(picked.begin(), picked.end(), [&](size_t bin) {
+			const size_t multiple = (candidate.bin + bin / 2) / bin;
+			return multiple >= 2 && std::abs(double(candidate.bin) - double(multiple * bin)) <= double(multiple);
+		});
+
+		if(!is_harmonic)
+			picked.push_back(candidate.bin);
+	}
+
+	std::vector<double> periods;
+
+	for(size_t bin : picked)
+		periods.push_back(periodogram.get_period(bin));
+
+	return periods;
+}
+
+Periodogram compute_periodogram(const std::vector<double> &values, double sample_rate, PeriodogramExecution execution, size_t dominant_period_count)
+{
+	Periodogram result;
+
+	if(values.size() < minimum_window_size || sample_rate <= 0.0)
+		return result;
+
+	const size_t window_size = std::clamp(std::bit_floor(values.size() / 4), minimum_window_size, maximum_window_size);
+	const size_t hop = window_size / 2;
+	const size_t window_count = (values.size() - window_size) / hop + 1;
+
+	const FFTPlan plan(window_size);
+	const std::vector<double> taper = create_taper(window_size);
+
+	std::vector<std::vector<double>> powers(window_count);
+
+	auto transform = [&](size_t i) {
+		powers[i] = window_power(values.data() + i * hop, plan, taper);
+	};
+
+	if(execution == PeriodogramExecution::Parallel)
+		parallel_for(window_count, transform);
+	else
+	{
+		for(size_t i = 0; i < window_count; ++ i)
+			transform(i);
+	}
+
+	result.sample_rate = sample_rate;
+	result.window_size = window_size;
+	result.window_count = window_count;
+	result.power.assign(window_size / 2 + 1, 0.0);
+
+	for(auto &power : powers)
+	{
+		for(size_t i = 0; i < power.size(); ++ i)
+			result.power[i] += power[i];
+	}
+
+	double total = 0.0;
+
+	for(size_t i = 1; i < result.power.size(); ++ i)
+		total += result.power[i];
+
+	result.power[0] = 0.0;
+
+	// A perfectly flat series has no power at all
+	if(total > 0.0)
+	{
+		for(auto &power : result.power)
+			power *= 100.0 / total;
+	}
+
+	result.dominant_periods = find_dominant_periods(result, dominant_period_count);
+
+	return result;
+}
@@ -0,0 +1,42 @@
+//
+// Periodogram.h
+//
+
+#ifndef PERIODOGRAM_H
+#define PERIODOGRAM_H
+
+#include <cstddef>
+#include <vector>
+
+// Power spectrum of a series sampled on a uniform grid, see compute_periodogram()
+struct Periodogram
+{
+	double sample_rate = 0.0; // Hz
+	size_t window_size = 0; // Samples per transformed window
+	size_t window_count = 0;
+
+	// Share of the total power in percent for the bins [0, window_size / 2], bin i is at i * sample_rate / window_size Hz.
+	// Every window has its mean removed, so bin 0 is always zero
+	std::vector<double> power;
+	std::vector<double> dominant_periods; // Seconds, strongest first
+
+	bool empty() const { return power.empty(); }
+
+	double get_frequency(size_t bin) const { return bin * sample_rate / window_size; }
+	double get_period(size_t bin) const { return window_size / (bin * sample_rate); }
+};
+
+// Callers that already spread their work over all cores transform the windows serially, nesting both would start up to cores² threads
+enum class PeriodogramExecution
+{
+	Parallel,
+	Serial
+};
+
+// Welch's method: the values are split into half overlapping windows with a Hann taper, every window is transformed on its own thread unless
+// the execution is serial, and their power spectra are averaged. The window is the largest power of two that still gives at least seven windows,
+// so longer ranges resolve longer periods. Dominant periods are the strongest peaks that stand out from the average bin by a wide margin.
+// Returns an empty periodogram if there are too few values
+Periodogram compute_periodogram(const std::vector<double> &values, double sample_rate, PeriodogramExecution execution = PeriodogramExecution::Parallel, size_t dominant_period_count = 3);
+
+#endif //PERIODOGRAM_H
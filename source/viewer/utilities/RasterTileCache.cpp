@@ -0,0 +1,73 @@
+//
+// RasterTileCache.cpp
+//
+
+#include "RasterTileCache.h"
+
+RasterTileCache::RasterTileCache(size_t capacity) :
+	m_capacity(capacity)
+{}
+
+const std::vector<EnvelopeBins> *RasterTileCache::find(const RasterTileKey &key)
+{
+	auto iterator = m_lookup.find(key);
+
+	if(iterator == m_lookup.end())
+		return nullptr;
+
+	m_tiles.splice(m_tiles.begin(), m_tiles, iterator->second);
+
+	return &iterator->second->second;
+}
+
+void RasterTileCache::insert(const RasterTileKey &key, std::vector<EnvelopeBins> &&tile)
+{
+	auto iterator = m_lookup.find(key);
+
+	if(iterator != m_lookup.end())
+	{
+		m_size -= get_size_in_bytes(iterator->second->second);
+		m_tiles.erase(iterator->second);
+		m_lookup.erase(iterator);
+	}
+
+	m_size += get_size_in_bytes(tile);
+	m_tiles.emplace_front(key, std::move(tile));
+	m_lookup.emplace(key, m_tiles.begin());
+
+	// Always keep the newest tile, even if it alone exceeds the capacity
+	while(m_size > m_capacity && m_tiles.size() > 1)
+	{
+		auto &[ old_key, old_tile ] = m_tiles.back();
+
+		m_size -= get_size_in_bytes(old_tile);
+		m_lookup.erase(old_key);
+		m_tiles.pop_back();
+	}
+}
+
+void RasterTileCache::set_pending(const RasterTileKey &key, bool pending)
+{
+	if(pending)
+		m_pending.insert(key);
+	else
+		m_pending.erase(key);
+}
+
+size_t RasterTileCache::get_size_in_bytes(const std::vector<EnvelopeBins> &tile)
+{
+	size_t size = 0;
+
+	for(auto &bins : tile)
+		size += bins.get_size_in_bytes();
+
+	return size;
+}
+
+void RasterTileCache::clear()
+{
+	m_tiles.clear();
+	m_lookup.clear();
+	m_pending.clear();
+	m_size = 0;
+}
@@ -0,0 +1,60 @@
+//
+// RasterTileCache.h
+//
+
+#ifndef RASTERTILECACHE_H
+#define RASTERTILECACHE_H
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+#include "EnvelopeRenderer.h"
+
+// Identifies one tile of a raster chart. Tiles are laid out on a fixed grid starting at time 0, so panning at the same zoom level
+// keeps hitting the same tiles and only the ones scrolling into view have to be binned. The tiles hold the binned values and not pixels,
+// so neither the height of the chart nor the vertical range of its axes are part of the key
+struct RasterTileKey
+{
+	uint64_t content; // Hash of everything that affects the binned values
+	double seconds_per_pixel;
+	int64_t index;
+
+	auto operator <=>(const RasterTileKey &other) const = default;
+};
+
+// Least recently used cache of binned tiles, one EnvelopeBins per layer, only meant to be used from the UI thread.
+// Tiles that are being binned are tracked as pending, so they aren't queued up a second time
+class RasterTileCache
+{
+public:
+	static constexpr int32_t tile_width = 256; // In pixels
+
+	explicit RasterTileCache(size_t capacity = 64 * 1024 * 1024);
+
+	const std::vector<EnvelopeBins> *find(const RasterTileKey &key);
+	void insert(const RasterTileKey &key, std::vector<EnvelopeBins> &&tile);
+
+	bool is_pending(const RasterTileKey &key) const { return m_pending.contains(key); }
+	void set_pending(const RasterTileKey &key, bool pending);
+	void clear_pending() { m_pending.clear(); }
+
+	void clear();
+
+private:
+	using tile_list = std::list<std::pair<RasterTileKey, std::vector<EnvelopeBins>>>;
+
+	static size_t get_size_in_bytes(const std::vector<EnvelopeBins> &tile);
+
+	size_t m_capacity; // In bytes
+	size_t m_size = 0;
+
+	tile_list m_tiles; // Most recently used first
+	std::map<RasterTileKey, tile_list::iterator> m_lookup;
+	std::set<RasterTileKey> m_pending;
+};
+
+#endif //RASTERTILECACHE_H
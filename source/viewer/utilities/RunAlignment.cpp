@@ -0,0 +1,244 @@
+//
+// RunAlignment.cpp
+//
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <telemetry/known_providers.h>
+#include <telemetry/resample.h>
+#include "FFT.h"
+#include "RunAlignment.h"
+
+namespace
+{
+	constexpr size_t maximum_fine_samples = 1 << 17;
+
+	struct signal_pair
+	{
+		const telemetry_field *reference;
+		const telemetry_field *run;
+	};
+
+	// Sum of the normalized cross-correlations of all signals, and the number of signals that weren't constant
+	struct combined_correlation
+	{
+		std::vector<double> values;
+		size_t signal_count = 0;
+	};
+}
+
+static double remove_mean(std::vector<double> &values)
+{
+	double mean = 0.0;
+
+	for(double value : values)
+		mean += value;
+
+	mean /= double(values.size());
+
+	double energy = 0.0;
+
+	for(double &value : values)
+	{
+		value -= mean;
+		energy += value * value;
+	}
+
+	return energy;
+}
+
+std::vector<double> cross_correlate(const std::vector<double> &a, const std::vector<double> &b, size_t max_lag)
+{
+	if(a.empty() || b.empty())
+		return {};
+
+	std::vector<double> centered_a = a;
+	std::vector<double> centered_b = b;
+
+	const double energy = std::sqrt(remove_mean(centered_a) * remove_mean(centered_b));
+
+	if(!(energy > 0.0))
+		return {};
+
+	// Zero padded so that the circular correlation doesn't wrap around into the lags we look at
+	const size_t size = std::bit_ceil(std::max(a.size(), b.size()) + max_lag + 1);
+	const FFTPlan plan(size);
+
+	// Both real series are transformed at once as the real and imaginary part of one complex series
+	std::vector<std::complex<double>> data(size);
+
+	for(size_t i = 0; i < centered_a.size(); ++ i)
+		data[i].real(centered_a[i]);
+	for(size_t i = 0; i < centered_b.size(); ++ i)
+		data[i].imag(centered_b[i]);
+
+	plan.forward(data);
+
+	// A = (X[k] + conj(X[-k])) / 2 and B = (X[k] - conj(X[-k])) / 2i, the correlation is the inverse of conj(A) * B
+	std::vector<std::complex<double>> product(size);
+
+	for(size_t k = 0; k < size; ++ k)
+	{
+		const std::complex<double> x = data[k];
+		const std::complex<double> mirrored = std::conj(data[(size - k) % size]);
+
+		const std::complex<double> transformed_a = (x + mirrored) * 0.5;
+		const std::complex<double> transformed_b = (x - mirrored) * std::complex<double>(0.0, -0.5);
+
+		product[k] = std::conj(transformed_a) * transformed_b;
+	}
+
+	plan.inverse(product);
+
+	std::vector<double> result(2 * max_lag + 1);
+
+	for(size_t i = 0; i < result.size(); ++ i)
+	{
+		const int64_t lag = int64_t(i) - int64_t(max_lag);
+		const size_t index = (lag >= 0) ? size_t(lag) : size - size_t(-lag);
+
+		result[i] = product[index].real() / energy;
+	}
+
+	return result;
+}
+
+static combined_correlation correlate_signals(const std::vector<signal_pair> &signals, const telemetry_time_grid &reference_grid, const telemetry_time_grid &run_grid, size_t max_lag)
+{
+	combined_correlation result;
+	result.values.assign(2 * max_lag + 1, 0.0);
+
+	for(auto &signal : signals)
+	{
+		try
+		{
+			const std::vector<double> a = resample_telemetry_field(*signal.reference, reference_grid, telemetry_resample_mode::hold);
+			const std::vector<double> b = resample_telemetry_field(*signal.run, run_grid, telemetry_resample_mode::hold);
+
+			const std::vector<double> correlation = cross_correlate(a, b, max_lag);
+
+			if(correlation.empty())
+				continue;
+
+			for(size_t i = 0; i < correlation.size(); ++ i)
+				result.values[i] += correlation[i];
+
+			result.signal_count ++;
+		}
+		catch(...)
+		{}
+	}
+
+	return result;
+}
+
+static size_t find_peak(const std::vector<double> &values)
+{
+	return size_t(std::max_element(values.begin(), values.end()) - values.begin());
+}
+
+RunAlignment align_runs(const telemetry_container &reference, const telemetry_container &run, const RunAlignmentSettings &settings)
+{
+	RunAlignment result;
+
+	const std::pair<const char *, uint8_t> candidates[] = {
+		{ provider_timing::identifier, uint8_t(provider_timing::fps) },
+		{ provider_sim_apup::identifier, uint8_t(provider_sim_apup::do_world) }
+	};
+
+	std::vector<signal_pair> signals;
+
+	for(auto &[ identifier, field_id ] : candidates)
+	{
+		if(!reference.has_provider(identifier) || !run.has_provider(identifier))
+			continue;
+
+		const telemetry_provider &reference_provider = reference.get_provider(identifier);
+		const telemetry_provider &run_provider = run.get_provider(identifier);
+
+		if(!reference_provider.has_field(field_id) || !run_provider.has_field(field_id))
+			continue;
+
+		const telemetry_field &reference_field = reference_provider.get_field(field_id);
+		const telemetry_field &run_field = run_provider.get_field(field_id);
+
+		if(reference_field.empty() || run_field.empty())
+			continue;
+
+		signals.push_back({ &reference_field, &run_field });
+	}
+
+	const double reference_start = reference.get_start_seconds();
+	const double reference_end = reference.get_end_seconds();
+	const double run_start = run.get_start_seconds();
+	const double run_end = run.get_end_seconds();
+
+	if(signals.empty() || reference_end <= reference_start || run_end <= run_start)
+		return result;
+
+	// Coarse pass over both runs in their entirety
+	const telemetry_time_grid coarse_reference = telemetry_time_grid::from_range(reference_start, reference_end, settings.coarse_interval);
+	const telemetry_time_grid coarse_run = telemetry_time_grid::from_range(run_start, run_end, settings.coarse_interval);
+
+	const size_t coarse_lag = std::max<size_t>(1, size_t(settings.maximum_shift * double(std::min(coarse_reference.count, coarse_run.count))));
+	const combined_correlation coarse = correlate_signals(signals, coarse_reference, coarse_run, coarse_lag);
+
+	if(coarse.signal_count == 0)
+		return result;
+
+	const int64_t coarse_peak = int64_t(find_peak(coarse.values)) - int64_t(coarse_lag);
+	const double coarse_offset = (run_start - reference_start) + double(coarse_peak) * settings.coarse_interval;
+
+	// Fine pass over the overlap of the coarsely aligned runs, only a couple of coarse steps around the coarse result are searched
+	double overlap_start = std::max(reference_start, run_start - coarse_offset);
+	double overlap_end = std::min(reference_end, run_end - coarse_offset);
+
+	const double maximum_duration = double(maximum_fine_samples) * settings.fine_interval;
+
+	if(overlap_end - overlap_start > maximum_duration)
+	{
+		const double center = (overlap_start + overlap_end) * 0.5;
+
+		overlap_start = center - maximum_duration * 0.5;
+		overlap_end = center + maximum_duration * 0.5;
+	}
+
+	const size_t fine_lag = size_t(std::ceil(2.0 * settings.coarse_interval / settings.fine_interval));
+
+	if(overlap_end - overlap_start <= 2.0 * fine_lag * settings.fine_interval)
+		return result;
+
+	const telemetry_time_grid fine_reference = telemetry_time_grid::from_range(overlap_start, overlap_end, settings.fine_interval);
+
+	telemetry_time_grid fine_run = fine_reference;
+	fine_run.start += coarse_offset;
+
+	const combined_correlation fine = correlate_signals(signals, fine_reference, fine_run, fine_lag);
+
+	if(fine.signal_count == 0)
+		return result;
+
+	const size_t peak = find_peak(fine.values);
+	double refinement = 0.0;
+
+	// Parabola through the peak and its neighbours, for an offset between two grid points
+	if(peak > 0 && peak + 1 < fine.values.size())
+	{
+		const double left = fine.values[peak - 1];
+		const double center = fine.values[peak];
+		const double right = fine.values[peak + 1];
+		const double curvature = left - 2.0 * center + right;
+
+		if(curvature < 0.0)
+			refinement = std::clamp(0.5 * (left - right) / curvature, -0.5, 0.5);
+	}
+
+	const double fine_peak = double(int64_t(peak) - int64_t(fine_lag)) + refinement;
+
+	result.offset = telemetry_time::from_seconds(coarse_offset + fine_peak * settings.fine_interval);
+	result.correlation = fine.values[peak] / double(fine.signal_count);
+	result.valid = (result.correlation >= settings.minimum_correlation);
+
+	return result;
+}
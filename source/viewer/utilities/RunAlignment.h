@@ -0,0 +1,39 @@
+//
+// RunAlignment.h
+//
+
+#ifndef RUNALIGNMENT_H
+#define RUNALIGNMENT_H
+
+#include <cstddef>
+#include <vector>
+#include <telemetry/container.h>
+
+struct RunAlignmentSettings
+{
+	double coarse_interval = 0.25; // Seconds, grid of the search over the whole run
+	double fine_interval = 1.0 / 240.0; // Seconds, grid of the refinement around the coarse result. Well below a frame at 60 fps
+	double maximum_shift = 0.5; // Share of the shorter run that the runs may be shifted against each other
+	double minimum_correlation = 0.3; // Below this the runs are considered unrelated
+
+	bool operator ==(const RunAlignmentSettings &other) const = default;
+};
+
+struct RunAlignment
+{
+	telemetry_time offset; // Time in the run = time in the reference + offset
+	double correlation = 0.0; // Peak of the normalized cross-correlation, averaged over the signals
+	bool valid = false;
+};
+
+// Normalized cross-correlation of two series for every lag in [-max_lag, max_lag], result[max_lag + k] correlates a[i] with b[i + k].
+// Both series have their mean removed and the sums are divided by their total energy, so results are in [-1, 1] and lags with less overlap
+// score lower. Computed with a single forward and inverse FFT for both series. Returns an empty vector if one of them is constant
+std::vector<double> cross_correlate(const std::vector<double> &a, const std::vector<double> &b, size_t max_lag);
+
+// Lines the run up with the reference by cross-correlating their frame rate and in-sim state, which works across differing load times and
+// region lists. A coarse pass searches the whole run, a fine pass around its result resolves the offset to a fraction of a frame.
+// The containers need the timing fps and sim_apup do_world fields at full resolution, see TelemetryDocument::load_alignment_signals()
+RunAlignment align_runs(const telemetry_container &reference, const telemetry_container &run, const RunAlignmentSettings &settings = {});
+
+#endif //RUNALIGNMENT_H
@@ -0,0 +1,122 @@
+//
+// RunStatistics.cpp
+//
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <random>
+#include "RunStatistics.h"
+#include "ParallelFor.h"
+
+static constexpr std::pair<double FieldSummary::*, RunSpread RunStatistics::*> aggregated_statistics[] = {
+	{ &FieldSummary::average, &RunStatistics::average },
+	{ &FieldSummary::p1, &RunStatistics::p1 },
+	{ &FieldSummary::p5, &RunStatistics::p5 },
+	{ &FieldSummary::p95, &RunStatistics::p95 },
+	{ &FieldSummary::p99, &RunStatistics::p99 }
+};
+
+static constexpr size_t aggregated_statistic_count = std::size(aggregated_statistics);
+
+// Linear interpolation between the closest ranks of sorted values
+static double get_quantile(const std::vector<double> &sorted, double quantile)
+{
+	const double position = quantile * double(sorted.size() - 1);
+	const size_t index = std::min(size_t(position), sorted.size() - 1);
+	const size_t next = std::min(index + 1, sorted.size() - 1);
+
+	return sorted[index] + (sorted[next] - sorted[index]) * (position - double(index));
+}
+
+RunStatistics aggregate_runs(const std::vector<FieldSummary> &runs, const RunStatisticsSettings &settings)
+{
+	RunStatistics result;
+
+	std::vector<FieldSummary> valid;
+	valid.reserve(runs.size());
+
+	for(auto &run : runs)
+	{
+		if(run.sample_count > 0)
+			valid.push_back(run);
+	}
+
+	const size_t count = valid.size();
+	result.run_count = count;
+
+	if(count == 0)
+		return result;
+
+	for(auto &[value, spread] : aggregated_statistics)
+	{
+		double sum = 0.0;
+
+		for(auto &run : valid)
+			sum += run.*value;
+
+		const double mean = sum / double(count);
+		double variance = 0.0;
+
+		for(auto &run : valid)
+			variance += (run.*value - mean) * (run.*value - mean);
+
+		RunSpread &target = result.*spread;
+		target.mean = mean;
+		target.standard_deviation = (count > 1) ? std::sqrt(variance / double(count - 1)) : 0.0;
+		target.lower = mean;
+		target.upper = mean;
+	}
+
+	if(count == 1 || settings.resamples == 0)
+		return result;
+
+	// Every chunk has its own generator seeded by its index, so the result doesn't depend on how the chunks end up on the threads
+	constexpr size_t chunk_size = 256;
+
+	const size_t resamples = settings.resamples;
+	const size_t chunks = (resamples + chunk_size - 1) / chunk_size;
+
+	std::vector<double> means[aggregated_statistic_count];
+
+	for(auto &statistic : means)
+		statistic.resize(resamples);
+
+	parallel_for(chunks, [&](size_t chunk) {
+
+		std::mt19937_64 generator(settings.seed + chunk);
+		std::uniform_int_distribution<size_t> distribution(0, count - 1);
+
+		const size_t end = std::min(resamples, (chunk + 1) * chunk_size);
+
+		for(size_t i = chunk * chunk_size; i < end; ++ i)
+		{
+			double sums[aggregated_statistic_count] = {};
+
+			for(size_t j = 0; j < count; ++ j)
+			{
+				const FieldSummary &run = valid[distribution(generator)];
+
+				for(size_t k = 0; k < aggregated_statistic_count; ++ k)
+					sums[k] += run.*aggregated_statistics[k].first;
+			}
+
+			for(size_t k = 0; k < aggregated_statistic_count; ++ k)
+				means[k][i] = sums[k] / double(count);
+		}
+
+	});
+
+	const double tail = std::clamp((1.0 - settings.confidence) * 0.5, 0.0, 0.5);
+
+	for(size_t k = 0; k < aggregated_statistic_count; ++ k)
+	{
+		std::sort(means[k].begin(), means[k].end());
+
+		RunSpread &target = result.*aggregated_statistics[k].second;
+		target.lower = get_quantile(means[k], tail);
+		target.upper = get_quantile(means[k], 1.0 - tail);
+	}
+
+	return result;
+}
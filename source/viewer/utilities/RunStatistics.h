@@ -0,0 +1,46 @@
+//
+// RunStatistics.h
+//
+
+#ifndef RUNSTATISTICS_H
+#define RUNSTATISTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SummaryCache.h"
+
+struct RunStatisticsSettings
+{
+	uint32_t resamples = 4096; // Bootstrap samples, each draws as many runs as there are with replacement
+	double confidence = 0.95;
+	uint64_t seed = 0x9e3779b97f4a7c15; // Fixed, so the same runs always get the same interval
+
+	bool operator ==(const RunStatisticsSettings &other) const = default;
+};
+
+// One statistic over several runs of the same test
+struct RunSpread
+{
+	double mean = 0.0;
+	double standard_deviation = 0.0; // Sample standard deviation across the runs, 0 for a single run
+	double lower = 0.0; // Bootstrap confidence interval of the mean
+	double upper = 0.0;
+};
+
+struct RunStatistics
+{
+	size_t run_count = 0;
+
+	RunSpread average;
+	RunSpread p1;
+	RunSpread p5;
+	RunSpread p95;
+	RunSpread p99;
+};
+
+// Combines the summaries of one field from several runs. The confidence intervals come from a percentile bootstrap of the mean, all
+// statistics are resampled with the same draws so they stay consistent with each other. The resamples are spread over all cores
+RunStatistics aggregate_runs(const std::vector<FieldSummary> &runs, const RunStatisticsSettings &settings = {});
+
+#endif //RUNSTATISTICS_H
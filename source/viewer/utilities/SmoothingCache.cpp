@@ -0,0 +1,196 @@
+//
+// SmoothingCache.cpp
+//
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include "SmoothingCache.h"
+
+// Trailing average over the last window samples, the first few samples average over everything seen so far
+static std::vector<double> smooth_moving_average(const std::vector<double> &values, uint32_t window)
+{
+	const size_t count = values.size();
+
+	std::vector<double> prefix(count + 1);
+	std::vector<double> result(count);
+
+	prefix[0] = 0.0;
+
+	for(size_t i = 0; i < count; ++ i)
+		prefix[i + 1] = prefix[i] + values[i];
+
+	const size_t head = std::min<size_t>(window, count);
+
+	for(size_t i = 0; i < head; ++ i)
+		result[i] = prefix[i + 1] / double(i + 1);
+
+	const double scale = 1.0 / window;
+
+	for(size_t i = head; i < count; ++ i)
+		result[i] = (prefix[i + 1] - prefix[i + 1 - window]) * scale;
+
+	return result;
+}
+
+static std::vector<double> smooth_exponential_moving_average(const std::vector<double> &values, double alpha)
+{
+	std::vector<double> result(values.size());
+
+	if(values.empty())
+		return result;
+
+	double average = values[0];
+
+	for(size_t i = 0; i < values.size(); ++ i)
+	{
+		average += alpha * (values[i] - average);
+		result[i] = average;
+	}
+
+	return result;
+}
+
+// Trailing median, the window is kept sorted so each step is a binary search plus a small move
+static std::vector<double> smooth_median(const std::vector<double> &values, uint32_t window)
+{
+	std::vector<double> result(values.size());
+	std::vector<double> sorted;
+
+	sorted.reserve(window + 1);
+
+	for(size_t i = 0; i < values.size(); ++ i)
+	{
+		sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), values[i]), values[i]);
+
+		if(sorted.size() > window)
+			sorted.erase(std::lower_bound(sorted.begin(), sorted.end(), values[i - window]));
+
+		const size_t middle = sorted.size() / 2;
+
+		if(sorted.size() % 2)
+			result[i] = sorted[middle];
+		else
+			result[i] = (sorted[middle - 1] + sorted[middle]) * 0.5;
+	}
+
+	return result;
+}
+
+
+
+SmoothingCache::field_entry &SmoothingCache::get_entry(const telemetry_field *field, std::unique_lock<std::mutex> &entry_lock)
+{
+	const bool is_duration = (field->get_unit() == telemetry_unit::duration);
+
+	// Rejected before anything is locked or extracted, vec2 and string fields only have a single value if they are durations
+	if(!is_duration && !is_telemetry_type_convertible<double>(field->get_type()))
+		throw std::invalid_argument("Unsupported type conversion");
+
+	field_entry *entry;
+
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		auto &result = m_fields[field];
+
+		if(!result)
+			result = std::make_unique<field_entry>();
+
+		entry = result.get();
+	}
+
+	entry_lock = std::unique_lock<std::mutex>(entry->lock);
+
+	if(!entry->has_raw)
+	{
+		// Whatever a failed extraction left behind would be appended to by the next attempt
+		entry->raw = SmoothingSeries();
+
+		entry->raw.timestamps.reserve(field->get_sample_count());
+		entry->raw.values.reserve(field->get_sample_count());
+
+		const telemetry_time start(std::numeric_limits<int64_t>::min());
+		const telemetry_time end(std::numeric_limits<int64_t>::max());
+
+		// The type is resolved once for the whole field, the loops below don't switch on it per sample
+		visit_telemetry_type(field->get_type(), [&](auto tag) {
+
+			constexpr telemetry_type Type = decltype(tag)::value;
+
+			field->for_each_data_point_in_range(start, end, [&](const telemetry_data_point &data) {
+
+				entry->raw.timestamps.push_back(data.timestamp.to_seconds());
+
+				if(is_duration)
+					entry->raw.values.push_back(data.value.vec2[1] - data.value.vec2[0]);
+				else if constexpr (is_telemetry_type_convertible<double>(Type))
+					entry->raw.values.push_back(data.value.get_as<double, Type>());
+				else
+					throw std::runtime_error("Unsupported type conversion");
+
+			});
+
+		});
+
+		entry->has_raw = true;
+	}
+
+	return *entry;
+}
+
+const SmoothingSeries &SmoothingCache::get_raw(const telemetry_field *field)
+{
+	std::unique_lock<std::mutex> lock;
+	field_entry &entry = get_entry(field, lock);
+
+	return entry.raw;
+}
+
+const std::vector<double> &SmoothingCache::get_smoothed(const telemetry_field *field, const SmoothingSettings &settings)
+{
+	std::unique_lock<std::mutex> lock;
+	field_entry &entry = get_entry(field, lock);
+
+	// Only the parameters the kernel actually uses are part of the key
+	const bool is_exponential = (settings.kernel == SmoothingSettings::Kernel::ExponentialMovingAverage);
+
+	const uint32_t window = is_exponential ? 0 : std::max<uint32_t>(settings.window, 1);
+	const double alpha = is_exponential ? settings.alpha : 0.0;
+
+	const smoothing_key key = std::make_tuple(settings.kernel, window, alpha);
+
+	auto iterator = entry.smoothed.find(key);
+
+	if(iterator != entry.smoothed.end())
+		return iterator->second;
+
+	std::vector<double> result;
+
+	switch(settings.kernel)
+	{
+		case SmoothingSettings::Kernel::MovingAverage:
+			result = smooth_moving_average(entry.raw.values, window);
+			break;
+		case SmoothingSettings::Kernel::ExponentialMovingAverage:
+			result = smooth_exponential_moving_average(entry.raw.values, alpha);
+			break;
+		case SmoothingSettings::Kernel::Median:
+			result = smooth_median(entry.raw.values, window);
+			break;
+	}
+
+	return entry.smoothed.emplace(key, std::move(result)).first->second;
+}
+
+void SmoothingCache::evict(const telemetry_field *field)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_fields.erase(field);
+}
+
+void SmoothingCache::clear()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_fields.clear();
+}
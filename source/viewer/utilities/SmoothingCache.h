@@ -0,0 +1,70 @@
+//
+// SmoothingCache.h
+//
+
+#ifndef SMOOTHINGCACHE_H
+#define SMOOTHINGCACHE_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include <unordered_map>
+#include <telemetry/provider.h>
+
+struct SmoothingSettings
+{
+	enum class Kernel : uint8_t
+	{
+		MovingAverage,
+		ExponentialMovingAverage,
+		Median
+	};
+
+	Kernel kernel = Kernel::MovingAverage;
+	uint32_t window = 4; // Number of samples for the moving average and median
+	double alpha = 0.25; // Weight of each new sample for the exponential moving average
+
+	bool operator ==(const SmoothingSettings &other) const = default;
+};
+
+// The values of a field as contiguous arrays, timestamps are in seconds and duration fields are already resolved to their length
+struct SmoothingSeries
+{
+	std::vector<double> timestamps;
+	std::vector<double> values;
+};
+
+// Memoizes the raw and smoothed values of fields, so that switching smoothing on and off or between settings doesn't have to walk the
+// telemetry data points again. Fields have to be evicted when their data points change.
+// Lookups are thread safe, but a field must not be evicted while another thread is still using its values
+class SmoothingCache
+{
+public:
+	const SmoothingSeries &get_raw(const telemetry_field *field);
+	const std::vector<double> &get_smoothed(const telemetry_field *field, const SmoothingSettings &settings); // Same length as the raw values
+
+	void evict(const telemetry_field *field);
+	void clear();
+
+private:
+	using smoothing_key = std::tuple<SmoothingSettings::Kernel, uint32_t, double>;
+
+	struct field_entry
+	{
+		std::mutex lock;
+		bool has_raw = false;
+
+		SmoothingSeries raw;
+		std::map<smoothing_key, std::vector<double>> smoothed;
+	};
+
+	// Returns the entry with its raw values extracted, locked by entry_lock. Will throw std::invalid_argument() for fields without a numeric value
+	field_entry &get_entry(const telemetry_field *field, std::unique_lock<std::mutex> &entry_lock);
+
+	std::mutex m_lock;
+	std::unordered_map<const telemetry_field *, std::unique_ptr<field_entry>> m_fields;
+};
+
+#endif //SMOOTHINGCACHE_H
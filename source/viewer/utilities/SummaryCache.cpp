@@ -0,0 +1,104 @@
+//
+// SummaryCache.cpp
+//
+
+#include "SummaryCache.h"
+#include "PerformanceCalculator.h"
+
+SummaryCache::SummaryCache(size_t capacity) :
+	m_capacity(capacity)
+{}
+
+FieldSummary SummaryCache::get_summary(const telemetry_field &field, telemetry_time start, telemetry_time end)
+{
+	const summary_key key = { &field, start, end };
+
+	{
+		std::lock_guard lock(m_lock);
+
+		auto iterator = m_lookup.find(key);
+
+		if(iterator != m_lookup.end())
+		{
+			m_summaries.splice(m_summaries.begin(), m_summaries, iterator->second);
+			return iterator->second->second;
+		}
+	}
+
+	// Calculated without holding the lock, two threads asking for the same summary at once just both do the work
+	const FieldSummary summary = calculate_summary(field, start, end);
+
+	std::lock_guard lock(m_lock);
+
+	if(!m_lookup.contains(key))
+	{
+		m_summaries.emplace_front(key, summary);
+		m_lookup.emplace(key, m_summaries.begin());
+
+		if(m_summaries.size() > m_capacity)
+		{
+			m_lookup.erase(m_summaries.back().first);
+			m_summaries.pop_back();
+		}
+	}
+
+	return summary;
+}
+
+FieldSummary SummaryCache::calculate_summary(const telemetry_field &field, telemetry_time start, telemetry_time end)
+{
+	PerformanceCalculator calc(field, start, end);
+
+	FieldSummary summary;
+	summary.sample_count = calc.get_sample_count();
+
+	if(summary.sample_count == 0)
+		return summary;
+
+	const size_t count = summary.sample_count;
+
+	summary.minimum = calc.get_minimum();
+	summary.maximum = calc.get_maximum();
+	summary.average = calc.calculate_average();
+
+	summary.median = calc.get_median_value(0, count);
+	summary.lower_quartile = summary.median;
+	summary.upper_quartile = summary.median;
+
+	if(count >= 2)
+	{
+		summary.lower_quartile = calc.get_median_value(0, count / 2);
+		summary.upper_quartile = calc.get_median_value(count / 2 + (count % 2), count);
+	}
+
+	summary.p1 = calc.calculate_percentile(0.01f);
+	summary.p5 = calc.calculate_percentile(0.05f);
+	summary.p95 = calc.calculate_percentile(0.95f);
+	summary.p99 = calc.calculate_percentile(0.99f);
+
+	return summary;
+}
+
+void SummaryCache::evict(const telemetry_field *field)
+{
+	std::lock_guard lock(m_lock);
+
+	for(auto iterator = m_summaries.begin(); iterator != m_summaries.end();)
+	{
+		if(iterator->first.field == field)
+		{
+			m_lookup.erase(iterator->first);
+			iterator = m_summaries.erase(iterator);
+		}
+		else
+			++ iterator;
+	}
+}
+
+void SummaryCache::clear()
+{
+	std::lock_guard lock(m_lock);
+
+	m_summaries.clear();
+	m_lookup.clear();
+}
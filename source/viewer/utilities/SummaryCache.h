@@ -0,0 +1,66 @@
+//
+// SummaryCache.h
+//
+
+#ifndef SUMMARYCACHE_H
+#define SUMMARYCACHE_H
+
+#include <compare>
+#include <list>
+#include <map>
+#include <mutex>
+#include <telemetry/provider.h>
+
+// Statistics of a field over a time range, covering everything the box plots and the statistics bars show
+struct FieldSummary
+{
+	size_t sample_count = 0;
+
+	double minimum = 0.0;
+	double maximum = 0.0;
+	double average = 0.0;
+
+	double median = 0.0;
+	double lower_quartile = 0.0;
+	double upper_quartile = 0.0;
+
+	// Weighted by value, see PerformanceCalculator::calculate_percentile()
+	double p1 = 0.0;
+	double p5 = 0.0;
+	double p95 = 0.0;
+	double p99 = 0.0;
+};
+
+// Least recently used cache of field summaries, so that going back to a previously viewed range doesn't copy and sort the samples again.
+// Lookups are thread safe. Fields are identified by their address, so they have to be evicted before they are destroyed
+class SummaryCache
+{
+public:
+	explicit SummaryCache(size_t capacity = 1024);
+
+	FieldSummary get_summary(const telemetry_field &field, telemetry_time start, telemetry_time end);
+	static FieldSummary calculate_summary(const telemetry_field &field, telemetry_time start, telemetry_time end); // Bypasses the cache
+
+	void evict(const telemetry_field *field);
+	void clear();
+
+private:
+	struct summary_key
+	{
+		const telemetry_field *field;
+		telemetry_time start;
+		telemetry_time end;
+
+		auto operator <=>(const summary_key &other) const = default;
+	};
+
+	using summary_list = std::list<std::pair<summary_key, FieldSummary>>;
+
+	size_t m_capacity;
+
+	std::mutex m_lock;
+	summary_list m_summaries; // Most recently used first
+	std::map<summary_key, summary_list::iterator> m_lookup;
+};
+
+#endif //SUMMARYCACHE_H
@@ -0,0 +1,149 @@
+//
+// TimelineAlignment.cpp
+//
+
+#include <algorithm>
+#include <stdexcept>
+#include "TimelineAlignment.h"
+#include "ParallelFor.h"
+
+TimelineAlignment::TimelineAlignment(telemetry_time offset)
+{
+	if(offset != telemetry_time())
+		m_segments.push_back({ telemetry_time(), offset });
+}
+
+void TimelineAlignment::add_segment(telemetry_time shared_start, telemetry_time offset)
+{
+	if(!m_segments.empty() && shared_start < m_segments.back().start)
+		throw std::invalid_argument("Alignment segments have to be added in order");
+
+	m_segments.push_back({ shared_start, offset });
+}
+
+telemetry_time TimelineAlignment::get_offset(telemetry_time shared) const
+{
+	if(m_segments.empty())
+		return telemetry_time();
+
+	auto iterator = std::upper_bound(m_segments.begin(), m_segments.end(), shared, [](telemetry_time time, const segment &segment) {
+		return time < segment.start;
+	});
+
+	if(iterator != m_segments.begin())
+		-- iterator;
+
+	return iterator->offset;
+}
+
+telemetry_time TimelineAlignment::to_shared(telemetry_time local) const
+{
+	if(m_segments.empty())
+		return local;
+
+	// Segments are looked up by where they start on the local timeline instead
+	size_t index = 0;
+
+	while(index + 1 < m_segments.size() && m_segments[index + 1].start + m_segments[index + 1].offset <= local)
+		index ++;
+
+	return local - m_segments[index].offset;
+}
+
+void TimelineAlignment::to_local(const double *shared, double *local, size_t count) const
+{
+	if(m_segments.empty())
+	{
+		std::copy_n(shared, count, local);
+		return;
+	}
+
+	size_t index = 0;
+
+	for(size_t i = 0; i < count; ++ i)
+	{
+		while(index + 1 < m_segments.size() && m_segments[index + 1].start.to_seconds() <= shared[i])
+			index ++;
+		while(index > 0 && m_segments[index].start.to_seconds() > shared[i])
+			index --;
+
+		local[i] = shared[i] + m_segments[index].offset.to_seconds();
+	}
+}
+
+void TimelineAlignment::to_shared(const double *local, double *shared, size_t count) const
+{
+	if(m_segments.empty())
+	{
+		std::copy_n(local, count, shared);
+		return;
+	}
+
+	auto get_local_start = [&](size_t index) {
+		return (m_segments[index].start + m_segments[index].offset).to_seconds();
+	};
+
+	size_t index = 0;
+
+	for(size_t i = 0; i < count; ++ i)
+	{
+		while(index + 1 < m_segments.size() && get_local_start(index + 1) <= local[i])
+			index ++;
+		while(index > 0 && get_local_start(index) > local[i])
+			index --;
+
+		shared[i] = local[i] - m_segments[index].offset.to_seconds();
+	}
+}
+
+std::vector<std::vector<double>> resample_aligned(const std::vector<AlignedSource> &sources, const telemetry_time_grid &grid, telemetry_resample_mode mode)
+{
+	std::vector<std::vector<double>> columns(sources.size());
+
+	parallel_for(sources.size(), [&](size_t i) {
+
+		const AlignedSource &source = sources[i];
+
+		if(!source.field || source.field->empty() || source.field->get_type() == telemetry_type::string)
+			return;
+
+		// Grid points are split up by the segment they fall into, each run of them is a uniform grid again
+		std::vector<telemetry_time> offsets(grid.count);
+
+		for(size_t j = 0; j < grid.count; ++ j)
+			offsets[j] = source.alignment.get_offset(telemetry_time::from_seconds(grid.get_time(j)));
+
+		try
+		{
+			std::vector<double> column;
+			column.reserve(grid.count);
+
+			size_t begin = 0;
+
+			while(begin < grid.count)
+			{
+				size_t end = begin + 1;
+
+				while(end < grid.count && offsets[end] == offsets[begin])
+					end ++;
+
+				telemetry_time_grid segment_grid;
+				segment_grid.start = grid.get_time(begin) + offsets[begin].to_seconds();
+				segment_grid.interval = grid.interval;
+				segment_grid.count = end - begin;
+
+				const std::vector<double> values = resample_telemetry_field(*source.field, segment_grid, mode);
+				column.insert(column.end(), values.begin(), values.end());
+
+				begin = end;
+			}
+
+			columns[i] = std::move(column);
+		}
+		catch(...)
+		{}
+
+	});
+
+	return columns;
+}
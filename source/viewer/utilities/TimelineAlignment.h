@@ -0,0 +1,62 @@
+//
+// TimelineAlignment.h
+//
+
+#ifndef TIMELINEALIGNMENT_H
+#define TIMELINEALIGNMENT_H
+
+#include <cstddef>
+#include <vector>
+#include <telemetry/provider.h>
+#include <telemetry/resample.h>
+
+// Maps the timeline of a document onto the timeline shared by all documents of a window, local = shared + offset. The offset is piecewise
+// constant: every segment starts at a point on the shared timeline and applies up to the start of the next one. The first segment also
+// covers everything before it, so an alignment with a single segment is a plain shift
+class TimelineAlignment
+{
+public:
+	TimelineAlignment() = default; // Identity
+	explicit TimelineAlignment(telemetry_time offset);
+
+	// Segments have to be added in order of their start
+	void add_segment(telemetry_time shared_start, telemetry_time offset);
+
+	telemetry_time get_offset(telemetry_time shared) const;
+
+	telemetry_time to_local(telemetry_time shared) const { return shared + get_offset(shared); }
+	telemetry_time to_shared(telemetry_time local) const;
+
+	// Same for arrays of seconds. The segment is tracked from one value to the next instead of being searched for, so sorted input is the fast case
+	void to_local(const double *shared, double *local, size_t count) const;
+	void to_shared(const double *local, double *shared, size_t count) const;
+
+	bool is_identity() const { return m_segments.empty(); }
+	bool is_piecewise() const { return m_segments.size() > 1; }
+
+	bool operator ==(const TimelineAlignment &other) const = default;
+
+private:
+	struct segment
+	{
+		telemetry_time start; // On the shared timeline
+		telemetry_time offset;
+
+		bool operator ==(const segment &other) const = default;
+	};
+
+	std::vector<segment> m_segments;
+};
+
+struct AlignedSource
+{
+	const telemetry_field *field;
+	TimelineAlignment alignment;
+};
+
+// Resamples every source onto the same grid of the shared timeline in parallel, so that the columns can be compared index by index.
+// Every segment of an alignment is resampled as its own shifted grid, which keeps the mean mode exact across segment boundaries.
+// Sources that can't be resampled, like empty or string fields, get an empty column
+std::vector<std::vector<double>> resample_aligned(const std::vector<AlignedSource> &sources, const telemetry_time_grid &grid, telemetry_resample_mode mode);
+
+#endif //TIMELINEALIGNMENT_H
@@ -42,6 +42,7 @@ void ChartCallout::paint(QPainter *painter, const QStyleOptionGraphicsItem *opti
 	painter->setBrush(QApplication::palette().color(QPalette::Base));
 	painter->drawPath(path);
 
+	painter->drawText(m_time_rect, m_time_text);
 	painter->drawText(m_text_rect, m_text);
 }
 
@@ -53,13 +54,25 @@ void ChartCallout::set_anchor(QPointF point)
 	prepareGeometryChange();
 }
 
-void ChartCallout::set_data_points(const ChartWidget *widget, double time, const QVector<QPair<const telemetry_field *, telemetry_data_point>> &data_points)
+void ChartCallout::set_time(double time)
 {
 	const uint32_t minutes = time / 60.0;
 	const uint32_t seconds = uint32_t(time) % 60;
 	const uint32_t milliseconds = (time - uint32_t(time)) * 1000.0;
 
-	QString text = QString::asprintf("Timestamp: %02d:%02d:%03d\n", (int)minutes, (int)seconds, (int)milliseconds);
+	m_time_text = QString::asprintf("Timestamp: %02d:%02d:%03d", (int)minutes, (int)seconds, (int)milliseconds);
+
+	QFontMetrics metrics(m_font);
+
+	if(metrics.horizontalAdvance(m_time_text) > m_time_rect.width())
+		update_layout();
+	else
+		update();
+}
+
+void ChartCallout::set_data_points(const ChartWidget *widget, const QVector<QPair<const telemetry_field *, telemetry_data_point>> &data_points)
+{
+	QString text;
 
 	auto format_time = [](double value) {
 
@@ -110,8 +123,8 @@ void ChartCallout::set_data_points(const ChartWidget *widget, double time, const
 
 					default:
 					{
-						if(point.value.can_convert_to<double>())
-							text = text % QString::asprintf("%0.3f", point.value.get<double>());
+						if(auto value = point.value.try_get<double>())
+							text = text % QString::asprintf("%0.3f", *value);
 						else
 							text = text % "NAN";
 					}
@@ -121,8 +134,8 @@ void ChartCallout::set_data_points(const ChartWidget *widget, double time, const
 			}
 			case telemetry_unit::time:
 			{
-				if(point.value.can_convert_to<double>())
-					text = text % format_time(point.value.get<double>());
+				if(auto value = point.value.try_get<double>())
+					text = text % format_time(*value);
 				else
 					text = text % "NAN";
 
@@ -136,17 +149,17 @@ void ChartCallout::set_data_points(const ChartWidget *widget, double time, const
 			}
 			case telemetry_unit::fps:
 			{
-				if(point.value.can_convert_to<double>())
-					text = text % QString::asprintf("%0.2fFPS", point.value.get<double>());
+				if(auto value = point.value.try_get<double>())
+					text = text % QString::asprintf("%0.2fFPS", *value);
 				else
 					text = text % "NAN";
 				break;
 			}
 			case telemetry_unit::memory:
 			{
-				if(point.value.can_convert_to<double>())
+				if(auto bytes = point.value.try_get<double>())
 				{
-					const double value = widget->scale_memory(point.value.get<double>());
+					const double value = widget->scale_memory(*bytes);
 
 					switch(widget->get_memory_scaling())
 					{
@@ -176,14 +189,22 @@ void ChartCallout::set_data_points(const ChartWidget *widget, double time, const
 		text = text % "\n";
 	}
 
-	text = text.left(text.length() - 1);
+	m_text = text.left(text.length() - 1);
+
+	update_layout();
+}
+
+void ChartCallout::update_layout()
+{
+	prepareGeometryChange();
 
 	QFontMetrics metrics(m_font);
-	m_text_rect = metrics.boundingRect(QRect(0, 0, 150, 150), Qt::AlignLeft, text);
-	m_text_rect.translate(5, 5);
 
-	m_rect = m_text_rect.adjusted(-5, -5, 5, 5);
-	m_text = text;
+	m_time_rect = metrics.boundingRect(QRect(0, 0, 150, 150), Qt::AlignLeft, m_time_text);
+	m_time_rect.translate(5, 5);
 
-	prepareGeometryChange();
+	m_text_rect = metrics.boundingRect(QRect(0, 0, 150, 150), Qt::AlignLeft, m_text);
+	m_text_rect.translate(5, m_time_rect.bottom());
+
+	m_rect = m_time_rect.united(m_text_rect).adjusted(-5, -5, 5, 5);
 }
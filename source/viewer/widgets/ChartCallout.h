@@ -17,7 +17,10 @@ public:
 	ChartCallout(QChart *parent);
 
 	void set_anchor(QPointF point);
-	void set_data_points(const ChartWidget *widget, double time, const QVector<QPair<const telemetry_field *, telemetry_data_point>> &data_points);
+
+	// The timestamp changes with every mouse move, so it is kept apart from the data points and only re-lays out the callout if it gets wider
+	void set_time(double time);
+	void set_data_points(const ChartWidget *widget, const QVector<QPair<const telemetry_field *, telemetry_data_point>> &data_points);
 
 	QRectF boundingRect() const override;
 	void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
@@ -26,10 +29,14 @@ private:
 	QChart *m_chart = nullptr;
 	QPointF m_anchor;
 
+	void update_layout();
+
 	QFont m_font;
+	QString m_time_text;
 	QString m_text;
 	QRectF m_rect;
 	QRectF m_text_rect;
+	QRectF m_time_rect;
 };
 
 #endif //CHART_CALLOUT_H
\ No newline at end of file
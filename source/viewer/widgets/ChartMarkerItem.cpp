@@ -0,0 +1,48 @@
+//
+// ChartMarkerItem.cpp
+//
+
+#include <algorithm>
+#include <QPainter>
+#include "ChartMarkerItem.h"
+
+ChartMarkerItem::ChartMarkerItem(QChart *chart) :
+	QGraphicsItem(chart)
+{
+	// Above the grid but below the series, so that the lines stay readable
+	setZValue(3);
+}
+
+void ChartMarkerItem::set_spans(const QVector<span> &spans, const QRectF &area)
+{
+	prepareGeometryChange();
+
+	m_spans = spans;
+	m_area = area;
+
+	update();
+}
+
+QRectF ChartMarkerItem::boundingRect() const
+{
+	return m_area;
+}
+
+void ChartMarkerItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+	Q_UNUSED(option);
+	Q_UNUSED(widget);
+
+	painter->setPen(Qt::NoPen);
+
+	for(auto &span : m_spans)
+	{
+		QColor fill = span.color;
+		fill.setAlpha(48);
+
+		painter->fillRect(span.rect, fill);
+
+		// A solid strip along the top keeps spans visible that are too short to see the shading
+		painter->fillRect(QRectF(span.rect.left(), span.rect.top(), std::max(span.rect.width(), 2.0), 4.0), span.color);
+	}
+}
@@ -0,0 +1,34 @@
+//
+// ChartMarkerItem.h
+//
+
+#ifndef CHART_MARKER_ITEM_H
+#define CHART_MARKER_ITEM_H
+
+#include <QChart>
+#include <QColor>
+#include <QVector>
+
+// Shades spans of the plot area of a chart, used by ChartWidget to highlight markers on the timeline
+class ChartMarkerItem : public QGraphicsItem
+{
+public:
+	struct span
+	{
+		QRectF rect; // In chart coordinates
+		QColor color;
+	};
+
+	ChartMarkerItem(QChart *parent);
+
+	void set_spans(const QVector<span> &spans, const QRectF &area);
+
+	QRectF boundingRect() const override;
+	void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+	QVector<span> m_spans;
+	QRectF m_area;
+};
+
+#endif //CHART_MARKER_ITEM_H
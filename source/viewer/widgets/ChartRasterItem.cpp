@@ -0,0 +1,37 @@
+//
+// ChartRasterItem.cpp
+//
+
+#include <QPainter>
+#include "ChartRasterItem.h"
+
+ChartRasterItem::ChartRasterItem(QChart *chart) :
+	QGraphicsItem(chart)
+{
+	// Same layer as the series of the chart, so that the grid is drawn below and callouts above
+	setZValue(4);
+}
+
+void ChartRasterItem::set_image(const QImage &image, const QRectF &rect)
+{
+	prepareGeometryChange();
+
+	m_image = image;
+	m_rect = rect;
+
+	update();
+}
+
+QRectF ChartRasterItem::boundingRect() const
+{
+	return m_rect;
+}
+
+void ChartRasterItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+	Q_UNUSED(option);
+	Q_UNUSED(widget);
+
+	if(!m_image.isNull())
+		painter->drawImage(m_rect, m_image);
+}
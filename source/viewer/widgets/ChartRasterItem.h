@@ -0,0 +1,27 @@
+//
+// ChartRasterItem.h
+//
+
+#ifndef CHART_RASTER_ITEM_H
+#define CHART_RASTER_ITEM_H
+
+#include <QChart>
+#include <QImage>
+
+// Shows a pre-rendered image of the series over the plot area of a chart, used by the raster renderer of ChartWidget
+class ChartRasterItem : public QGraphicsItem
+{
+public:
+	ChartRasterItem(QChart *parent);
+
+	void set_image(const QImage &image, const QRectF &rect); // The rect is in chart coordinates
+
+	QRectF boundingRect() const override;
+	void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+	QImage m_image;
+	QRectF m_rect;
+};
+
+#endif //CHART_RASTER_ITEM_H
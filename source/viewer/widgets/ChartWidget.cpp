@@ -3,12 +3,17 @@
 //
 
 #include <QLegendMarker>
+#include <QTimer>
 #include <telemetry/container.h>
+#include <telemetry/resample.h>
 #include "ChartWidget.h"
 #include "ChartCallout.h"
+#include "ChartMarkerItem.h"
+#include "ChartRasterItem.h"
 #include "utilities/Color.h"
-#include "utilities/PerformanceCalculator.h"
-#include "utilities/RunningAverage.h"
+#include "utilities/ParallelFor.h"
+
+static constexpr double spectrum_sample_rate = 20.0; // Hz, covers periods down to a tenth of a second
 
 void ChartWidget::chart_data::detach() const
 {
@@ -16,6 +21,20 @@ void ChartWidget::chart_data::detach() const
 		line_series->detachAxis(axis);
 	for(auto &axis : box_series->attachedAxes())
 		box_series->detachAxis(axis);
+
+	if(histogram_series)
+	{
+		for(auto &axis : histogram_series->attachedAxes())
+			histogram_series->detachAxis(axis);
+	}
+
+	if(spectrum_series)
+	{
+		for(auto &axis : spectrum_series->attachedAxes())
+			spectrum_series->detachAxis(axis);
+		for(auto &axis : spectrum_peaks->attachedAxes())
+			spectrum_peaks->detachAxis(axis);
+	}
 }
 void ChartWidget::chart_data::hide()
 {
@@ -25,6 +44,15 @@ void ChartWidget::chart_data::hide()
 	line_series->hide();
 	box_series->hide();
 
+	if(histogram_series)
+		histogram_series->hide();
+
+	if(spectrum_series)
+	{
+		spectrum_series->hide();
+		spectrum_peaks->hide();
+	}
+
 	is_hidden = true;
 }
 void ChartWidget::chart_data::show()
@@ -35,16 +63,21 @@ void ChartWidget::chart_data::show()
 	line_series->show();
 	box_series->show();
 
+	if(histogram_series)
+		histogram_series->show();
+
+	if(spectrum_series)
+	{
+		spectrum_series->show();
+		spectrum_peaks->show();
+	}
+
 	is_hidden = false;
 }
 
-void ChartWidget::chart_data::update_box_set(int32_t start, int32_t end, double scale_factor) const
+void ChartWidget::chart_data::update_box_set(double scale_factor) const
 {
-	PerformanceCalculator calc(*field, start, end);
-
-	const size_t count = calc.get_sample_count();
-
-	if(count < 2)
+	if(summary.sample_count < 2)
 	{
 		box_set->setValue(QBoxSet::LowerExtreme, 0.0);
 		box_set->setValue(QBoxSet::UpperExtreme, 0.0);
@@ -55,11 +88,11 @@ void ChartWidget::chart_data::update_box_set(int32_t start, int32_t end, double
 		return;
 	}
 
-	box_set->setValue(QBoxSet::LowerExtreme, calc.get_minimum() * scale_factor);
-	box_set->setValue(QBoxSet::UpperExtreme, calc.get_maximum() * scale_factor);
-	box_set->setValue(QBoxSet::Median, calc.get_median_value(0, count) * scale_factor);
-	box_set->setValue(QBoxSet::LowerQuartile, calc.get_median_value(0, count / 2) * scale_factor);
-	box_set->setValue(QBoxSet::UpperQuartile, calc.get_median_value(count / 2 + (count % 2), count) * scale_factor);
+	box_set->setValue(QBoxSet::LowerExtreme, summary.minimum * scale_factor);
+	box_set->setValue(QBoxSet::UpperExtreme, summary.maximum * scale_factor);
+	box_set->setValue(QBoxSet::Median, summary.median * scale_factor);
+	box_set->setValue(QBoxSet::LowerQuartile, summary.lower_quartile * scale_factor);
+	box_set->setValue(QBoxSet::UpperQuartile, summary.upper_quartile * scale_factor);
 }
 
 
@@ -68,10 +101,13 @@ void ChartWidget::chart_data::update_box_set(int32_t start, int32_t end, double
 ChartWidget::ChartWidget(QWidget *parent) :
 	QChartView(parent),
 	m_type(Type::LineRunningAverage),
+	m_renderer(Renderer::Series),
 	m_memory_scaling(MemoryScaling::Megabytes),
 	m_start(0),
-	m_end(std::numeric_limits<int32_t>::max()),
-	m_tooltip(nullptr)
+	m_end(telemetry_time::from_seconds(std::numeric_limits<int32_t>::max())),
+	m_range_job(this, 50),
+	m_tooltip(nullptr),
+	m_raster(nullptr)
 {
 	m_timeline_axis = new QValueAxis();
 	m_timeline_axis->setTitleText("Timeline");
@@ -86,8 +122,36 @@ ChartWidget::ChartWidget(QWidget *parent) :
 	m_boxplot_chart = new QChart();
 	m_boxplot_chart->legend()->hide();
 
+	m_histogram_value_axis = new QLogValueAxis();
+	m_histogram_value_axis->setTitleText("Frame time (ms) / FPS");
+	m_histogram_value_axis->setBase(10.0);
+	m_histogram_value_axis->setMinorTickCount(-1);
+	m_histogram_value_axis->setLabelFormat("%g");
+
+	m_histogram_share_axis = new QValueAxis();
+	m_histogram_share_axis->setTitleText("Samples (%)");
+
+	m_histogram_chart = new QChart();
+	m_histogram_chart->legend()->hide();
+
+	m_spectrum_period_axis = new QLogValueAxis();
+	m_spectrum_period_axis->setTitleText("Period (s)");
+	m_spectrum_period_axis->setBase(10.0);
+	m_spectrum_period_axis->setMinorTickCount(-1);
+	m_spectrum_period_axis->setLabelFormat("%g");
+
+	m_spectrum_power_axis = new QValueAxis();
+	m_spectrum_power_axis->setTitleText("Power (%)");
+
+	m_spectrum_chart = new QChart();
+	m_spectrum_chart->legend()->hide();
+
 	m_line_chart->addAxis(m_timeline_axis, Qt::AlignBottom);
 	m_boxplot_chart->addAxis(m_category_axis, Qt::AlignBottom);
+	m_histogram_chart->addAxis(m_histogram_value_axis, Qt::AlignBottom);
+	m_histogram_chart->addAxis(m_histogram_share_axis, Qt::AlignLeft);
+	m_spectrum_chart->addAxis(m_spectrum_period_axis, Qt::AlignBottom);
+	m_spectrum_chart->addAxis(m_spectrum_power_axis, Qt::AlignLeft);
 
 	switch(m_type)
 	{
@@ -98,10 +162,26 @@ ChartWidget::ChartWidget(QWidget *parent) :
 		case Type::Boxplot:
 			setChart(m_boxplot_chart);
 			break;
+		case Type::Histogram:
+			setChart(m_histogram_chart);
+			break;
+		case Type::Spectrum:
+			setChart(m_spectrum_chart);
+			break;
 	}
 
 	m_tooltip = new ChartCallout(m_line_chart);
 
+	m_raster = new ChartRasterItem(m_line_chart);
+	m_raster->hide();
+
+	m_marker_item = new ChartMarkerItem(m_line_chart);
+
+	connect(m_line_chart, &QChart::plotAreaChanged, this, [this](const QRectF &) {
+		update_raster();
+		update_markers();
+	});
+
 	m_crosshairX = new QGraphicsLineItem(m_line_chart);
 	m_crosshairY = new QGraphicsLineItem(m_line_chart);
 
@@ -123,40 +203,71 @@ ChartWidget::ChartWidget(QWidget *parent) :
 }
 ChartWidget::~ChartWidget()
 {
+	// Tile jobs call back into the widget when done
+	m_raster_pool.clear();
+	m_raster_pool.waitForDone();
+
 	for(auto &axis : m_axes)
 		delete axis;
 }
 
 
-void ChartWidget::mouseMoveEvent(QMouseEvent *event)
+bool ChartWidget::hover_cursor::covers(telemetry_time time) const
 {
-	if(m_type == Type::Boxplot)
-	{
-		m_crosshairX->hide();
-		m_crosshairY->hide();
+	// Mirrors the tie breaking of telemetry_field::get_index_closest_to_time()
+	if(previous && (data_point.timestamp - time) > (time - *previous))
+		return false;
+	if(next && (*next - time) <= (time - data_point.timestamp))
+		return false;
 
-		m_tooltip->hide();
-	}
-	else
+	return true;
+}
+
+bool ChartWidget::hover_cursor::move_to(const telemetry_field &field, telemetry_time time)
+{
+	if(!loaded)
 	{
-		const QRectF area = chart()->plotArea();
-		const QPointF point = mapToScene(event->position().toPoint());
+		count = field.get_data_point_count();
 
-		if(!area.contains(point))
+		if(count > 0)
 		{
-			m_crosshairX->hide();
-			m_crosshairY->hide();
-
-			m_tooltip->hide();
+			first = field.get_data_point(0).timestamp;
+			last = field.get_data_point(count - 1).timestamp;
 		}
-		else
-		{
-			update_tooltip(point);
-			update_crosshair(point, area);
 
-			m_crosshairX->show();
-			m_crosshairY->show();
-		}
+		loaded = true;
+	}
+
+	if(count == 0 || time < first || time > last)
+		return false;
+
+	if(snapped && covers(time))
+		return true;
+
+	const size_t index = field.get_index_closest_to_time(time);
+
+	data_point = field.get_data_point(index);
+	previous = (index > 0) ? std::optional(field.get_data_point(index - 1).timestamp) : std::nullopt;
+	next = (index + 1 < count) ? std::optional(field.get_data_point(index + 1).timestamp) : std::nullopt;
+	snapped = true;
+
+	return true;
+}
+
+
+void ChartWidget::mouseMoveEvent(QMouseEvent *event)
+{
+	m_hover_position = mapToScene(event->position().toPoint());
+	m_hovering = true;
+
+	if(!m_hover_update_queued)
+	{
+		m_hover_update_queued = true;
+
+		QTimer::singleShot(16, this, [this]() {
+			m_hover_update_queued = false;
+			update_hover();
+		});
 	}
 
 	QChartView::mouseMoveEvent(event);
@@ -164,6 +275,8 @@ void ChartWidget::mouseMoveEvent(QMouseEvent *event)
 
 void ChartWidget::leaveEvent(QEvent *event)
 {
+	m_hovering = false;
+
 	m_crosshairX->hide();
 	m_crosshairY->hide();
 	m_tooltip->hide();
@@ -171,54 +284,81 @@ void ChartWidget::leaveEvent(QEvent *event)
 	QChartView::leaveEvent(event);
 }
 
+void ChartWidget::update_hover()
+{
+	const QRectF area = chart()->plotArea();
+
+	if(!m_hovering || !is_timeline_type() || !area.contains(m_hover_position))
+	{
+		m_crosshairX->hide();
+		m_crosshairY->hide();
+
+		m_tooltip->hide();
+		return;
+	}
+
+	update_tooltip(m_hover_position);
+	update_crosshair(m_hover_position, area);
+
+	m_crosshairX->show();
+	m_crosshairY->show();
+}
+
 void ChartWidget::update_crosshair(const QPointF &point, const QRectF &plot_area) const
 {
 	m_crosshairX->setLine(plot_area.left(), (int32_t)point.y(), plot_area.right(), (int32_t)point.y());
 	m_crosshairY->setLine((int32_t)point.x(), plot_area.top(), (int32_t)point.x(), plot_area.bottom());
 }
 
-void ChartWidget::update_tooltip(const QPointF &point) const
+void ChartWidget::update_tooltip(const QPointF &point)
 {
 	const QPointF chart_point = chart()->mapToValue(point);
 
 	QVector<QPair<const telemetry_field *, telemetry_data_point>> data_points;
+	data_points.reserve(m_data.size());
 
 	for(auto &data : m_data)
 	{
 		if(data.is_hidden)
 			continue;
 
-		const auto &points = data.field->get_data_points();
+		const telemetry_time time = data.alignment.to_local(telemetry_time::from_seconds(chart_point.x()));
 
-		if(points.empty())
-			continue;
-
-		if(chart_point.x() >= points.front().timestamp && chart_point.x() <= points.back().timestamp)
+		try
 		{
-			try
-			{
-				telemetry_data_point data_point = data.field->get_data_point_closest_to_time(chart_point.x() + data.time_offset);
-				data_points.append(qMakePair(data.field, data_point));
-			}
-			catch(...)
-			{}
+			if(data.cursor.move_to(*data.field, time))
+				data_points.append(qMakePair(data.field, data.cursor.data_point));
 		}
+		catch(...)
+		{}
 	}
 
 	if(data_points.empty())
 	{
+		m_tooltip_points.clear();
 		m_tooltip->hide();
 		return;
 	}
 
-	m_tooltip->set_data_points(this, chart_point.x(), data_points);
+	auto is_same_point = [](const auto &lhs, const auto &rhs) {
+		return (lhs.first == rhs.first && lhs.second.timestamp == rhs.second.timestamp);
+	};
+
+	// Only the timestamp changes while the mouse stays close to the same samples, which doesn't need the values to be formatted again
+	if(!std::equal(data_points.begin(), data_points.end(), m_tooltip_points.begin(), m_tooltip_points.end(), is_same_point))
+	{
+		m_tooltip->set_data_points(this, data_points);
+		m_tooltip_points = std::move(data_points);
+	}
+
+	m_tooltip->set_time(chart_point.x());
 	m_tooltip->set_anchor(point);
 
 	m_tooltip->show();
 }
 
 
-void ChartWidget::set_range(int32_t start, int32_t end)
+void ChartWidget::set_range(telemetry_time start, telemetry_time end)
 {
 	if(m_start == start && m_end == end)
 		return;
@@ -226,22 +366,166 @@ void ChartWidget::set_range(int32_t start, int32_t end)
 	m_start = start;
 	m_end = end;
 
-	for(auto &data : m_data)
+	// The timeline moves right away, the vertical axes and box plots follow once the background job has the new extremes
+	rescale_axes();
+	schedule_range_update();
+}
+
+void ChartWidget::schedule_range_update()
+{
+	m_range_job.schedule([this]() -> BackgroundJob::compute_function {
+
+		struct range_input
+		{
+			const telemetry_field *field;
+			telemetry_time start;
+			telemetry_time end;
+			bool spectrum;
+		};
+
+		std::vector<range_input> inputs;
+
+		// The periodogram needs all samples of the range, so it is skipped unless it's actually shown
+		const bool spectrum = (m_type == Type::Spectrum);
+
+		for(auto &data : m_data)
+		{
+			if(data.axis)
+				inputs.push_back({ data.field, data.alignment.to_local(m_start), data.alignment.to_local(m_end), spectrum && data.spectrum_series });
+		}
+
+		return [this, inputs](const std::atomic<bool> &cancelled) -> BackgroundJob::apply_function {
+
+			std::vector<range_result> results(inputs.size());
+
+			// Every series is independent, so they are spread over all cores and only applied to the Qt objects once all are done
+			parallel_for(inputs.size(), [&](size_t i) {
+
+				if(cancelled)
+					return;
+
+				const range_input &input = inputs[i];
+				range_result &result = results[i];
+
+				result.field = input.field;
+
+				// Throws when the range has no samples of the field, for example past the end of an aligned run. The series keeps its previous results then
+				try
+				{
+					auto [ min_value, max_value ] = input.field->get_extreme_data_point_in_range(input.start, input.end);
+
+					result.min_value = min_value;
+					result.max_value = max_value;
+					result.summary = get_summary(*input.field, input.start, input.end);
+
+					if(input.field->has_histograms())
+						result.histogram = input.field->get_histogram_in_range(input.start, input.end);
+					if(input.spectrum)
+						result.spectrum = compute_spectrum(input.field, input.start, input.end, PeriodogramExecution::Serial); // Already one series per core
+
+					result.valid = true;
+				}
+				catch(...)
+				{}
+
+			});
+
+			if(cancelled)
+				return {};
+
+			return [this, results]() {
+				apply_range_results(results);
+			};
+
+		};
+
+	});
+}
+
+void ChartWidget::apply_range_results(const std::vector<range_result> &results)
+{
+	for(auto &result : results)
 	{
-		auto [ min_value, max_value ] = data.field->get_extreme_data_point_in_range(m_start + data.time_offset, m_end + data.time_offset);
+		if(!result.valid)
+			continue;
+
+		auto iterator = std::find_if(m_data.begin(), m_data.end(), [&](const chart_data &data) {
+			return (result.field == data.field);
+		});
+
+		if(iterator == m_data.end())
+			continue;
+
+		chart_data &data = *iterator;
 
-		data.min_value = min_value;
-		data.max_value = max_value;
+		data.min_value = result.min_value;
+		data.max_value = result.max_value;
+		data.summary = result.summary;
+		data.histogram = result.histogram;
 
-		double scale_factor = 1.0f;
+		data.update_box_set(get_scale_factor(data.field));
+		data.axis->dirty = true;
 
-		if(data.field->get_unit() == telemetry_unit::memory)
-			scale_factor = scale_memory(scale_factor);
+		if(data.histogram_series)
+			update_histogram_series(data);
 
-		data.update_box_set(m_start, m_end, scale_factor);
+		if(result.spectrum && data.spectrum_series)
+		{
+			data.spectrum = *result.spectrum;
+			update_spectrum_series(data);
+		}
 	}
 
 	rescale_axes();
+	rescale_histogram_axes();
+	rescale_spectrum_axes();
+}
+
+void ChartWidget::set_smoothing(const SmoothingSettings &settings)
+{
+	if(m_smoothing == settings)
+		return;
+
+	m_smoothing = settings;
+
+	// Other types pick up the new settings once they switch back to smoothed lines
+	if(m_type != Type::LineRunningAverage)
+		return;
+
+	std::vector<chart_data *> outdated;
+
+	for(auto &data : m_data)
+	{
+		if(data.line_series && is_line_series_outdated(data))
+			outdated.push_back(&data);
+	}
+
+	rebuild_line_series(outdated);
+	update_raster();
+}
+
+void ChartWidget::set_renderer(Renderer renderer)
+{
+	if(m_renderer == renderer)
+		return;
+
+	m_renderer = renderer;
+
+	// Boxplots and histograms don't show the line series, set_type() catches up once switching back
+	if(is_timeline_type())
+	{
+		std::vector<chart_data *> outdated;
+
+		for(auto &data : m_data)
+		{
+			if(data.line_series && is_line_series_outdated(data))
+				outdated.push_back(&data);
+		}
+
+		rebuild_line_series(outdated);
+	}
+
+	update_raster();
 }
 
 void ChartWidget::set_type(Type type)
@@ -255,20 +539,30 @@ void ChartWidget::set_type(Type type)
 	{
 		case Type::Line:
 		case Type::LineRunningAverage:
+		{
+			std::vector<chart_data *> outdated;
+
 			for(auto &data : m_data)
 			{
-				if(data.line_series)
-				{
-					data.line_series->clear();
-					fill_line_series(data.line_series, data.field, data.time_offset);
-				}
+				if(data.line_series && is_line_series_outdated(data))
+					outdated.push_back(&data);
 			}
 
+			rebuild_line_series(outdated);
+
 			setChart(m_line_chart);
 			break;
+		}
 		case Type::Boxplot:
 			setChart(m_boxplot_chart);
 			break;
+		case Type::Histogram:
+			setChart(m_histogram_chart);
+			break;
+		case Type::Spectrum:
+			setChart(m_spectrum_chart);
+			schedule_range_update();
+			break;
 	}
 
 	rescale_axes();
@@ -280,25 +574,26 @@ void ChartWidget::set_memory_scaling(MemoryScaling scaling)
 		return;
 
 	m_memory_scaling = scaling;
+	m_tooltip_points.clear();
 
-	QVector<QPair<const telemetry_field *, QColor>> fields;
-
+	// The cached line points are unscaled, so only the scaled copies handed to the series and the box sets need updating
 	for(auto &data : m_data)
 	{
-		if(data.axis->unit != telemetry_unit::memory)
+		if(!data.axis || data.axis->unit != telemetry_unit::memory)
 			continue;
 
-		fields.push_back(qMakePair(data.field, data.color));
-		remove_data(data.field);
+		update_line_series(data);
+		data.update_box_set(get_scale_factor(data.field));
+
+		data.axis->dirty = true;
 	}
 
-	for(auto &[ field, color ] : fields)
-		add_data(field, color, 0);
+	rescale_axes();
 }
 
 
 
-void ChartWidget::add_data(const telemetry_field *field, QColor color, int32_t time_offset)
+void ChartWidget::add_data(const telemetry_field *field, QColor color, const TimelineAlignment &alignment)
 {
 	auto iterator = std::find_if(m_data.begin(), m_data.end(), [&](const chart_data &data) {
 		return (field == data.field);
@@ -314,27 +609,29 @@ void ChartWidget::add_data(const telemetry_field *field, QColor color, int32_t t
 	if(field->get_type() == telemetry_type::string)
 		return;
 
-	auto [ min_value, max_value ] = field->get_extreme_data_point_in_range(m_start + time_offset, m_end + time_offset);
-
 	data.axis = get_chart_axis_for_field(field);
-	data.min_value = min_value;
-	data.max_value = max_value;
 	data.color = color;
-	data.time_offset = time_offset;
 
-	data.line_series = create_line_series(data.field, -time_offset);
+	// The extremes, summary, histogram and spectrum of the visible range come from the range job scheduled below, so that adding many fields
+	// doesn't scan all of them on the UI thread. Until then a zero doesn't widen the axis and the box set stays empty
+	data.min_value.value.type = telemetry_type::f64;
+	data.min_value.value.f64 = 0.0;
+	data.max_value = data.min_value;
+
+	data.alignment = alignment;
+
+	data.line_series = create_line_series(data.field);
 	data.line_series->setColor(data.color);
 
+	// Other types don't show the line series, set_type() builds the points once switching to the timeline
+	if(is_timeline_type())
+		rebuild_line_series({ &data });
+
 	data.box_set = new QBoxSet();
 	data.box_set->setLabel(QString::fromStdString(field->get_title()));
 	data.box_set->setBrush(data.color);
 
-	double scale_factor = 1.0f;
-
-	if(data.field->get_unit() == telemetry_unit::memory)
-		scale_factor = scale_memory(scale_factor);
-
-	data.update_box_set(m_start, m_end, scale_factor);
+	data.update_box_set(get_scale_factor(data.field));
 
 	data.box_series = new QBoxPlotSeries();
 	data.box_series->setName(QString::fromStdString(field->get_title()));
@@ -349,10 +646,51 @@ void ChartWidget::add_data(const telemetry_field *field, QColor color, int32_t t
 	data.box_series->attachAxis(m_category_axis);
 	data.box_series->attachAxis(data.axis->box_axis);
 
+	if(field->has_histograms())
+	{
+		data.histogram_series = create_line_series(data.field);
+		data.histogram_series->setColor(data.color);
+
+		update_histogram_series(data);
+
+		m_histogram_chart->addSeries(data.histogram_series);
+
+		data.histogram_series->attachAxis(m_histogram_value_axis);
+		data.histogram_series->attachAxis(m_histogram_share_axis);
+	}
+
+	if(has_spectrum(field))
+	{
+		data.spectrum_series = create_line_series(data.field);
+		data.spectrum_series->setColor(data.color);
+
+		data.spectrum_peaks = new QScatterSeries();
+		data.spectrum_peaks->setName(QString::fromStdString(field->get_title()));
+		data.spectrum_peaks->setColor(data.color);
+		data.spectrum_peaks->setMarkerSize(10.0);
+		data.spectrum_peaks->setPointLabelsVisible(true);
+		data.spectrum_peaks->setPointLabelsClipping(false);
+
+		update_spectrum_series(data);
+
+		m_spectrum_chart->addSeries(data.spectrum_series);
+		m_spectrum_chart->addSeries(data.spectrum_peaks);
+
+		data.spectrum_series->attachAxis(m_spectrum_period_axis);
+		data.spectrum_series->attachAxis(m_spectrum_power_axis);
+		data.spectrum_peaks->attachAxis(m_spectrum_period_axis);
+		data.spectrum_peaks->attachAxis(m_spectrum_power_axis);
+	}
+
 	if(data.is_hidden)
 		data.show();
 
+	data.axis->dirty = true;
 	rescale_axes();
+	rescale_histogram_axes();
+	rescale_spectrum_axes();
+
+	schedule_range_update();
 }
 void ChartWidget::remove_data(const telemetry_field *field)
 {
@@ -362,14 +700,38 @@ void ChartWidget::remove_data(const telemetry_field *field)
 
 	if(iterator != m_data.end())
 	{
+		// A running range update could still be reading the field
+		const bool range_pending = m_range_job.cancel();
+
 		auto &data = *iterator;
 		data.detach();
 
+		if(data.axis)
+			data.axis->dirty = true;
+
 		m_line_chart->removeSeries(data.line_series);
 		m_boxplot_chart->removeSeries(data.box_series);
 
+		if(data.histogram_series)
+			m_histogram_chart->removeSeries(data.histogram_series);
+
+		if(data.spectrum_series)
+		{
+			m_spectrum_chart->removeSeries(data.spectrum_series);
+			m_spectrum_chart->removeSeries(data.spectrum_peaks);
+		}
+
 		m_data.erase(iterator);
+		m_tooltip_points.clear();
+		m_smoothing_cache.evict(field);
+		m_raster_generation ++;
+
+		if(range_pending)
+			schedule_range_update();
+
 		rescale_axes();
+		rescale_histogram_axes();
+		rescale_spectrum_axes();
 	}
 }
 
@@ -380,7 +742,13 @@ void ChartWidget::show_data(const telemetry_field *field)
 	if(data.is_hidden)
 	{
 		data.show();
+
+		if(data.axis)
+			data.axis->dirty = true;
+
 		rescale_axes();
+		rescale_histogram_axes();
+		rescale_spectrum_axes();
 	}
 }
 void ChartWidget::hide_data(const telemetry_field *field)
@@ -390,19 +758,36 @@ void ChartWidget::hide_data(const telemetry_field *field)
 	if(!data.is_hidden)
 	{
 		data.hide();
+
+		if(data.axis)
+			data.axis->dirty = true;
+
 		rescale_axes();
+		rescale_histogram_axes();
+		rescale_spectrum_axes();
 	}
 }
 
 void ChartWidget::clear()
 {
+	m_range_job.cancel();
+
 	for(auto &data : m_data)
 		data.detach();
 
 	m_line_chart->removeAllSeries();
 	m_boxplot_chart->removeAllSeries();
+	m_histogram_chart->removeAllSeries();
+	m_spectrum_chart->removeAllSeries();
 
 	m_data.clear();
+	m_tooltip_points.clear();
+	m_smoothing_cache.clear();
+	m_raster_generation ++;
+
+	mark_axes_dirty();
+
+	update_raster();
 }
 
 
@@ -449,6 +834,7 @@ ChartWidget::chart_axis *ChartWidget::build_chart_axis(telemetry_unit unit)
 	axis->unit = unit;
 	axis->range_locked = false;
 	axis->visible = false;
+	axis->dirty = true;
 	axis->alignment = alignment;
 
 	axis->line_axis = build_axis(unit);
@@ -524,13 +910,40 @@ double ChartWidget::scale_memory(double bytes) const
 	return bytes;
 }
 
+void ChartWidget::begin_update()
+{
+	m_update_depth ++;
+}
+
+void ChartWidget::end_update()
+{
+	Q_ASSERT(m_update_depth > 0);
+
+	if(-- m_update_depth == 0)
+	{
+		rescale_axes();
+		rescale_histogram_axes();
+		rescale_spectrum_axes();
+	}
+}
+
+void ChartWidget::mark_axes_dirty()
+{
+	for(auto &axis : m_axes)
+		axis->dirty = true;
+}
+
 void ChartWidget::rescale_axes()
 {
-	uint32_t enabled_fields = 0;
+	if(m_update_depth > 0)
+		return;
 
-	// Vertical axes
+	// Vertical axes, only the ones whose fields changed are recomputed
 	for(auto &axis : m_axes)
 	{
+		if(!axis->dirty)
+			continue;
+
 		axis->minimum = std::numeric_limits<double>::max();
 		axis->maximum = 0.0;
 
@@ -542,11 +955,9 @@ void ChartWidget::rescale_axes()
 		if(data.is_hidden)
 			continue;
 
-		if(!data.axis)
+		if(!data.axis || !data.axis->dirty)
 			continue;
 
-		enabled_fields ++;
-
 		data.axis->visible = true;
 
 		data.axis->minimum = std::min(data.axis->minimum, data.min_value.value.get<double>());
@@ -563,6 +974,11 @@ void ChartWidget::rescale_axes()
 
 	for(auto &axis : m_axes)
 	{
+		if(!axis->dirty)
+			continue;
+
+		axis->dirty = false;
+
 		if(axis->line_axis->isVisible() != axis->visible)
 			axis->line_axis->setVisible(axis->visible);
 		if(axis->box_axis->isVisible() != axis->visible)
@@ -602,24 +1018,54 @@ void ChartWidget::rescale_axes()
 
 		min_value = std::min(round_down_to_nearest(min_value, 1.0), 0.0);
 
-		axis->line_axis->setRange(min_value, max_value);
-		axis->box_axis->setRange(min_value, max_value);
+		// Every call has the chart lay itself out again, even if nothing changed
+		if(axis->line_axis->min() != min_value || axis->line_axis->max() != max_value)
+			axis->line_axis->setRange(min_value, max_value);
+		if(axis->box_axis->min() != min_value || axis->box_axis->max() != max_value)
+			axis->box_axis->setRange(min_value, max_value);
 	}
 
 	// Horizontal
-	const uint32_t interval = abs(m_end - m_start);
+	const double interval = std::abs((m_end - m_start).to_seconds());
+
+	double tick_interval = 0.01;
 
 	if(interval >= 5 * 60)
-		m_timeline_axis->setTickInterval(60);
+		tick_interval = 60;
 	else if(interval >= 50)
-		m_timeline_axis->setTickInterval(10);
-	else
-		m_timeline_axis->setTickInterval(1);
+		tick_interval = 10;
+	else if(interval >= 5)
+		tick_interval = 1;
+	else if(interval >= 0.5)
+		tick_interval = 0.1;
+
+	if(m_timeline_axis->tickInterval() != tick_interval)
+		m_timeline_axis->setTickInterval(tick_interval);
+
+	if(m_timeline_axis->min() != m_start.to_seconds() || m_timeline_axis->max() != m_end.to_seconds())
+		m_timeline_axis->setRange(m_start.to_seconds(), m_end.to_seconds());
 
-	m_timeline_axis->setRange(m_start, m_end);
+	update_raster();
+	update_markers();
 }
 
-QLineSeries *ChartWidget::create_line_series(const telemetry_field *field, int32_t time_offset) const
+double ChartWidget::get_scale_factor(const telemetry_field *field) const
+{
+	if(field->get_unit() == telemetry_unit::memory)
+		return scale_memory(1.0);
+
+	return 1.0;
+}
+
+FieldSummary ChartWidget::get_summary(const telemetry_field &field, telemetry_time start, telemetry_time end) const
+{
+	if(m_summary_cache)
+		return m_summary_cache->get_summary(field, start, end);
+
+	return SummaryCache::calculate_summary(field, start, end);
+}
+
+QLineSeries *ChartWidget::create_line_series(const telemetry_field *field) const
 {
 	QLineSeries *series = new QLineSeries();
 	series->setName(QString::fromStdString(field->get_title()));
@@ -628,53 +1074,544 @@ QLineSeries *ChartWidget::create_line_series(const telemetry_field *field, int32
 	pen.setWidth(2);
 	series->setPen(pen);
 
-	fill_line_series(series, field, time_offset);
-
 	return series;
 }
 
-void ChartWidget::fill_line_series(QLineSeries *series, const telemetry_field *field, int32_t time_offset) const
+// Only touches the smoothing cache and the field, so it is safe to call from worker threads
+QList<QPointF> ChartWidget::build_line_points(const telemetry_field *field, const TimelineAlignment &alignment, const std::optional<SmoothingSettings> &smoothing) const
 {
+	const SmoothingSeries &raw = m_smoothing_cache.get_raw(field);
+	const std::vector<double> &values = smoothing ? m_smoothing_cache.get_smoothed(field, *smoothing) : raw.values;
+
+	std::vector<double> timestamps(values.size());
+	alignment.to_shared(raw.timestamps.data(), timestamps.data(), values.size());
+
+	QList<QPointF> points;
+	points.reserve(values.size());
+
 	qreal last_time = -1000.0f;
 	qreal last_value = 0.0f;
 
-	RunningAverage<4> running_avg;
-
-	for(auto &data : field->get_data_points())
+	for(size_t i = 0; i < values.size(); ++ i)
 	{
-		double timestamp = data.timestamp + time_offset;
+		const double timestamp = timestamps[i];
 
 		// If there is more than a second of time between data changes, repeat the last point again but at the current time
 		// this will prevent the graph interpolating between the last and new value, when the telemetry system assumes values are sticky until they change
 		if(timestamp - last_time >= 1.0)
-			series->append(timestamp, last_value);
+			points.emplace_back(timestamp, last_value);
+
+		points.emplace_back(timestamp, values[i]);
+
+		last_time = timestamp;
+		last_value = values[i];
+	}
+
+	return points;
+}
+
+// Outlines every bin as the share of samples that fell into it. Frame times are shown in milliseconds like in the statistics view
+void ChartWidget::update_histogram_series(const chart_data &data) const
+{
+	const telemetry_histogram &histogram = data.histogram;
+	const double scale = (data.field->get_unit() == telemetry_unit::time) ? 1000.0 : 1.0;
 
-		qreal value;
+	QList<QPointF> points;
+	points.reserve(histogram.get_bins().size() * 4);
+
+	for(auto &bin : histogram.get_bins())
+	{
+		// Zero and below can't be shown on the log axis
+		if(bin.index == 0)
+			continue;
+
+		const double lower = telemetry_histogram::get_bin_lower_bound(bin.index) * scale;
+		const double upper = telemetry_histogram::get_bin_upper_bound(bin.index) * scale;
+		const double share = bin.count * 100.0 / histogram.get_count();
+
+		points.emplace_back(lower, 0.0);
+		points.emplace_back(lower, share);
+		points.emplace_back(upper, share);
+		points.emplace_back(upper, 0.0);
+	}
+
+	data.histogram_series->replace(points);
+}
+
+void ChartWidget::rescale_histogram_axes()
+{
+	if(m_update_depth > 0)
+		return;
+
+	double min_value = std::numeric_limits<double>::max();
+	double max_value = 0.0;
+	double max_share = 0.0;
+
+	for(auto &data : m_data)
+	{
+		if(data.is_hidden || !data.histogram_series)
+			continue;
 
-		switch(field->get_unit())
+		for(auto &point : data.histogram_series->points())
 		{
-			case telemetry_unit::duration:
-			{
-				value = data.value.vec2[1] - data.value.vec2[0];
-				break;
-			}
+			min_value = std::min(min_value, point.x());
+			max_value = std::max(max_value, point.x());
+			max_share = std::max(max_share, point.y());
+		}
+	}
 
-			case telemetry_unit::memory:
-				value = scale_memory(data.value.get<double>());
-				break;
+	if(max_value <= 0.0)
+	{
+		min_value = 1.0;
+		max_value = 100.0;
+	}
 
-			default:
-				value = data.value.get<double>();
-				break;
+	// Whole decades, so that the log axis labels line up
+	min_value = std::pow(10.0, std::floor(std::log10(min_value)));
+	max_value = std::pow(10.0, std::ceil(std::log10(max_value)));
+	max_share = std::max(std::ceil(max_share / 5.0) * 5.0, 5.0);
+
+	if(m_histogram_value_axis->min() != min_value || m_histogram_value_axis->max() != max_value)
+		m_histogram_value_axis->setRange(min_value, max_value);
+	if(m_histogram_share_axis->min() != 0.0 || m_histogram_share_axis->max() != max_share)
+		m_histogram_share_axis->setRange(0.0, max_share);
+}
+
+// Only touches the smoothing cache, so it is safe to call from worker threads. The frame times are averaged into a uniform grid first, which
+// is what the transform needs and also keeps every spike in the range no matter how many frames fall into a cell
+Periodogram ChartWidget::compute_spectrum(const telemetry_field *field, telemetry_time start, telemetry_time end, PeriodogramExecution execution) const
+{
+	const SmoothingSeries &raw = m_smoothing_cache.get_raw(field);
+
+	const double start_seconds = start.to_seconds();
+	const double end_seconds = end.to_seconds();
+
+	const auto first = std::lower_bound(raw.timestamps.begin(), raw.timestamps.end(), start_seconds);
+	const auto last = std::upper_bound(first, raw.timestamps.end(), end_seconds);
+
+	const size_t offset = first - raw.timestamps.begin();
+	const size_t count = last - first;
+
+	if(count < 2 || end_seconds <= start_seconds)
+		return {};
+
+	const telemetry_time_grid grid = telemetry_time_grid::from_range(start_seconds, end_seconds, 1.0 / spectrum_sample_rate);
+	const std::vector<double> values = resample_telemetry_values(raw.timestamps.data() + offset, raw.values.data() + offset, count, grid, telemetry_resample_mode::mean);
+
+	return compute_periodogram(values, spectrum_sample_rate, execution);
+}
+
+// Power over the period of every bin, the dominant periods are marked and labelled
+void ChartWidget::update_spectrum_series(const chart_data &data) const
+{
+	const Periodogram &spectrum = data.spectrum;
+
+	QList<QPointF> points;
+	points.reserve(spectrum.power.size());
+
+	// Longest period first, so that the line runs from left to right
+	for(size_t i = spectrum.power.size(); i-- > 1;)
+		points.emplace_back(spectrum.get_period(i), spectrum.power[i]);
+
+	data.spectrum_series->replace(points);
+
+	QList<QPointF> peaks;
+
+	for(double period : spectrum.dominant_periods)
+	{
+		const size_t bin = size_t(std::round(spectrum.window_size / (period * spectrum.sample_rate)));
+		peaks.emplace_back(period, spectrum.power[bin]);
+	}
+
+	data.spectrum_peaks->replace(peaks);
+
+	for(qsizetype i = 0; i < peaks.size(); ++ i)
+		data.spectrum_peaks->setPointConfiguration(i, QXYSeries::PointConfiguration::LabelFormat, QString("%1 s").arg(peaks[i].x(), 0, 'f', 1));
+}
+
+void ChartWidget::rescale_spectrum_axes()
+{
+	if(m_update_depth > 0)
+		return;
+
+	double min_period = std::numeric_limits<double>::max();
+	double max_period = 0.0;
+	double max_power = 0.0;
+
+	for(auto &data : m_data)
+	{
+		if(data.is_hidden || !data.spectrum_series || data.spectrum.empty())
+			continue;
+
+		min_period = std::min(min_period, data.spectrum.get_period(data.spectrum.power.size() - 1));
+		max_period = std::max(max_period, data.spectrum.get_period(1));
+
+		for(size_t i = 1; i < data.spectrum.power.size(); ++ i)
+			max_power = std::max(max_power, data.spectrum.power[i]);
+	}
+
+	if(max_period <= 0.0)
+	{
+		min_period = 0.1;
+		max_period = 100.0;
+	}
+
+	// Whole decades, so that the log axis labels line up
+	min_period = std::pow(10.0, std::floor(std::log10(min_period)));
+	max_period = std::pow(10.0, std::ceil(std::log10(max_period)));
+	max_power = std::max(std::ceil(max_power / 5.0) * 5.0, 5.0);
+
+	if(m_spectrum_period_axis->min() != min_period || m_spectrum_period_axis->max() != max_period)
+		m_spectrum_period_axis->setRange(min_period, max_period);
+	if(m_spectrum_power_axis->min() != 0.0 || m_spectrum_power_axis->max() != max_power)
+		m_spectrum_power_axis->setRange(0.0, max_power);
+}
+
+bool ChartWidget::is_line_series_outdated(const chart_data &data) const
+{
+	if(m_renderer == Renderer::Raster)
+		return data.has_line_points;
+
+	if(!data.has_line_points)
+		return true;
+
+	if(m_type == Type::LineRunningAverage)
+		return data.smoothing != m_smoothing;
+
+	return data.smoothing.has_value();
+}
+
+void ChartWidget::rebuild_line_series(const std::vector<chart_data *> &series)
+{
+	// The raster renderer reads straight from the smoothing cache, so the points are dropped instead of built
+	if(m_renderer == Renderer::Raster)
+	{
+		for(auto *data : series)
+		{
+			data->line_points.clear();
+			data->smoothing.reset();
+			data->has_line_points = false;
+			data->line_series->clear();
 		}
 
-		if(m_type == Type::LineRunningAverage)
-			value = running_avg.update(value);
+		return;
+	}
 
-		series->append(timestamp, value);
+	std::optional<SmoothingSettings> smoothing;
 
-		last_time = timestamp;
-		last_value = value;
+	if(m_type == Type::LineRunningAverage)
+		smoothing = m_smoothing;
+
+	// Building the points is the expensive part and is spread over worker threads, the Qt objects are only touched afterwards
+	parallel_for(series.size(), [&](size_t i) {
+		series[i]->line_points = build_line_points(series[i]->field, series[i]->alignment, smoothing);
+	});
+
+	for(auto *data : series)
+	{
+		data->smoothing = smoothing;
+		data->has_line_points = true;
+
+		update_line_series(*data);
+	}
+}
+
+// Hands the points to the series in one go, appending them one by one has Qt Charts emit signals and update its bookkeeping for every point
+void ChartWidget::update_line_series(const chart_data &data) const
+{
+	const double scale_factor = get_scale_factor(data.field);
+
+	if(scale_factor == 1.0)
+	{
+		data.line_series->replace(data.line_points);
+		return;
+	}
+
+	QList<QPointF> points = data.line_points;
+
+	for(auto &point : points)
+		point.setY(point.y() * scale_factor);
+
+	data.line_series->replace(points);
+}
+
+void ChartWidget::set_markers(const QVector<Marker> &markers)
+{
+	m_markers = markers;
+	update_markers();
+}
+
+void ChartWidget::update_markers()
+{
+	const QRectF area = m_line_chart->plotArea();
+
+	const double start = m_start.to_seconds();
+	const double end = m_end.to_seconds();
+
+	QVector<ChartMarkerItem::span> spans;
+
+	if(area.isEmpty() || end <= start)
+	{
+		m_marker_item->set_spans(spans, area);
+		return;
+	}
+
+	const double pixels_per_second = area.width() / (end - start);
+
+	for(auto &marker : m_markers)
+	{
+		if(marker.end < start || marker.start > end)
+			continue;
+
+		const double left = area.left() + (std::max(marker.start, start) - start) * pixels_per_second;
+		const double right = area.left() + (std::min(marker.end, end) - start) * pixels_per_second;
+
+		spans.push_back({ QRectF(left, area.top(), std::max(right - left, 1.0), area.height()), marker.color });
+	}
+
+	m_marker_item->set_spans(spans, area);
+}
+
+void ChartWidget::update_raster()
+{
+	if(m_renderer != Renderer::Raster || !is_timeline_type())
+	{
+		m_raster->hide();
+		return;
+	}
+
+	const QRectF area = m_line_chart->plotArea();
+	const qreal pixel_ratio = devicePixelRatioF();
+	const QSize size = (area.size() * pixel_ratio).toSize();
+
+	if(size.isEmpty() || m_end <= m_start)
+	{
+		m_raster->hide();
+		return;
+	}
+
+	std::optional<SmoothingSettings> smoothing;
+
+	if(m_type == Type::LineRunningAverage)
+		smoothing = m_smoothing;
+
+	std::vector<const chart_data *> visible;
+
+	for(auto &data : m_data)
+	{
+		if(!data.is_hidden && data.axis)
+			visible.push_back(&data);
+	}
+
+	// Fill the cache for all fields at once, smoothing a full resolution field is the only part of this that isn't proportional to the image size
+	parallel_for(visible.size(), [&](size_t i) {
+		if(smoothing)
+			m_smoothing_cache.get_smoothed(visible[i]->field, *smoothing);
+		else
+			m_smoothing_cache.get_raw(visible[i]->field);
+	});
+
+	std::vector<EnvelopeLayer> layers;
+	layers.reserve(visible.size());
+
+	for(auto *data : visible)
+	{
+		const SmoothingSeries &raw = m_smoothing_cache.get_raw(data->field);
+		const std::vector<double> &values = smoothing ? m_smoothing_cache.get_smoothed(data->field, *smoothing) : raw.values;
+
+		EnvelopeLayer layer;
+		layer.timestamps = raw.timestamps.data();
+		layer.values = values.data();
+		layer.count = values.size();
+		layer.time_offset = data->alignment.get_offset(m_start).to_seconds(); // Piecewise alignments use the segment at the start of the visible range
+		layer.scale = get_scale_factor(data->field);
+		layer.minimum = data->axis->line_axis->min();
+		layer.maximum = data->axis->line_axis->max();
+		layer.color = data->color;
+		layer.line_width = 2.0 * pixel_ratio;
+
+		layers.push_back(layer);
+	}
+
+	const double start = m_start.to_seconds();
+	const double end = m_end.to_seconds();
+
+	const double seconds_per_pixel = (end - start) / size.width();
+	const double tile_duration = seconds_per_pixel * RasterTileCache::tile_width;
+
+	const uint64_t content = get_raster_content(layers);
+
+	// Tiles that haven't started binning yet won't be shown anymore
+	if(content != m_raster_content || seconds_per_pixel != m_raster_seconds_per_pixel)
+	{
+		m_raster_pool.clear();
+		m_tile_cache.clear_pending();
+	}
+
+	QImage frame(size, QImage::Format_ARGB32_Premultiplied);
+	frame.fill(Qt::transparent);
+
+	QPainter painter(&frame);
+
+	// Until all tiles are available, the previous frame moved and stretched to the new range stands in for the missing ones
+	if(!m_raster_frame.isNull())
+	{
+		const double x = (m_raster_start - start) / seconds_per_pixel;
+		const double width = (m_raster_end - m_raster_start) / seconds_per_pixel;
+
+		painter.drawImage(QRectF(x, 0.0, width, size.height()), m_raster_frame);
+	}
+
+	painter.setRenderHint(QPainter::Antialiasing);
+
+	const int64_t first_tile = int64_t(std::floor(start / tile_duration));
+	const int64_t last_tile = int64_t(std::ceil(end / tile_duration));
+
+	const QSize tile_size(RasterTileCache::tile_width, size.height());
+
+	// The tiles only hold the binned values, so they are drawn with the current vertical range of the axes here. Panning rescales the
+	// axes all the time, but only the tiles scrolling into view have to be binned again
+	for(int64_t index = first_tile; index < last_tile; ++ index)
+	{
+		const RasterTileKey key = { content, seconds_per_pixel, index };
+		const double x = (index * tile_duration - start) / seconds_per_pixel;
+
+		if(const std::vector<EnvelopeBins> *tile = m_tile_cache.find(key))
+		{
+			const QRectF rect(x, 0.0, tile_size.width(), tile_size.height());
+
+			painter.save();
+			painter.setClipRect(rect);
+
+			painter.setCompositionMode(QPainter::CompositionMode_Source);
+			painter.fillRect(rect, Qt::transparent);
+			painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+			painter.translate(x, 0.0);
+			draw_envelopes(painter, layers, *tile, tile_size, index * tile_duration, (index + 1) * tile_duration);
+
+			painter.restore();
+		}
+		else if(!m_tile_cache.is_pending(key))
+			queue_raster_tile(key, layers, index * tile_duration, tile_duration);
+	}
+
+	painter.end();
+
+	m_raster_frame = frame;
+	m_raster_start = start;
+	m_raster_end = end;
+	m_raster_content = content;
+	m_raster_seconds_per_pixel = seconds_per_pixel;
+
+	frame.setDevicePixelRatio(pixel_ratio);
+
+	m_raster->set_image(frame, area);
+	m_raster->show();
+}
+
+uint64_t ChartWidget::get_raster_content(const std::vector<EnvelopeLayer> &layers) const
+{
+	// FNV-1a over everything that changes the binned values of a tile. The cache arrays are identified by their address, the generation
+	// guards against a new array ending up at the address of an evicted one. The vertical range, color and line width are only applied
+	// when the tiles are drawn and are left out on purpose
+	uint64_t hash = 14695981039346656037ull;
+
+	auto combine = [&](const auto &value) {
+		const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+
+		for(size_t i = 0; i < sizeof(value); ++ i)
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+	};
+
+	combine(m_raster_generation);
+
+	for(auto &layer : layers)
+	{
+		combine(layer.timestamps);
+		combine(layer.values);
+		combine(layer.count);
+		combine(layer.time_offset);
+		combine(layer.scale);
+	}
+
+	return hash;
+}
+
+void ChartWidget::queue_raster_tile(const RasterTileKey &key, const std::vector<EnvelopeLayer> &layers, double start, double duration)
+{
+	struct tile_layer
+	{
+		EnvelopeLayer layer;
+		std::vector<double> timestamps;
+		std::vector<double> values;
+	};
+
+	// Fields can be removed and evicted from the smoothing cache while the tile renders, so the job gets its own copy of the samples
+	auto tile_layers = std::make_shared<std::vector<tile_layer>>();
+	tile_layers->reserve(layers.size());
+
+	for(auto &layer : layers)
+	{
+		const double *timestamps_end = layer.timestamps + layer.count;
+
+		const double *first = std::lower_bound(layer.timestamps, timestamps_end, start + layer.time_offset);
+		const double *last = std::lower_bound(first, timestamps_end, start + duration + layer.time_offset);
+
+		// Including one sample on either side connects the lines to the neighbouring tiles
+		if(first != layer.timestamps)
+			-- first;
+		if(last != timestamps_end)
+			++ last;
+
+		const size_t offset = first - layer.timestamps;
+		const size_t count = last - first;
+
+		tile_layer &tile = tile_layers->emplace_back();
+		tile.layer = layer;
+		tile.timestamps.assign(first, last);
+		tile.values.assign(layer.values + offset, layer.values + offset + count);
 	}
+
+	m_tile_cache.set_pending(key, true);
+
+	m_raster_pool.start([this, tile_layers, key, start, duration]() {
+
+		std::vector<EnvelopeLayer> layers;
+		layers.reserve(tile_layers->size());
+
+		for(auto &tile : *tile_layers)
+		{
+			EnvelopeLayer layer = tile.layer;
+			layer.timestamps = tile.timestamps.data();
+			layer.values = tile.values.data();
+			layer.count = tile.values.size();
+
+			layers.push_back(layer);
+		}
+
+		auto tile = std::make_shared<std::vector<EnvelopeBins>>(bin_envelopes(layers, RasterTileCache::tile_width, start, start + duration));
+
+		QMetaObject::invokeMethod(this, [this, key, tile]() {
+			raster_tile_rendered(key, std::move(*tile));
+		}, Qt::QueuedConnection);
+
+	});
 }
 
+void ChartWidget::raster_tile_rendered(const RasterTileKey &key, std::vector<EnvelopeBins> &&tile)
+{
+	m_tile_cache.set_pending(key, false);
+	m_tile_cache.insert(key, std::move(tile));
+
+	// Tiles arrive in bursts, so they are composed in one go once the event loop is through them
+	if(key.content != m_raster_content || key.seconds_per_pixel != m_raster_seconds_per_pixel || m_raster_update_queued)
+		return;
+
+	m_raster_update_queued = true;
+
+	QMetaObject::invokeMethod(this, [this]() {
+		m_raster_update_queued = false;
+		update_raster();
+	}, Qt::QueuedConnection);
+}
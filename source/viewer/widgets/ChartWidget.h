@@ -7,9 +7,20 @@
 
 #include <QtCharts/QtCharts>
 #include <QChartView>
+#include <QThreadPool>
+#include <optional>
 #include <telemetry/provider.h>
+#include "utilities/BackgroundJob.h"
+#include "utilities/EnvelopeRenderer.h"
+#include "utilities/Periodogram.h"
+#include "utilities/RasterTileCache.h"
+#include "utilities/SmoothingCache.h"
+#include "utilities/SummaryCache.h"
+#include "utilities/TimelineAlignment.h"
 
 class ChartCallout;
+class ChartMarkerItem;
+class ChartRasterItem;
 
 class ChartWidget : public QChartView
 {
@@ -19,7 +30,25 @@ public:
 	{
 		Line,
 		LineRunningAverage,
-		Boxplot
+		Boxplot,
+		Histogram, // Distribution of the time and fps fields in the visible range, see telemetry_field::get_histogram_in_range()
+		Spectrum // Periodogram of the frame time fields in the visible range, see compute_periodogram(). Meant for fields loaded at full resolution
+	};
+
+	// Series hands the points to Qt Charts, which gets slow beyond a few thousand points per field. Raster draws the min/max envelope of
+	// every pixel column into an image instead, and is meant for fields loaded at full resolution
+	enum class Renderer : uint8_t
+	{
+		Series,
+		Raster
+	};
+
+	// A span of the timeline to highlight, like a detected stutter. Times are in seconds on the timeline, so after the time offset of the document
+	struct Marker
+	{
+		double start;
+		double end;
+		QColor color;
 	};
 
 	enum class MemoryScaling : uint8_t
@@ -33,7 +62,7 @@ public:
 	ChartWidget(QWidget *parent = nullptr);
 	~ChartWidget() override;
 
-	void add_data(const telemetry_field *field, QColor color, int32_t time_offset);
+	void add_data(const telemetry_field *field, QColor color, const TimelineAlignment &alignment); // Maps the timeline of the field onto the chart
 	void remove_data(const telemetry_field *field);
 
 	void show_data(const telemetry_field *field);
@@ -41,18 +70,34 @@ public:
 
 	void clear();
 
+	// Defers rescaling the axes until the outermost end_update(), so adding or removing many fields only lays out the chart once
+	void begin_update();
+	void end_update();
+
 	void set_memory_scaling(MemoryScaling scaling);
 	MemoryScaling get_memory_scaling() const { return m_memory_scaling; }
 
 	double scale_memory(double bytes) const;
 
+	// Shares the summaries with the other users of the cache, which has to outlive the widget
+	void set_summary_cache(SummaryCache *cache) { m_summary_cache = cache; }
+
 	void set_type(Type type);
 	Type get_type() const { return m_type; }
 
-	void set_range(int32_t start, int32_t end);
+	void set_renderer(Renderer renderer);
+	Renderer get_renderer() const { return m_renderer; }
+
+	void set_smoothing(const SmoothingSettings &settings); // Used by Type::LineRunningAverage
+	const SmoothingSettings &get_smoothing() const { return m_smoothing; }
+
+	void set_range(telemetry_time start, telemetry_time end);
 
-	int32_t get_start() const { return m_start; }
-	int32_t get_end() const { return m_end; }
+	void set_markers(const QVector<Marker> &markers);
+	const QVector<Marker> &get_markers() const { return m_markers; }
+
+	telemetry_time get_start() const { return m_start; }
+	telemetry_time get_end() const { return m_end; }
 
 protected:
 	void mouseMoveEvent(QMouseEvent *event) override;
@@ -66,12 +111,31 @@ private:
 		QValueAxis *box_axis;
 		bool range_locked;
 		bool visible;
+		bool dirty; // Minimum and maximum need to be recomputed from the fields
 		Qt::Alignment alignment;
 
 		double minimum;
 		double maximum;
 	};
 
+	// Remembers the sample the tooltip snapped to and its neighbours. Moving the mouse within the time span that is closest to that sample
+	// needs no lookup at all, and everything else is a binary search
+	struct hover_cursor
+	{
+		bool move_to(const telemetry_field &field, telemetry_time time); // Returns false if time is outside of the field
+		bool covers(telemetry_time time) const;
+
+		bool loaded = false;
+		size_t count = 0;
+		telemetry_time first;
+		telemetry_time last;
+
+		bool snapped = false;
+		telemetry_data_point data_point;
+		std::optional<telemetry_time> previous;
+		std::optional<telemetry_time> next;
+	};
+
 	struct chart_data
 	{
 		chart_data() = default;
@@ -81,7 +145,7 @@ private:
 		void detach() const;
 		void hide();
 		void show();
-		void update_box_set(int32_t start, int32_t end, double scale_factor) const;
+		void update_box_set(double scale_factor) const;
 
 		const telemetry_field *field;
 		chart_axis *axis = nullptr;
@@ -89,17 +153,44 @@ private:
 		bool is_hidden = false;
 
 		QColor color;
-		int32_t time_offset = 0;
+		TimelineAlignment alignment;
+
+		QList<QPointF> line_points; // Unscaled, so that changing the memory scaling doesn't have to rebuild them
+		bool has_line_points = false; // The raster renderer leaves the line series empty
+		std::optional<SmoothingSettings> smoothing; // Settings the line points were built with, empty for raw points
 
 		QLineSeries *line_series = nullptr;
 		QBoxPlotSeries *box_series = nullptr;
 		QBoxSet *box_set = nullptr;
+		QLineSeries *histogram_series = nullptr; // Only for fields with histograms
+		QLineSeries *spectrum_series = nullptr; // Only for frame time fields
+		QScatterSeries *spectrum_peaks = nullptr;
 
 		telemetry_data_point min_value;
 		telemetry_data_point max_value;
+		FieldSummary summary; // Unscaled, backs the box set
+		telemetry_histogram histogram; // Of the visible range
+		Periodogram spectrum; // Of the visible range, only kept up to date while the spectrum is shown
+
+		hover_cursor cursor;
 	};
 
-	void update_tooltip(const QPointF &point) const;
+	// Results of the background job started by set_range()
+	struct range_result
+	{
+		const telemetry_field *field;
+
+		telemetry_data_point min_value;
+		telemetry_data_point max_value;
+		FieldSummary summary;
+		telemetry_histogram histogram;
+		std::optional<Periodogram> spectrum;
+
+		bool valid = false;
+	};
+
+	void update_hover();
+	void update_tooltip(const QPointF &point);
 	void update_crosshair(const QPointF &point, const QRectF &plot_area) const;
 
 	chart_axis *build_chart_axis(telemetry_unit unit);
@@ -107,27 +198,93 @@ private:
 	chart_axis *get_chart_axis_for_field(const telemetry_field *field);
 	chart_data &get_data_for_field(const telemetry_field *field);
 
-	QLineSeries *create_line_series(const telemetry_field *field, int32_t time_offset) const;
-	void fill_line_series(QLineSeries *series, const telemetry_field *field, int32_t time_offset) const;
+	double get_scale_factor(const telemetry_field *field) const;
+
+	FieldSummary get_summary(const telemetry_field &field, telemetry_time start, telemetry_time end) const; // Thread safe
+
+	void schedule_range_update();
+	void apply_range_results(const std::vector<range_result> &results);
+
+	QLineSeries *create_line_series(const telemetry_field *field) const;
+	QList<QPointF> build_line_points(const telemetry_field *field, const TimelineAlignment &alignment, const std::optional<SmoothingSettings> &smoothing) const;
+
+	bool is_line_series_outdated(const chart_data &data) const;
+	void rebuild_line_series(const std::vector<chart_data *> &series);
+	void update_line_series(const chart_data &data) const;
+
+	bool is_timeline_type() const { return (m_type == Type::Line || m_type == Type::LineRunningAverage); }
+
+	void update_histogram_series(const chart_data &data) const;
+	void rescale_histogram_axes();
 
+	static bool has_spectrum(const telemetry_field *field) { return field->get_unit() == telemetry_unit::time; }
+	Periodogram compute_spectrum(const telemetry_field *field, telemetry_time start, telemetry_time end, PeriodogramExecution execution) const; // Thread safe
+	void update_spectrum_series(const chart_data &data) const;
+	void rescale_spectrum_axes();
+
+	void update_raster();
+	void update_markers();
+
+	uint64_t get_raster_content(const std::vector<EnvelopeLayer> &layers) const;
+	void queue_raster_tile(const RasterTileKey &key, const std::vector<EnvelopeLayer> &layers, double start, double duration);
+	void raster_tile_rendered(const RasterTileKey &key, std::vector<EnvelopeBins> &&tile);
+
+	void mark_axes_dirty();
 	void rescale_axes();
 
 	Type m_type;
+	Renderer m_renderer;
+	uint32_t m_update_depth = 0;
 	MemoryScaling m_memory_scaling;
 
-	int32_t m_start;
-	int32_t m_end;
+	SmoothingSettings m_smoothing;
+	mutable SmoothingCache m_smoothing_cache;
+	SummaryCache *m_summary_cache = nullptr;
+
+	telemetry_time m_start;
+	telemetry_time m_end;
 
 	std::vector<chart_data> m_data;
 
+	BackgroundJob m_range_job;
+
 	QChart *m_line_chart;
 	QChart *m_boxplot_chart;
+	QChart *m_histogram_chart;
+	QChart *m_spectrum_chart;
 
 	QValueAxis *m_timeline_axis;
 	QBarCategoryAxis *m_category_axis;
+	QLogValueAxis *m_histogram_value_axis;
+	QValueAxis *m_histogram_share_axis;
+	QLogValueAxis *m_spectrum_period_axis;
+	QValueAxis *m_spectrum_power_axis;
 	QVector<chart_axis *> m_axes;
 
 	ChartCallout *m_tooltip;
+	QVector<QPair<const telemetry_field *, telemetry_data_point>> m_tooltip_points; // What the tooltip currently shows
+
+	// Mouse moves are coalesced into one hover update per frame
+	QPointF m_hover_position;
+	bool m_hovering = false;
+	bool m_hover_update_queued = false;
+
+	ChartRasterItem *m_raster;
+
+	QVector<Marker> m_markers;
+	ChartMarkerItem *m_marker_item;
+
+	RasterTileCache m_tile_cache;
+	QThreadPool m_raster_pool;
+	bool m_raster_update_queued = false;
+	uint64_t m_raster_generation = 0; // Bumped whenever fields are evicted from the smoothing cache
+
+	// The last composed frame, shown in place of tiles that are still being rendered
+	QImage m_raster_frame;
+	double m_raster_start = 0.0;
+	double m_raster_end = 0.0;
+	uint64_t m_raster_content = 0;
+	double m_raster_seconds_per_pixel = 0.0;
 	QGraphicsLineItem *m_crosshairX;
 	QGraphicsLineItem *m_crosshairY;
 };
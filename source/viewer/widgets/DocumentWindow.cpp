@@ -2,9 +2,12 @@
 // Created by Sidney on 13-Jun-18.
 //
 
+#include <QInputDialog>
 #include <QString>
 #include <thread>
 #include <telemetry/known_providers.h>
+#include <telemetry/expression.h>
+#include <telemetry/resample.h>
 
 #include "DocumentWindow.h"
 #include "TestRunnerDialog.h"
@@ -12,13 +15,87 @@
 
 #include "utilities/Color.h"
 #include "utilities/DataDecimator.h"
+#include "utilities/ParallelFor.h"
+#include "utilities/RunAlignment.h"
+#include "utilities/RunStatistics.h"
 #include "utilities/Settings.h"
-#include "utilities/PerformanceCalculator.h"
 
-DocumentWindow::DocumentWindow(TelemetryDocument *document)
+struct statistics_percentile
+{
+	QString name;
+	double FieldSummary::*value;
+	RunSpread RunStatistics::*spread;
+};
+
+static const std::array<statistics_percentile, 5> statistics_percentiles = {
+	statistics_percentile{ "P1", &FieldSummary::p1, &RunStatistics::p1 },
+	statistics_percentile{ "P5", &FieldSummary::p5, &RunStatistics::p5 },
+	statistics_percentile{ "Average", &FieldSummary::average, &RunStatistics::average },
+	statistics_percentile{ "P95", &FieldSummary::p95, &RunStatistics::p95 },
+	statistics_percentile{ "P99", &FieldSummary::p99, &RunStatistics::p99 }
+};
+
+// Matches the entries of m_smoothing_selector
+static SmoothingSettings get_smoothing_preset(int index)
+{
+	SmoothingSettings settings;
+
+	switch(index)
+	{
+		case 0:
+			settings.kernel = SmoothingSettings::Kernel::MovingAverage;
+			settings.window = 4;
+			break;
+		case 1:
+			settings.kernel = SmoothingSettings::Kernel::MovingAverage;
+			settings.window = 16;
+			break;
+		case 2:
+			settings.kernel = SmoothingSettings::Kernel::MovingAverage;
+			settings.window = 64;
+			break;
+		case 3:
+			settings.kernel = SmoothingSettings::Kernel::ExponentialMovingAverage;
+			settings.alpha = 0.25;
+			break;
+		case 4:
+			settings.kernel = SmoothingSettings::Kernel::ExponentialMovingAverage;
+			settings.alpha = 0.05;
+			break;
+		case 5:
+			settings.kernel = SmoothingSettings::Kernel::Median;
+			settings.window = 5;
+			break;
+		case 6:
+			settings.kernel = SmoothingSettings::Kernel::Median;
+			settings.window = 15;
+			break;
+
+		default:
+			break;
+	}
+
+	return settings;
+}
+
+DocumentWindow::DocumentWindow(TelemetryDocument *document) :
+	m_statistics_job(this, 50),
+	m_correlation_job(this, 50),
+	m_hitch_job(this, 0)
 {
 	setupUi(this);
 
+	m_chart_view->set_summary_cache(&m_summary_cache);
+
+	m_hitch_picker = new QComboBox();
+	m_hitch_picker->setSizeAdjustPolicy(QComboBox::AdjustToMinimumContentsLengthWithIcon);
+	m_hitch_picker->setMinimumContentsLength(24);
+	add_toolbar_widget(m_hitch_picker, "Stutters");
+
+	connect(m_hitch_picker, &QComboBox::activated, [this](int index) {
+		show_hitch(index);
+	});
+
 	add_toolbar_spacer();
 
 	m_installation_selector = new QComboBox();
@@ -29,14 +106,33 @@ DocumentWindow::DocumentWindow(TelemetryDocument *document)
 	connect(m_action_exit, &QAction::triggered, qApp, &QApplication::quit);
 
 	connect(m_mode_selector, &QComboBox::currentIndexChanged, [this](int index) {
-		m_chart_view->set_type((ChartWidget::Type)index);
+		set_chart_mode(m_chart_view->get_renderer(), (ChartWidget::Type)index);
+		m_smoothing_selector->setEnabled(m_chart_view->get_type() == ChartWidget::Type::LineRunningAverage);
 	});
 	connect(m_memory_scaling, &QComboBox::currentIndexChanged, [this](int index) {
 		m_chart_view->set_memory_scaling((ChartWidget::MemoryScaling)index);
 	});
+	connect(m_smoothing_selector, &QComboBox::currentIndexChanged, [this](int index) {
+		m_chart_view->set_smoothing(get_smoothing_preset(index));
+	});
+	connect(m_action_aggregate_runs, &QAction::triggered, [this](bool) {
+		update_statistics_view();
+	});
+	connect(m_correlation_metric, &QComboBox::currentIndexChanged, [this](int) {
+		update_correlation_table();
+	});
+	connect(tabWidget, &QTabWidget::currentChanged, [this](int) {
+		update_correlation_view();
+	});
+	connect(m_renderer_selector, &QComboBox::currentIndexChanged, [this](int index) {
+		set_chart_mode((ChartWidget::Renderer)index, m_chart_view->get_type());
+	});
 
 	m_mode_selector->setCurrentIndex((int)m_chart_view->get_type());
 	m_memory_scaling->setCurrentIndex((int)m_chart_view->get_memory_scaling());
+	m_smoothing_selector->setCurrentIndex(0);
+	m_smoothing_selector->setEnabled(m_chart_view->get_type() == ChartWidget::Type::LineRunningAverage);
+	m_renderer_selector->setCurrentIndex((int)m_chart_view->get_renderer());
 
 	m_splitter->setStretchFactor(0, 1);
 	m_splitter->setStretchFactor(1, 3);
@@ -84,6 +180,12 @@ DocumentWindow::DocumentWindow(TelemetryDocument *document)
 
 DocumentWindow::~DocumentWindow()
 {
+	// Background jobs read the fields of the documents
+	m_statistics_job.cancel();
+	m_correlation_job.cancel();
+	m_hitch_job.cancel();
+	m_chart_view->clear();
+
 	for(auto &document : m_loaded_documents)
 	{
 		delete document->document;
@@ -133,7 +235,7 @@ void DocumentWindow::provider_item_changed(QTreeWidgetItem *item)
 	if(was_enabled == enabled)
 		return;
 
-	set_field_enabled(lookup, enabled);
+	set_fields_enabled({ lookup }, enabled);
 }
 
 void DocumentWindow::document_selection_changed(QTreeWidgetItem *item)
@@ -156,11 +258,14 @@ void DocumentWindow::document_item_changed(QTreeWidgetItem *item)
 	document->document->set_name(item->text(0));
 
 	update_statistics_view();
+	update_hitch_views();
+
+	m_chart_view->begin_update();
 
 	for(auto &lookup : m_enabled_fields)
 	{
 		const telemetry_field *field = lookup_field(lookup, document->document);
-		if(!field)
+		if(!field || field->empty())
 			continue;
 
 		if(document->enabled)
@@ -168,6 +273,8 @@ void DocumentWindow::document_item_changed(QTreeWidgetItem *item)
 		else
 			m_chart_view->hide_data(field);
 	}
+
+	m_chart_view->end_update();
 }
 
 void DocumentWindow::document_item_context_menu(const QPoint &pos)
@@ -181,9 +288,24 @@ void DocumentWindow::document_item_context_menu(const QPoint &pos)
 
 	QMenu menu;
 	QAction *save_action = menu.addAction("Save");
+	QAction *compare_action = nullptr;
+	QAction *load_region_action = nullptr;
+	QAction *load_everything_action = nullptr;
 	QAction *close_action = nullptr;
 	QAction *close_all_action = nullptr;
 
+	const auto &regions = document->document->get_regions();
+	const int region_index = m_event_picker->currentIndex();
+
+	if(region_index >= 0 && region_index < regions.size() && regions[region_index].type != TelemetryRegion::Type::Everything)
+		load_region_action = menu.addAction("Load " + regions[region_index].name + " Only");
+	if(document->document->is_partial())
+		load_everything_action = menu.addAction("Load Everything");
+	if(document != m_loaded_documents.first())
+		compare_action = menu.addAction("Compare to " + m_loaded_documents.first()->document->get_name());
+
+	menu.addSeparator();
+
 	if(document != m_loaded_documents.first())
 		close_action = menu.addAction("Close");
 	else
@@ -196,6 +318,12 @@ void DocumentWindow::document_item_context_menu(const QPoint &pos)
 
 	if(selected == save_action)
 		save_file(document, true);
+	else if(selected == load_region_action)
+		load_region(document, regions[region_index]);
+	else if(selected == load_everything_action)
+		load_region(document, regions.front());
+	else if(selected == compare_action)
+		add_difference_fields(document);
 	else if(selected == close_action)
 	{
 		close_file(document);
@@ -230,41 +358,367 @@ const telemetry_field *DocumentWindow::lookup_field(const telemetry_field_lookup
 	return &field;
 }
 
-void DocumentWindow::set_field_enabled(const telemetry_field_lookup &lookup, bool enable)
+QTreeWidgetItem *DocumentWindow::create_field_item(QTreeWidgetItem *provider_item, const telemetry_provider &provider, const telemetry_field &field, const loaded_document *document) const
 {
-	QVector<QPair<const telemetry_field *, loaded_document *>> fields;
+	telemetry_field_lookup lookup;
+	lookup.identifier = provider.get_identifier();
+	lookup.field_id = field.get_id();
 
-	for(auto &container : m_loaded_documents)
+	QTreeWidgetItem *item = new QTreeWidgetItem(provider_item);
+	item->setCheckState(0, Qt::CheckState::Unchecked);
+	item->setData(0, Qt::UserRole, QVariant::fromValue(lookup));
+	item->setBackground(0, get_color_for_telemetry_field(&field, document));
+	item->setText(1, QString::fromStdString(field.get_title()));
+
+	switch(field.get_unit())
 	{
-		const telemetry_field *field = lookup_field(lookup, container->document);
-		if(field)
-			fields.push_back(qMakePair(field, container));
+		case telemetry_unit::value:
+			item->setToolTip(1, "Raw value");
+			break;
+		case telemetry_unit::fps:
+			item->setToolTip(1, "FPS");
+			break;
+		case telemetry_unit::time:
+			item->setToolTip(1, "Time");
+			break;
+		case telemetry_unit::memory:
+			item->setToolTip(1, "Memory");
+			break;
+		case telemetry_unit::duration:
+			item->setToolTip(1, "Duration");
+			break;
 	}
 
-	if(enable)
+	if(provider.get_identifier() == TelemetryDocument::derived_provider_identifier && field.get_id() < m_derived_fields.size())
+		item->setToolTip(1, QString::fromStdString(m_derived_fields[field.get_id()].expression.get_source()));
+
+	return item;
+}
+
+std::optional<DocumentWindow::telemetry_field_lookup> DocumentWindow::find_field(const std::string &name, TelemetryDocument *document, size_t derived_limit) const
+{
+	// Recorded fields take precedence, derived fields can only refer to the ones defined before them so that there are no cycles
+	for(auto &provider : document->get_data().get_providers())
 	{
-		for(auto &[ field, document ] : fields)
+		const bool is_derived = (provider.get_identifier() == TelemetryDocument::derived_provider_identifier);
+
+		for(auto &field : provider.get_fields())
 		{
-			QColor primary_color = get_color_for_telemetry_field(field, document);
-			m_chart_view->add_data(field, primary_color, document->start_offset);
+			if(is_derived && field.get_id() >= derived_limit)
+				continue;
 
-			if(!document->enabled)
-				m_chart_view->hide_data(field);
+			if(telemetry_expression::normalize_name(field.get_title()) == name)
+				return telemetry_field_lookup{ provider.get_identifier(), field.get_id() };
 		}
+	}
+
+	return std::nullopt;
+}
+
+bool DocumentWindow::load_field(loaded_document *document, const telemetry_field_lookup &lookup)
+{
+	if(lookup.identifier != TelemetryDocument::derived_provider_identifier)
+		return document->document->load_field(lookup.identifier, lookup.field_id);
+
+	const telemetry_field *field = lookup_field(lookup, document->document);
+	if(!field)
+		return false;
 
-		m_enabled_fields.push_back(lookup);
+	if(field->is_loaded())
+		return true;
+
+	try
+	{
+		evaluate_derived_field(document, lookup.field_id);
+		return true;
 	}
-	else
+	catch(std::exception &e)
 	{
-		for(auto &[ field, offset ] : fields)
-			m_chart_view->remove_data(field);
+		statusBar()->showMessage("Failed to evaluate " + QString::fromStdString(field->get_title()) + ". Error: " + QString(e.what()));
+	}
+
+	return false;
+}
+
+void DocumentWindow::load_fields(loaded_document *document, const QVector<telemetry_field_lookup> &lookups)
+{
+	std::vector<std::pair<std::string, uint8_t>> fields;
+
+	for(auto &lookup : lookups)
+	{
+		if(lookup.identifier != TelemetryDocument::derived_provider_identifier)
+			fields.emplace_back(lookup.identifier, lookup.field_id);
+	}
+
+	document->document->load_fields(fields);
+
+	// Derived fields go last, so the fields they reference are usually loaded already
+	for(auto &lookup : lookups)
+	{
+		if(lookup.identifier == TelemetryDocument::derived_provider_identifier)
+			load_field(document, lookup);
+	}
+}
+
+void DocumentWindow::evaluate_derived_field(loaded_document *document, uint8_t field_id)
+{
+	const telemetry_expression &expression = m_derived_fields[field_id].expression;
+
+	// Expressions that name the document of every field they use come out the same for all documents, so they are only shown with the first one
+	const bool is_absolute = std::all_of(expression.get_references().begin(), expression.get_references().end(), [](const telemetry_expression_reference &reference) {
+		return reference.document > 0;
+	});
+
+	if(is_absolute && document != m_loaded_documents.front())
+	{
+		document->document->set_derived_data_points(field_id, {});
+		return;
+	}
+
+	// Every reference with the document it was found in, fields of other documents are lined up through the shared timeline
+	std::vector<std::pair<const telemetry_field *, const loaded_document *>> inputs;
+
+	for(auto &reference : expression.get_references())
+	{
+		loaded_document *source = document;
+
+		if(reference.document > 0)
+		{
+			if(reference.document > size_t(m_loaded_documents.size()))
+				throw std::out_of_range("There is no document " + std::to_string(reference.document));
+
+			source = m_loaded_documents[reference.document - 1];
+		}
+
+		const std::optional<telemetry_field_lookup> lookup = find_field(reference.name, source->document, field_id);
+
+		if(!lookup)
+			throw std::invalid_argument("There is no field called " + reference.name);
+		if(!load_field(source, *lookup))
+			throw std::runtime_error("Failed to load " + reference.name);
+
+		const telemetry_field *field = lookup_field(*lookup, source->document);
+
+		if(field->empty())
+			throw std::invalid_argument(reference.name + " has no data");
+
+		inputs.emplace_back(field, source);
+	}
+
+	// The derived field is sampled wherever the first field it references was recorded
+	std::vector<double> shared;
+	shared.reserve(inputs.front().first->get_data_point_count());
+
+	const telemetry_time start(std::numeric_limits<int64_t>::min());
+	const telemetry_time end(std::numeric_limits<int64_t>::max());
+
+	inputs.front().first->for_each_data_point_in_range(start, end, [&](const telemetry_data_point &data) {
+		shared.push_back(data.timestamp.to_seconds());
+	});
+
+	inputs.front().second->alignment.to_shared(shared.data(), shared.data(), shared.size());
+
+	std::vector<std::vector<double>> columns(inputs.size());
+	std::vector<const double *> column_pointers(inputs.size());
+
+	parallel_for(inputs.size(), [&](size_t i) {
+
+		std::vector<double> times(shared.size());
+		inputs[i].second->alignment.to_local(shared.data(), times.data(), shared.size());
+
+		columns[i] = sample_telemetry_field(*inputs[i].first, times);
+
+	});
+
+	for(size_t i = 0; i < columns.size(); ++ i)
+		column_pointers[i] = columns[i].data();
+
+	const std::vector<double> values = expression.evaluate(column_pointers, shared.size());
+
+	std::vector<double> timestamps(shared.size());
+	document->alignment.to_local(shared.data(), timestamps.data(), shared.size());
+
+	std::vector<telemetry_data_point> data_points;
+	data_points.reserve(values.size());
+
+	for(size_t i = 0; i < values.size(); ++ i)
+	{
+		const telemetry_time timestamp = telemetry_time::from_seconds(timestamps[i]);
+
+		// Segment boundaries of piecewise alignments can map samples out of order, the field has to stay sorted
+		if(!std::isfinite(values[i]) || (!data_points.empty() && timestamp <= data_points.back().timestamp))
+			continue;
+
+		telemetry_data_point &data = data_points.emplace_back();
+		data.timestamp = timestamp;
+		data.value.type = telemetry_type::f64;
+		data.value.f64 = values[i];
+	}
+
+	document->document->set_derived_data_points(field_id, std::move(data_points));
+}
+
+void DocumentWindow::create_derived_field(const QString &title, const QString &source)
+{
+	if(title.isEmpty())
+		throw std::invalid_argument("Derived fields need a name");
+
+	derived_field_definition definition = { title, telemetry_expression(source.toStdString()), telemetry_unit::value };
+
+	// Resolve everything against the first document up front, so that typos show up here and not once per document
+	for(auto &reference : definition.expression.get_references())
+	{
+		if(reference.document > size_t(m_loaded_documents.size()))
+			throw std::out_of_range("There is no document " + std::to_string(reference.document));
+
+		TelemetryDocument *document = m_loaded_documents[reference.document > 0 ? reference.document - 1 : 0]->document;
+		const std::optional<telemetry_field_lookup> lookup = find_field(reference.name, document, m_derived_fields.size());
+
+		if(!lookup)
+			throw std::invalid_argument("There is no field called " + reference.name);
+
+		// Sums and differences keep the unit of the fields, durations are resolved to their length
+		if(&reference == &definition.expression.get_references().front() && definition.expression.is_additive())
+		{
+			const telemetry_unit unit = lookup_field(*lookup, document)->get_unit();
+			definition.unit = (unit == telemetry_unit::duration) ? telemetry_unit::time : unit;
+		}
+	}
+
+	uint8_t field_id = 0;
+
+	for(auto &document : m_loaded_documents)
+		field_id = document->document->add_derived_field(title.toStdString(), definition.unit);
+
+	m_derived_fields.push_back(std::move(definition));
+
+	const loaded_document *first = m_loaded_documents.front();
+	const telemetry_provider &provider = first->document->get_data().get_provider(TelemetryDocument::derived_provider_identifier);
+
+	QTreeWidgetItem *item = create_field_item(m_derived_provider_item, provider, provider.get_field(field_id), first);
+	m_derived_provider_item->setExpanded(true);
+
+	// Shows it right away, which is also what evaluates it
+	item->setCheckState(0, Qt::CheckState::Checked);
+}
+
+void DocumentWindow::add_difference_fields(const loaded_document *document)
+{
+	const qsizetype index = m_loaded_documents.indexOf(document) + 1;
+	const loaded_document *root = m_loaded_documents.front();
+
+	// Copied, since every new field is enabled right away
+	const QVector<telemetry_field_lookup> lookups = m_enabled_fields;
 
-		const auto iterator = std::find(m_enabled_fields.begin(), m_enabled_fields.end(), lookup);
-		Q_ASSERT(iterator != m_enabled_fields.end());
+	for(auto &lookup : lookups)
+	{
+		if(lookup.identifier == TelemetryDocument::derived_provider_identifier)
+			continue;
+
+		const telemetry_field *field = lookup_field(lookup, root->document);
+		if(!field || field->get_type() == telemetry_type::string)
+			continue;
+
+		const QString name = QString::fromStdString(telemetry_expression::normalize_name(field->get_title()));
+		const QString title = QString::fromStdString(field->get_title()) + " (" + document->document->get_name() + " - " + root->document->get_name() + ")";
+
+		try
+		{
+			create_derived_field(title, QString("%1@%2 - %1@1").arg(name).arg(index));
+		}
+		catch(std::exception &e)
+		{
+			statusBar()->showMessage("Failed to compare " + QString::fromStdString(field->get_title()) + ". Error: " + QString(e.what()));
+		}
+	}
+}
+
+void DocumentWindow::add_derived_field()
+{
+	if(m_loaded_documents.isEmpty())
+		return;
+
+	bool accepted = false;
+	const QString text = QInputDialog::getText(this, "Add Derived Field",
+		"Name = expression, eg. Frame Budget = cpu + gpu or FPS Delta = fps - fps@1.\n"
+		"Fields are referred to by their title in lower case with underscores, @N picks the Nth loaded trace.",
+		QLineEdit::Normal, "", &accepted);
+
+	if(!accepted || text.isEmpty())
+		return;
+
+	const qsizetype separator = text.indexOf('=');
+
+	try
+	{
+		if(separator < 0)
+			throw std::invalid_argument("Expected name = expression");
+
+		create_derived_field(text.left(separator).trimmed(), text.mid(separator + 1).trimmed());
+	}
+	catch(std::exception &e)
+	{
+		statusBar()->showMessage("Failed to add derived field. Error: " + QString(e.what()));
+	}
+}
+
+void DocumentWindow::set_fields_enabled(const QVector<telemetry_field_lookup> &lookups, bool enable)
+{
+	QVector<telemetry_field_lookup> changed;
+
+	for(auto &lookup : lookups)
+	{
+		const bool was_enabled = std::find(m_enabled_fields.begin(), m_enabled_fields.end(), lookup) != m_enabled_fields.end();
 
-		m_enabled_fields.erase(iterator);
+		if(was_enabled != enable && !changed.contains(lookup))
+			changed.push_back(lookup);
 	}
 
+	if(changed.isEmpty())
+		return;
+
+	// All fields of a document are loaded in one pass over its file, instead of once per field
+	if(enable)
+	{
+		for(auto &container : m_loaded_documents)
+			load_fields(container, changed);
+	}
+
+	m_chart_view->begin_update();
+
+	for(auto &lookup : changed)
+	{
+		for(auto &container : m_loaded_documents)
+		{
+			const telemetry_field *field = lookup_field(lookup, container->document);
+			if(!field || field->empty())
+				continue;
+
+			if(enable)
+			{
+				QColor primary_color = get_color_for_telemetry_field(field, container);
+				m_chart_view->add_data(field, primary_color, container->alignment);
+
+				if(!container->enabled)
+					m_chart_view->hide_data(field);
+			}
+			else
+				m_chart_view->remove_data(field);
+		}
+
+		if(enable)
+			m_enabled_fields.push_back(lookup);
+		else
+		{
+			const auto iterator = std::find(m_enabled_fields.begin(), m_enabled_fields.end(), lookup);
+			Q_ASSERT(iterator != m_enabled_fields.end());
+
+			m_enabled_fields.erase(iterator);
+		}
+	}
+
+	m_chart_view->end_update();
+
 	update_statistics_view();
 }
 
@@ -344,6 +798,7 @@ void DocumentWindow::clear()
 	m_event_picker->clear();
 
 	m_providers_view->clear();
+	m_derived_provider_item = nullptr;
 	m_overview_view->clear();
 	m_timeline_tree->clear();
 
@@ -351,6 +806,12 @@ void DocumentWindow::clear()
 
 	m_documents_tree->clear();
 
+	m_statistics_job.cancel();
+	m_correlation_job.cancel();
+	m_hitch_job.cancel();
+	m_summary_cache.clear();
+	m_alignment_reference.reset();
+
 	for(auto &container : m_loaded_documents)
 	{
 		delete container->document;
@@ -360,6 +821,7 @@ void DocumentWindow::clear()
 	m_loaded_documents.clear();
 
 	update_statistics_view();
+	update_hitch_views();
 }
 
 
@@ -422,34 +884,20 @@ void DocumentWindow::add_document_with_content(std::vector<uint8_t> &&data, cons
 
 void DocumentWindow::add_document(TelemetryDocument *document)
 {
+	if(needs_full_resolution(m_chart_view->get_renderer(), m_chart_view->get_type()))
+		document->set_full_resolution(true);
+
 	const bool is_first_document = m_loaded_documents.isEmpty();
 
+	for(auto &definition : m_derived_fields)
+		document->add_derived_field(definition.title.toStdString(), definition.unit);
+
 	loaded_document *entry = new loaded_document;
 	entry->document = document;
-	entry->start_offset = 0.0;
 
 	if(!is_first_document)
 	{
-		TelemetryDocument *root_document = m_loaded_documents.front()->document;
-		auto &root_regions = root_document->get_regions();
-		auto &regions = document->get_regions();
-
-		if(root_regions.size() != regions.size())
-			throw std::range_error("Telemetry document has different timing regions");
-
-		size_t count = regions.size();
-		for(size_t i = 0; i < count; ++ i)
-		{
-			if(root_regions[i].type != regions[i].type || root_regions[i].name != regions[i].name)
-				throw std::range_error("Telemetry document has different timing regions");
-
-			if(regions[i].type == TelemetryRegion::Type::Flying)
-			{
-				entry->start_offset = regions[i].start - root_regions[i].start;
-				break;
-			}
-		}
-
+		entry->alignment = align_document(document);
 		entry->seed = document->get_name();
 	}
 
@@ -483,11 +931,14 @@ void DocumentWindow::add_document(TelemetryDocument *document)
 
 		const auto &container = document->get_data();
 
-		m_start_edit->set_range(container.get_start_time(), container.get_end_time());
-		m_start_edit->set_value(container.get_start_time());
+		const int32_t start_time = int32_t(container.get_start_seconds());
+		const int32_t end_time = int32_t(container.get_end_seconds());
 
-		m_end_edit->set_range(container.get_start_time(), container.get_end_time());
-		m_end_edit->set_value(container.get_end_time());
+		m_start_edit->set_range(start_time, end_time);
+		m_start_edit->set_value(start_time);
+
+		m_end_edit->set_range(start_time, end_time);
+		m_end_edit->set_value(end_time);
 
 		auto &regions = document->get_regions();
 		int selected_region = 0;
@@ -495,8 +946,7 @@ void DocumentWindow::add_document(TelemetryDocument *document)
 
 		for(auto &region : regions)
 		{
-			QString title = region.name + QString(" (") + TimePickerWidget::format_time(region.start) + " - " + TimePickerWidget::format_time(region.end) + QString(")");
-			m_event_picker->addItem(title);
+			m_event_picker->addItem(get_region_title(region));
 
 			if(region.type == TelemetryRegion::Type::Flying && selected_region == 0)
 				selected_region = index;
@@ -525,42 +975,22 @@ void DocumentWindow::add_document(TelemetryDocument *document)
 					if(provider.get_identifier() == provider_timing::identifier)
 						expanded_items.push_back(provider_item);
 
+					if(provider.get_identifier() == TelemetryDocument::derived_provider_identifier)
+					{
+						m_derived_provider_item = provider_item;
+						expanded_items.push_back(provider_item);
+					}
+
 					for(auto &field: provider.get_fields())
 					{
 						const telemetry_type type = field.get_type();
 						const bool can_chart = !(type == telemetry_type::vec2 || type == telemetry_type::dvec2);
 
-						if(field.empty() || !can_chart)
+						// Fields that aren't loaded yet might still turn out to be empty once they are enabled
+						if((field.is_loaded() && field.empty()) || !can_chart)
 							continue;
 
-						telemetry_field_lookup lookup;
-						lookup.identifier = provider.get_identifier();
-						lookup.field_id = field.get_id();
-
-						QTreeWidgetItem *item = new QTreeWidgetItem(provider_item);
-						item->setCheckState(0, Qt::CheckState::Unchecked);
-						item->setData(0, Qt::UserRole, QVariant::fromValue(lookup));
-						item->setBackground(0, get_color_for_telemetry_field(&field, entry));
-						item->setText(1, QString::fromStdString(field.get_title()));
-
-						switch(field.get_unit())
-						{
-							case telemetry_unit::value:
-								item->setToolTip(1, "Raw value");
-								break;
-							case telemetry_unit::fps:
-								item->setToolTip(1, "FPS");
-								break;
-							case telemetry_unit::time:
-								item->setToolTip(1, "Time");
-								break;
-							case telemetry_unit::memory:
-								item->setToolTip(1, "Memory");
-								break;
-							case telemetry_unit::duration:
-								item->setToolTip(1, "Duration");
-								break;
-						}
+						QTreeWidgetItem *item = create_field_item(provider_item, provider, field, entry);
 
 						if(provider.get_identifier() == provider_timing::identifier)
 						{
@@ -575,8 +1005,21 @@ void DocumentWindow::add_document(TelemetryDocument *document)
 
 			for(auto &item : expanded_items)
 				item->setExpanded(true);
-			for(auto &item : enabled_items)
-				item->setCheckState(0, Qt::CheckState::Checked);
+
+			// Checking the items one by one would enable their fields one by one, they are enabled in one batch instead
+			QVector<telemetry_field_lookup> enabled_fields;
+
+			{
+				QSignalBlocker blocker(m_providers_view);
+
+				for(auto &item : enabled_items)
+				{
+					item->setCheckState(0, Qt::CheckState::Checked);
+					enabled_fields.push_back(item->data(0, Qt::UserRole).value<telemetry_field_lookup>());
+				}
+			}
+
+			set_fields_enabled(enabled_fields, true);
 		}
 
 		update_selected_document(entry);
@@ -616,18 +1059,27 @@ void DocumentWindow::add_document(TelemetryDocument *document)
 	}
 	else
 	{
+		m_chart_view->begin_update();
+
+		load_fields(entry, m_enabled_fields);
+
 		for(auto &lookup : m_enabled_fields)
 		{
 			const telemetry_field *field = lookup_field(lookup, document);
-			if(field)
+			if(field && !field->empty())
 			{
 				QColor color = get_color_for_telemetry_field(field, entry);
-				m_chart_view->add_data(field, color, entry->start_offset);
+				m_chart_view->add_data(field, color, entry->alignment);
 			}
 		}
 
+		m_chart_view->end_update();
+
 		update_statistics_view();
 	}
+
+	update_hitch_views();
+	detect_hitches();
 }
 
 
@@ -637,6 +1089,36 @@ void DocumentWindow::restore_state(QSettings &state)
 
 	restoreGeometry(state.value("geometry").toByteArray());
 
+	// Before loading the files, so they don't have to be parsed twice
+	m_renderer_selector->setCurrentIndex(state.value("renderer", m_renderer_selector->currentIndex()).toInt());
+	m_action_align_regions->setChecked(state.value("align_regions", m_action_align_regions->isChecked()).toBool());
+	m_action_aggregate_runs->setChecked(state.value("aggregate_runs", m_action_aggregate_runs->isChecked()).toBool());
+
+	m_hitch_settings.absolute_threshold = state.value("hitch_threshold", m_hitch_settings.absolute_threshold).toDouble();
+	m_hitch_settings.median_multiple = state.value("hitch_median_multiple", m_hitch_settings.median_multiple).toDouble();
+
+	// Also before loading the files, every document gets the derived fields when it's added
+	{
+		m_derived_fields.clear();
+
+		const int count = state.beginReadArray("derived_fields");
+
+		for(int i = 0; i < count; ++ i)
+		{
+			state.setArrayIndex(i);
+
+			try
+			{
+				derived_field_definition definition = { state.value("title").toString(), telemetry_expression(state.value("expression").toString().toStdString()), (telemetry_unit)state.value("unit").toInt() };
+				m_derived_fields.push_back(std::move(definition));
+			}
+			catch(...)
+			{}
+		}
+
+		state.endArray();
+	}
+
 	{
 		const int count = state.beginReadArray("files");
 		QStringList paths;
@@ -658,10 +1140,12 @@ void DocumentWindow::restore_state(QSettings &state)
 	int32_t start_value = state.value("start", m_start_edit->get_value()).toInt();
 	int32_t end_value = state.value("end", m_end_edit->get_value()).toInt();
 	int32_t index = state.value("region", m_event_picker->currentIndex()).toInt();
+	int32_t smoothing = state.value("smoothing", m_smoothing_selector->currentIndex()).toInt();
 
 	m_start_edit->set_value(start_value);
 	m_end_edit->set_value(end_value);
 	m_event_picker->setCurrentIndex(index);
+	m_smoothing_selector->setCurrentIndex(smoothing);
 }
 
 void DocumentWindow::save_state(QSettings &state) const
@@ -684,12 +1168,30 @@ void DocumentWindow::save_state(QSettings &state) const
 
 	state.endArray();
 
+	state.beginWriteArray("derived_fields");
+
+	for(size_t i = 0; i < m_derived_fields.size(); ++ i)
+	{
+		state.setArrayIndex(int(i));
+		state.setValue("title", m_derived_fields[i].title);
+		state.setValue("expression", QString::fromStdString(m_derived_fields[i].expression.get_source()));
+		state.setValue("unit", (int)m_derived_fields[i].unit);
+	}
+
+	state.endArray();
+
 	state.setValue("start", m_start_edit->get_value());
 	state.setValue("end", m_end_edit->get_value());
 	state.setValue("region", m_event_picker->currentIndex());
+	state.setValue("smoothing", m_smoothing_selector->currentIndex());
+	state.setValue("renderer", m_renderer_selector->currentIndex());
+	state.setValue("align_regions", m_action_align_regions->isChecked());
+	state.setValue("aggregate_runs", m_action_aggregate_runs->isChecked());
+	state.setValue("hitch_threshold", m_hitch_settings.absolute_threshold);
+	state.setValue("hitch_median_multiple", m_hitch_settings.median_multiple);
 }
 
- void DocumentWindow::set_time_range(int32_t start, int32_t end)
+ void DocumentWindow::set_time_range(telemetry_time start, telemetry_time end)
 {
 	m_chart_view->set_range(start, end);
 	update_statistics_view();
@@ -778,135 +1280,364 @@ void DocumentWindow::update_selected_document(const loaded_document *document)
 
 void DocumentWindow::update_statistics_view()
 {
-	QChart *chart = new QChart();
+	// Only the inputs are gathered here, the percentiles are calculated on a worker thread once the range stopped changing
+	m_statistics_job.schedule([this]() -> BackgroundJob::compute_function {
 
-	struct perf_set
-	{
-		QString name;
-		float percentile;
-	};
+		const bool aggregate = m_action_aggregate_runs->isChecked();
+		std::vector<statistics_entry> entries;
 
-	const std::array perf_series = {
-		perf_set{ "P1", 0.01f },
-		perf_set{ "P5", 0.05f },
-		perf_set{ "Average", -1.0f },
-		perf_set{ "P95", 0.95f },
-		perf_set{ "P99", 0.99f }
-	};
+		for(auto &document : m_loaded_documents)
+		{
+			if(!document->enabled)
+				continue;
 
-	auto build_bar_set = [&](const telemetry_field &field, loaded_document *document) -> QBarSet * {
+			for(auto &lookup : m_enabled_fields)
+			{
+				const telemetry_field *field = lookup_field(lookup, document->document);
+				if(!field || field->empty())
+					continue;
+
+				const telemetry_unit unit = field->get_unit();
+
+				if(unit != telemetry_unit::time && unit != telemetry_unit::fps && unit != telemetry_unit::value)
+					continue;
+
+				statistics_entry &entry = entries.emplace_back();
+				entry.field = field;
+				entry.lookup = lookup;
+				entry.title = QString::fromStdString(field->get_title());
+				entry.color = get_color_for_telemetry_field(field, document);
+				entry.unit = unit;
+				entry.start = document->alignment.to_local(m_chart_view->get_start());
+				entry.end = document->alignment.to_local(m_chart_view->get_end());
+			}
+		}
 
-		try
-		{
-			PerformanceCalculator perf(field, m_chart_view->get_start() + document->start_offset, m_chart_view->get_end() + document->start_offset);
+		return [this, entries, aggregate](const std::atomic<bool> &cancelled) mutable -> BackgroundJob::apply_function {
 
-			QBarSet *set = new QBarSet(QString::fromStdString(field.get_title()));
-			set->setColor(get_color_for_telemetry_field(&field, document));
+			parallel_for(entries.size(), [&](size_t i) {
 
-			switch(field.get_unit())
-			{
-				case telemetry_unit::time:
+				if(cancelled)
+					return;
+
+				try
 				{
-					for(auto &perf_set : perf_series)
-					{
-						if(perf_set.percentile <= 0.0f)
-							set->append(perf.calculate_average() * 1000.0);
-						else
-							set->append(perf.calculate_percentile(perf_set.percentile) * 1000.0);
-					}
-
-					break;
+					entries[i].summary = m_summary_cache.get_summary(*entries[i].field, entries[i].start, entries[i].end);
+					entries[i].valid = true;
 				}
+				catch(...)
+				{}
+
+			});
+
+			if(cancelled)
+				return {};
+
+			// Every document is one run of the same test, so the entries of a field are combined across documents.
+			// The aggregate takes the title and color of the field in the first document it's enabled in
+			std::vector<statistics_aggregate> aggregates;
 
-				case telemetry_unit::fps:
-				case telemetry_unit::value:
+			if(aggregate)
+			{
+				std::vector<std::vector<FieldSummary>> runs;
+
+				for(auto &entry : entries)
 				{
-					for(auto &perf_set : perf_series)
+					if(!entry.valid)
+						continue;
+
+					auto iterator = std::find_if(aggregates.begin(), aggregates.end(), [&](const statistics_aggregate &candidate) {
+						return candidate.lookup == entry.lookup;
+					});
+
+					if(iterator == aggregates.end())
 					{
-						if(perf_set.percentile <= 0.0f)
-							set->append(perf.calculate_average());
-						else
-							set->append(perf.calculate_percentile(perf_set.percentile));
+						statistics_aggregate &target = aggregates.emplace_back();
+						target.lookup = entry.lookup;
+						target.title = entry.title;
+						target.color = entry.color;
+						target.unit = entry.unit;
+
+						runs.emplace_back();
+						iterator = aggregates.end() - 1;
 					}
 
-					break;
+					runs[iterator - aggregates.begin()].push_back(entry.summary);
 				}
 
-				default:
-				{
-					delete set;
-					return nullptr;
-				}
+				for(size_t i = 0; i < aggregates.size(); ++ i)
+					aggregates[i].statistics = aggregate_runs(runs[i]);
 			}
 
+			return [this, entries, aggregates, aggregate]() {
+				update_statistics_chart(aggregate ? std::vector<statistics_entry>() : entries, aggregates);
+			};
+
+		};
+
+	});
+
+	// Depends on the same fields and range
+	update_correlation_view();
+}
+
+void DocumentWindow::update_correlation_view()
+{
+	// Every pair of fields costs a dot product per lag, so nothing is computed while the tab isn't shown
+	if(tabWidget->currentWidget() != m_correlation_page)
+		return;
+
+	m_correlation_job.schedule([this]() -> BackgroundJob::compute_function {
 
-			return set;
+
+		constexpr double minimum_interval = 0.05; // Seconds
+		constexpr size_t maximum_points = 8192;
+		constexpr double maximum_lag = 10.0; // Seconds
+
+		const double start = m_chart_view->get_start().to_seconds();
+		const double duration = std::max((m_chart_view->get_end() - m_chart_view->get_start()).to_seconds(), minimum_interval);
+
+		// Every field is sampled at the same points of the shared timeline
+		telemetry_time_grid grid;
+		grid.start = start;
+		grid.count = std::clamp(size_t(duration / minimum_interval), size_t(2), maximum_points);
+		grid.interval = duration / grid.count;
+
+		std::vector<AlignedSource> inputs;
+		QStringList titles;
+
+		for(auto &document : m_loaded_documents)
+		{
+			if(!document->enabled)
+				continue;
+
+			for(auto &lookup : m_enabled_fields)
+			{
+				const telemetry_field *field = lookup_field(lookup, document->document);
+				if(!field || field->empty() || field->get_type() == telemetry_type::string)
+					continue;
+
+				QString title = QString::fromStdString(field->get_title());
+
+				if(m_loaded_documents.size() > 1)
+					title += " (" + document->document->get_name() + ")";
+
+				inputs.push_back({ field, document->alignment });
+				titles.push_back(title);
+			}
 		}
-		catch(...)
+
+		const size_t max_lag = size_t(maximum_lag / grid.interval);
+
+		return [this, inputs, titles, grid, max_lag](const std::atomic<bool> &cancelled) -> BackgroundJob::apply_function {
+
+			const size_t count = inputs.size();
+			const std::vector<std::vector<double>> columns = resample_aligned(inputs, grid, telemetry_resample_mode::hold);
+
+			std::vector<telemetry_correlation_series> series(count);
+
+			parallel_for(count, [&](size_t i) {
+
+				if(!cancelled && !columns[i].empty())
+					series[i] = telemetry_correlation_series(columns[i]);
+
+			});
+
+			// Only the upper triangle is computed, the lower one is the same with the lags reversed
+			std::vector<std::pair<size_t, size_t>> pairs;
+
+			for(size_t i = 0; i < count; ++ i)
+			{
+				for(size_t j = i; j < count; ++ j)
+					pairs.emplace_back(i, j);
+			}
+
+			std::vector<telemetry_correlation> correlations(count * count);
+
+			parallel_for(pairs.size(), [&](size_t i) {
+
+				const auto [ row, column ] = pairs[i];
+
+				if(cancelled || series[row].size() == 0 || series[column].size() == 0)
+					return;
+
+				telemetry_correlation correlation = correlate_telemetry_series(series[row], series[column], max_lag);
+				correlation.lags.clear();
+
+				correlations[column * count + row] = correlation;
+				correlations[column * count + row].peak_lag = -correlation.peak_lag;
+				correlations[row * count + column] = std::move(correlation);
+
+			});
+
+			if(cancelled)
+				return {};
+
+			return [this, titles, correlations = std::move(correlations), interval = grid.interval]() {
+
+				m_correlation_titles = titles;
+				m_correlations = correlations;
+				m_correlation_interval = interval;
+
+				update_correlation_table();
+
+			};
+
+		};
+
+	});
+}
+
+// Cells are shaded from blue for a perfect negative to red for a perfect positive correlation
+void DocumentWindow::update_correlation_table()
+{
+	const int count = int(m_correlation_titles.size());
+	const int metric = m_correlation_metric->currentIndex();
+
+	m_correlation_table->clear();
+	m_correlation_table->setRowCount(count);
+	m_correlation_table->setColumnCount(count);
+	m_correlation_table->setHorizontalHeaderLabels(m_correlation_titles);
+	m_correlation_table->setVerticalHeaderLabels(m_correlation_titles);
+
+	auto format = [](double value) {
+		return std::isnan(value) ? QString("-") : QString::number(value, 'f', 2);
+	};
+
+	for(int row = 0; row < count; ++ row)
+	{
+		for(int column = 0; column < count; ++ column)
 		{
-			return nullptr;
+			const telemetry_correlation &correlation = m_correlations[row * count + column];
+			const double lag = correlation.peak_lag * m_correlation_interval;
+
+			double value = correlation.pearson;
+			QString text;
+
+			switch(metric)
+			{
+				case 1:
+					value = correlation.spearman;
+					text = format(value);
+					break;
+				case 2:
+					value = correlation.peak_correlation;
+					text = std::isnan(value) ? format(value) : format(value) + QString(" @ %1 s").arg(lag, 0, 'f', 1);
+					break;
+				default:
+					text = format(value);
+					break;
+			}
+
+			QTableWidgetItem *item = new QTableWidgetItem(text);
+			item->setTextAlignment(Qt::AlignCenter);
+			item->setToolTip(QString("Pearson: %1\nSpearman: %2\nPeak: %3, %4 follows %5 by %6 s").arg(format(correlation.pearson)).arg(format(correlation.spearman))
+				.arg(format(correlation.peak_correlation)).arg(m_correlation_titles[column]).arg(m_correlation_titles[row]).arg(lag, 0, 'f', 2));
+
+			if(!std::isnan(value))
+			{
+				const int strength = int(std::abs(value) * 200.0);
+				item->setBackground(value >= 0.0 ? QColor(255, 255 - strength, 255 - strength) : QColor(255 - strength, 255 - strength, 255));
+				item->setForeground(QColor(Qt::black));
+			}
+
+			m_correlation_table->setItem(row, column, item);
 		}
+	}
+
+	m_correlation_table->resizeColumnsToContents();
+}
+
+void DocumentWindow::update_statistics_chart(const std::vector<statistics_entry> &entries, const std::vector<statistics_aggregate> &aggregates)
+{
+	QChart *chart = new QChart();
+
+	// Aggregated sets carry the confidence interval of every category, sets of a single run have no intervals
+	struct statistics_set
+	{
+		QBarSet *set;
+		std::vector<std::pair<double, double>> intervals;
 	};
 
-	QList<QBarSet *> fps_sets;
-	QList<QBarSet *> time_sets;
-	QList<QBarSet *> value_sets;
+	QList<statistics_set> fps_sets;
+	QList<statistics_set> time_sets;
+	QList<statistics_set> value_sets;
 
-	for(auto &document : m_loaded_documents)
+	auto add_set = [&](statistics_set set, telemetry_unit unit) {
+
+		switch(unit)
+		{
+			case telemetry_unit::time:
+				time_sets.append(set);
+				break;
+			case telemetry_unit::value:
+				value_sets.append(set);
+				break;
+			case telemetry_unit::fps:
+				fps_sets.append(set);
+				break;
+
+			default:
+				delete set.set;
+				break;
+		}
+
+	};
+
+	for(auto &entry : entries)
 	{
-		if(!document->enabled)
+		if(!entry.valid)
 			continue;
 
-		for(auto &lookup : m_enabled_fields)
-		{
-			const telemetry_field *field = lookup_field(lookup, document->document);
-			if(!field)
-				continue;
+		QBarSet *set = new QBarSet(entry.title);
+		set->setColor(entry.color);
 
-			const telemetry_unit unit = field->get_unit();
+		const double scale = (entry.unit == telemetry_unit::time) ? 1000.0 : 1.0;
 
-			if(unit != telemetry_unit::time && unit != telemetry_unit::fps && unit != telemetry_unit::value)
-				continue;
+		for(auto &percentile : statistics_percentiles)
+			set->append(entry.summary.*percentile.value * scale);
 
-			const auto &data = document->document->get_data();
-			if(!data.has_provider(field->get_provider_id()))
-				continue;
+		add_set({ set, {} }, entry.unit);
+	}
 
-			const auto &provider = data.get_provider(field->get_provider_id());
-			if(!provider.has_field(field->get_id()))
-				continue;
+	for(auto &aggregate : aggregates)
+	{
+		if(aggregate.statistics.run_count == 0)
+			continue;
 
-			const telemetry_field &additional_field = provider.get_field(field->get_id());
+		QBarSet *set = new QBarSet(QString("%1 (%2 runs)").arg(aggregate.title).arg(aggregate.statistics.run_count));
+		set->setColor(aggregate.color);
 
-			if(QBarSet *set = build_bar_set(additional_field, document))
-			{
-				switch(unit)
-				{
-					case telemetry_unit::time:
-						time_sets.append(set);
-						break;
-					case telemetry_unit::value:
-						value_sets.append(set);
-						break;
-					case telemetry_unit::fps:
-						fps_sets.append(set);
-						break;
-				}
-			}
+		const double scale = (aggregate.unit == telemetry_unit::time) ? 1000.0 : 1.0;
+		std::vector<std::pair<double, double>> intervals;
+
+		for(auto &percentile : statistics_percentiles)
+		{
+			const RunSpread &spread = aggregate.statistics.*percentile.spread;
+
+			set->append(spread.mean * scale);
+			intervals.emplace_back(spread.lower * scale, spread.upper * scale);
 		}
+
+		add_set({ set, std::move(intervals) }, aggregate.unit);
 	}
 
 	std::reverse(fps_sets.begin(), fps_sets.end());
 	std::reverse(time_sets.begin(), time_sets.end());
 	std::reverse(value_sets.begin(), value_sets.end());
 
-	auto build_bar_series = [&](const QList<QBarSet *> &sets, int precision, const QString &series_label, const QString &unit_label) {
+	const QPen error_pen(palette().color(QPalette::WindowText), 1.5);
+
+	auto build_bar_series = [&](const QList<statistics_set> &sets, int precision, const QString &series_label, const QString &unit_label) {
 
 		if(sets.isEmpty())
 			return;
 
 		QHorizontalBarSeries *series = new QHorizontalBarSeries();
-		series->append(sets);
+
+		for(auto &set : sets)
+			series->append(set.set);
+
 		series->setLabelsVisible(true);
 		series->setLabelsPosition(QAbstractBarSeries::LabelsInsideEnd);
 		series->setLabelsPrecision(precision);
@@ -916,8 +1647,8 @@ void DocumentWindow::update_statistics_view()
 
 		auto y_axis = new QBarCategoryAxis();
 
-		for(auto &perf_set : perf_series)
-			y_axis->append(perf_set.name);
+		for(auto &percentile : statistics_percentiles)
+			y_axis->append(percentile.name);
 
 		chart->addAxis(y_axis, Qt::AlignLeft);
 		series->attachAxis(y_axis);
@@ -926,8 +1657,39 @@ void DocumentWindow::update_statistics_view()
 		x_axis->setLabelFormat(unit_label);
 
 		chart->addAxis(x_axis, Qt::AlignBottom);
-
 		series->attachAxis(x_axis);
+
+		// Error bars are drawn as line series on top of the bars. The category axis places category i at i, and the bar series splits
+		// its bar width evenly between the sets starting from the bottom
+		const double set_height = series->barWidth() / double(sets.size());
+
+		for(qsizetype i = 0; i < sets.size(); ++ i)
+		{
+			for(size_t j = 0; j < sets[i].intervals.size(); ++ j)
+			{
+				const auto [ lower, upper ] = sets[i].intervals[j];
+
+				const double center = double(j) - series->barWidth() * 0.5 + (double(i) + 0.5) * set_height;
+				const double cap = set_height * 0.25;
+
+				QLineSeries *error_bar = new QLineSeries();
+				error_bar->setPen(error_pen);
+				error_bar->append(lower, center - cap);
+				error_bar->append(lower, center + cap);
+				error_bar->append(lower, center);
+				error_bar->append(upper, center);
+				error_bar->append(upper, center + cap);
+				error_bar->append(upper, center - cap);
+
+				chart->addSeries(error_bar);
+				error_bar->attachAxis(x_axis);
+				error_bar->attachAxis(y_axis);
+
+				for(auto marker : chart->legend()->markers(error_bar))
+					marker->setVisible(false);
+			}
+		}
+
 		x_axis->applyNiceNumbers();
 
 	};
@@ -1052,10 +1814,456 @@ void DocumentWindow::close_file(loaded_document *document)
 
 	m_loaded_documents.erase(iterator);
 
+	m_statistics_job.cancel();
+	m_correlation_job.cancel();
+	evict_summaries(document->document);
+
+	const bool detecting_hitches = m_hitch_job.cancel();
+
 	delete document->document;
 	delete document;
 
+	// Documents are referred to by their position, which just changed for the ones after this one
+	reload_linked_derived_fields(nullptr);
+
 	update_statistics_view();
+	update_hitch_views();
+
+	if(detecting_hitches)
+		detect_hitches();
+}
+
+void DocumentWindow::load_region(loaded_document *document, const TelemetryRegion &region)
+{
+	reload_document(document, [&]() {
+
+		try
+		{
+			document->document->load_region(region);
+			statusBar()->showMessage("Loaded " + region.name + " of " + document->document->get_name());
+		}
+		catch(std::exception &e)
+		{
+			statusBar()->showMessage("Failed to load region. Error: " + QString(e.what()));
+		}
+
+	});
+
+	reload_linked_derived_fields(document);
+}
+
+void DocumentWindow::reload_document(loaded_document *document, const std::function<void ()> &reload)
+{
+	m_chart_view->begin_update();
+
+	// The chart references the fields of the document directly, which are about to be replaced
+	for(auto &lookup : m_enabled_fields)
+	{
+		const telemetry_field *field = lookup_field(lookup, document->document);
+		if(field)
+			m_chart_view->remove_data(field);
+	}
+
+	m_statistics_job.cancel();
+	m_correlation_job.cancel();
+	evict_summaries(document->document);
+
+	reload();
+
+	// Derived fields are unloaded by reparsing, the others are kept
+	load_fields(document, m_enabled_fields);
+
+	for(auto &lookup : m_enabled_fields)
+	{
+		const telemetry_field *field = lookup_field(lookup, document->document);
+		if(!field || field->empty())
+			continue;
+
+		m_chart_view->add_data(field, get_color_for_telemetry_field(field, document), document->alignment);
+
+		if(!document->enabled)
+			m_chart_view->hide_data(field);
+	}
+
+	m_chart_view->end_update();
+
+	update_statistics_view();
+}
+
+void DocumentWindow::reload_linked_derived_fields(const loaded_document *reloaded)
+{
+	// Reparsing only unloads the derived fields of the document itself, but the ones of other documents may have sampled its old fields
+	const bool is_linked = std::any_of(m_derived_fields.begin(), m_derived_fields.end(), [](const auto &derived) {
+
+		auto &references = derived.expression.get_references();
+
+		return std::any_of(references.begin(), references.end(), [](const telemetry_expression_reference &reference) {
+			return reference.document > 0;
+		});
+
+	});
+
+	if(!is_linked)
+		return;
+
+	for(auto &document : m_loaded_documents)
+	{
+		if(document == reloaded)
+			continue;
+
+		reload_document(document, [&]() {
+			document->document->unload_derived_fields();
+		});
+	}
+}
+
+std::optional<TimelineAlignment> DocumentWindow::align_regions(const TelemetryDocument *root, const TelemetryDocument *document, bool piecewise)
+{
+	auto &root_regions = root->get_regions();
+	auto &regions = document->get_regions();
+
+	if(root_regions.size() != regions.size())
+		return std::nullopt;
+
+	TimelineAlignment alignment;
+	std::optional<TimelineAlignment> flying;
+
+	for(qsizetype i = 0; i < regions.size(); ++ i)
+	{
+		if(root_regions[i].type != regions[i].type || root_regions[i].name != regions[i].name)
+			return std::nullopt;
+
+		if(regions[i].type == TelemetryRegion::Type::Everything)
+			continue;
+
+		if(piecewise)
+			alignment.add_segment(root_regions[i].start, regions[i].start - root_regions[i].start);
+		else if(regions[i].type == TelemetryRegion::Type::Flying && !flying)
+			flying = TimelineAlignment(regions[i].start - root_regions[i].start);
+	}
+
+	if(!piecewise)
+		return flying.value_or(TimelineAlignment());
+
+	return alignment;
+}
+
+TimelineAlignment DocumentWindow::align_document(const TelemetryDocument *document)
+{
+	const TelemetryDocument *root = m_loaded_documents.front()->document;
+	const bool piecewise = m_action_align_regions->isChecked();
+
+	// Matching every region on its own is an explicit choice, so it wins whenever the regions allow it
+	const std::optional<TimelineAlignment> regions = align_regions(root, document, piecewise);
+
+	if(piecewise && regions)
+		return *regions;
+
+	try
+	{
+		if(!m_alignment_reference)
+			m_alignment_reference = std::make_shared<const telemetry_container>(root->load_alignment_signals());
+
+		const RunAlignment alignment = align_runs(*m_alignment_reference, document->load_alignment_signals());
+
+		if(alignment.valid)
+		{
+			statusBar()->showMessage(QString("Aligned %1 by cross-correlation, offset %2 s (correlation %3)").arg(document->get_name()).arg(alignment.offset.to_seconds(), 0, 'f', 3).arg(alignment.correlation, 0, 'f', 2));
+			return TimelineAlignment(alignment.offset);
+		}
+	}
+	catch(std::exception &e)
+	{
+		statusBar()->showMessage("Failed to cross-correlate " + document->get_name() + ". Error: " + QString(e.what()));
+	}
+
+	if(regions)
+		return *regions;
+
+	statusBar()->showMessage("Couldn't align " + document->get_name() + " with " + root->get_name() + ", showing it on its own timeline");
+	return TimelineAlignment();
+}
+
+void DocumentWindow::realign_documents()
+{
+	std::vector<TimelineAlignment> alignments;
+	alignments.reserve(m_loaded_documents.size());
+
+	for(auto &document : m_loaded_documents)
+	{
+		if(document == m_loaded_documents.front())
+			alignments.push_back(document->alignment);
+		else
+			alignments.push_back(align_document(document->document));
+	}
+
+	bool changed = false;
+
+	for(qsizetype i = 0; i < m_loaded_documents.size(); ++ i)
+		changed |= !(alignments[i] == m_loaded_documents[i]->alignment);
+
+	if(!changed)
+		return;
+
+	for(qsizetype i = 0; i < m_loaded_documents.size(); ++ i)
+		m_loaded_documents[i]->alignment = alignments[i];
+
+	// Derived fields may line up fields of several documents, so all of them are evaluated again
+	for(auto &document : m_loaded_documents)
+	{
+		reload_document(document, [&]() {
+			document->document->unload_derived_fields();
+		});
+	}
+
+	update_hitch_views();
+}
+
+void DocumentWindow::evict_summaries(TelemetryDocument *document)
+{
+	for(auto &provider : document->get_data().get_providers())
+	{
+		for(auto &field : provider.get_fields())
+			m_summary_cache.evict(&field);
+	}
+}
+
+void DocumentWindow::detect_hitches()
+{
+	m_hitch_job.schedule([this]() -> BackgroundJob::compute_function {
+
+		std::vector<std::pair<loaded_document *, const TelemetryDocument *>> inputs;
+
+		for(auto &document : m_loaded_documents)
+		{
+			if(!document->hitches)
+				inputs.emplace_back(document, document->document);
+		}
+
+		statusBar()->showMessage("Looking for stutters");
+
+		return [this, inputs, settings = m_hitch_settings](const std::atomic<bool> &cancelled) -> BackgroundJob::apply_function {
+
+			std::vector<std::vector<HitchEpisode>> results(inputs.size());
+
+			parallel_for(inputs.size(), [&](size_t i) {
+
+				if(cancelled)
+					return;
+
+				try
+				{
+					results[i] = inputs[i].second->detect_hitches(settings);
+				}
+				catch(...)
+				{}
+
+			});
+
+			if(cancelled)
+				return {};
+
+			return [this, inputs, results = std::move(results)]() {
+
+				size_t count = 0;
+
+				// Closing a document cancels the job, so the entries are all still alive
+				for(size_t i = 0; i < inputs.size(); ++ i)
+				{
+					inputs[i].first->hitches = results[i];
+					count += std::count_if(results[i].begin(), results[i].end(), [](const HitchEpisode &episode) { return episode.source == HitchEpisode::Source::Frame; });
+				}
+
+				statusBar()->showMessage(QString("Found %1 stutters").arg(count));
+				update_hitch_views();
+
+			};
+
+		};
+
+	});
+}
+
+void DocumentWindow::update_hitch_views()
+{
+	QVector<ChartWidget::Marker> markers;
+
+	struct picker_entry
+	{
+		double start;
+		double end;
+		QString title;
+		QString tooltip;
+	};
+
+	std::vector<picker_entry> entries;
+	bool detecting = false;
+
+	for(auto &document : m_loaded_documents)
+	{
+		detecting |= !document->hitches.has_value();
+
+		if(!document->enabled || !document->hitches)
+			continue;
+
+		for(auto &episode : *document->hitches)
+		{
+			if(episode.source != HitchEpisode::Source::Frame)
+				continue;
+
+			// Markers live on the timeline of the first document, just like the fields
+			const double start = document->alignment.to_shared(episode.start).to_seconds();
+			const double end = document->alignment.to_shared(episode.end).to_seconds();
+
+			markers.push_back({ start, end, QColor(220, 50, 50) });
+
+			QString title = TimePickerWidget::format_time(int32_t(start)) + QString(" %1 ms").arg(episode.worst_frame * 1000.0, 0, 'f', 1);
+
+			if(episode.frame_count > 1)
+				title += QString(" (%1 frames)").arg(episode.frame_count);
+			if(m_loaded_documents.size() > 1)
+				title += " - " + document->document->get_name();
+
+			const QString tooltip = QString("%1 ms stalled over %2 s").arg(episode.stall_time * 1000.0, 0, 'f', 1).arg((episode.end - episode.start).to_seconds(), 0, 'f', 2);
+
+			entries.push_back({ start, end, title, tooltip });
+		}
+	}
+
+	std::stable_sort(entries.begin(), entries.end(), [](const picker_entry &lhs, const picker_entry &rhs) {
+		return lhs.start < rhs.start;
+	});
+
+	m_chart_view->set_markers(markers);
+
+	{
+		QSignalBlocker blocker(m_hitch_picker);
+		m_hitch_picker->clear();
+
+		if(detecting)
+			m_hitch_picker->addItem("Detecting...");
+		else
+			m_hitch_picker->addItem(entries.empty() ? QString("No stutters") : QString("%1 stutters").arg(entries.size()));
+
+		for(auto &entry : entries)
+		{
+			m_hitch_picker->addItem(entry.title, QPointF(entry.start, entry.end));
+			m_hitch_picker->setItemData(m_hitch_picker->count() - 1, entry.tooltip, Qt::ToolTipRole);
+		}
+
+		m_hitch_picker->setEnabled(!entries.empty());
+	}
+
+	// The region picker shows the stutters of the first document, the others share its regions
+	if(m_loaded_documents.isEmpty())
+		return;
+
+	const loaded_document *root = m_loaded_documents.front();
+	const auto &regions = root->document->get_regions();
+
+	for(int i = 0; i < regions.size() && i < m_event_picker->count(); ++ i)
+	{
+		QString title = get_region_title(regions[i]);
+		QString tooltip;
+
+		if(root->hitches)
+		{
+			const HitchReport frame_report = summarize_hitches(*root->hitches, HitchEpisode::Source::Frame, regions[i].start, regions[i].end);
+			title += QString(" - %1 stutters").arg(frame_report.episode_count);
+
+			for(auto source : { HitchEpisode::Source::Frame, HitchEpisode::Source::Cpu, HitchEpisode::Source::Gpu })
+			{
+				const HitchReport report = summarize_hitches(*root->hitches, source, regions[i].start, regions[i].end);
+
+				if(!tooltip.isEmpty())
+					tooltip += "\n";
+
+				tooltip += QString("%1: %2 stutters, %3 slow frames, worst %4 ms, %5 s stalled").arg(get_hitch_source_name(source)).arg(report.episode_count).arg(report.frame_count)
+					.arg(report.worst_frame * 1000.0, 0, 'f', 1).arg(report.stall_time, 0, 'f', 2);
+			}
+		}
+
+		m_event_picker->setItemText(i, title);
+		m_event_picker->setItemData(i, tooltip, Qt::ToolTipRole);
+	}
+}
+
+void DocumentWindow::show_hitch(int index)
+{
+	const QVariant data = m_hitch_picker->itemData(index);
+
+	if(!data.isValid())
+		return;
+
+	// A couple of seconds around the episode, so that the frames before and after it are visible too
+	const QPointF span = data.toPointF();
+
+	m_start_edit->set_value(int32_t(std::floor(span.x())) - 2);
+	m_end_edit->set_value(int32_t(std::ceil(span.y())) + 2);
+}
+
+QString DocumentWindow::get_region_title(const TelemetryRegion &region) const
+{
+	return region.name + QString(" (") + TimePickerWidget::format_time(int32_t(region.start.to_seconds())) + " - " + TimePickerWidget::format_time(int32_t(region.end.to_seconds())) + QString(")");
+}
+
+bool DocumentWindow::needs_full_resolution(ChartWidget::Renderer renderer, ChartWidget::Type type)
+{
+	return renderer == ChartWidget::Renderer::Raster || type == ChartWidget::Type::Spectrum;
+}
+
+void DocumentWindow::set_chart_mode(ChartWidget::Renderer renderer, ChartWidget::Type type)
+{
+	const bool full_resolution = needs_full_resolution(renderer, type);
+
+	// Switch to full resolution views before and away from them after reloading, so that the line series are never built from full resolution fields.
+	// For the same reason the raster renderer is switched to before the type, and the spectrum before the renderer
+	if(full_resolution)
+	{
+		if(renderer == ChartWidget::Renderer::Raster)
+		{
+			m_chart_view->set_renderer(renderer);
+			m_chart_view->set_type(type);
+		}
+		else
+		{
+			m_chart_view->set_type(type);
+			m_chart_view->set_renderer(renderer);
+		}
+	}
+
+	bool reloaded = false;
+
+	for(auto &document : m_loaded_documents)
+	{
+		if(document->document->is_full_resolution() == full_resolution)
+			continue;
+
+		reloaded = true;
+
+		reload_document(document, [&]() {
+
+			try
+			{
+				document->document->set_full_resolution(full_resolution);
+			}
+			catch(std::exception &e)
+			{
+				statusBar()->showMessage("Failed to reload " + document->document->get_name() + ". Error: " + QString(e.what()));
+			}
+
+		});
+	}
+
+	// Documents are reloaded one after another, so derived fields that line up several of them may have sampled a document before it was reloaded
+	if(reloaded)
+		reload_linked_derived_fields(nullptr);
+
+	if(!full_resolution)
+	{
+		m_chart_view->set_renderer(renderer);
+		m_chart_view->set_type(type);
+	}
 }
 
 void DocumentWindow::run_fps_test()
@@ -1121,7 +2329,7 @@ void DocumentWindow::run_fps_test()
 
 void DocumentWindow::range_changed()
 {
-	set_time_range(m_start_edit->get_value(), m_end_edit->get_value());
+	set_time_range(telemetry_time::from_seconds(m_start_edit->get_value()), telemetry_time::from_seconds(m_end_edit->get_value()));
 }
 void DocumentWindow::event_range_changed(int index)
 {
@@ -1132,6 +2340,6 @@ void DocumentWindow::event_range_changed(int index)
 
 	set_time_range(regions[index].start, regions[index].end);
 
-	m_start_edit->set_value(regions[index].start);
-	m_end_edit->set_value(regions[index].end);
+	m_start_edit->set_value(int32_t(regions[index].start.to_seconds()));
+	m_end_edit->set_value(int32_t(regions[index].end.to_seconds()));
 }
@@ -5,9 +5,17 @@
 #ifndef SPIRV_STUDIO_DOCUMENT_WINDOW_H
 #define SPIRV_STUDIO_DOCUMENT_WINDOW_H
 
+#include <array>
+#include <functional>
 #include <ui_DocumentWindow.h>
 #include <model/TelemetryDocument.h>
 #include <model/XplaneInstallation.h>
+#include <telemetry/correlation.h>
+#include <telemetry/expression.h>
+#include <utilities/BackgroundJob.h>
+#include <utilities/RunStatistics.h>
+#include <utilities/SummaryCache.h>
+#include <utilities/TimelineAlignment.h>
 
 class TestRunnerDialog;
 
@@ -44,6 +52,8 @@ private Q_SLOTS:
 	[[maybe_unused]] void close_all_files();
 
 	[[maybe_unused]] void run_fps_test();
+	[[maybe_unused]] void add_derived_field();
+	[[maybe_unused]] void realign_documents();
 
 	[[maybe_unused]] void range_changed();
 	[[maybe_unused]] void event_range_changed(int index);
@@ -61,9 +71,11 @@ private:
 	struct loaded_document
 	{
 		TelemetryDocument *document;
-		double start_offset;
+		TimelineAlignment alignment; // Onto the timeline of the first document
 		bool enabled = true;
 		QString seed;
+
+		std::optional<std::vector<HitchEpisode>> hitches; // Empty until the detection finished, see detect_hitches()
 	};
 
 	struct telemetry_field_lookup
@@ -74,20 +86,92 @@ private:
 		auto operator<=>(const telemetry_field_lookup &) const = default;
 	};
 
+	// A field computed from others, shared by all documents. The index in m_derived_fields is its field id in the derived provider
+	struct derived_field_definition
+	{
+		QString title;
+		telemetry_expression expression;
+		telemetry_unit unit;
+	};
+
+	struct statistics_entry
+	{
+		const telemetry_field *field;
+		telemetry_field_lookup lookup;
+
+		QString title;
+		QColor color;
+		telemetry_unit unit;
+
+		telemetry_time start;
+		telemetry_time end;
+
+		FieldSummary summary;
+		bool valid = false;
+	};
+
+	// A field combined over all enabled documents, each of them counting as one run of the same test
+	struct statistics_aggregate
+	{
+		telemetry_field_lookup lookup;
+
+		QString title;
+		QColor color;
+		telemetry_unit unit;
+
+		RunStatistics statistics;
+	};
+
 	void clear();
 
 	void save_file(loaded_document *document, bool save_as);
 	void close_file(loaded_document *document);
+	void load_region(loaded_document *document, const TelemetryRegion &region);
+	void reload_document(loaded_document *document, const std::function<void ()> &reload);
+	void reload_linked_derived_fields(const loaded_document *reloaded); // Evaluates the derived fields of every document but the reloaded one again, if any of them refers to another document
+
+	// Lines up the regions of the document with the ones of the root document. Only the first flying region is matched unless piecewise is set,
+	// in which case every region is shifted on its own. Returns nothing if the region lists differ
+	static std::optional<TimelineAlignment> align_regions(const TelemetryDocument *root, const TelemetryDocument *document, bool piecewise);
+
+	// Aligns the document with the first one by cross-correlating their frame rate and sim state, falls back to the regions and then to no
+	// alignment at all. Reports what it did in the status bar
+	TimelineAlignment align_document(const TelemetryDocument *document);
+
+	// The raster renderer and the spectrum need every sample, the other views work on decimated fields
+	static bool needs_full_resolution(ChartWidget::Renderer renderer, ChartWidget::Type type);
+	void set_chart_mode(ChartWidget::Renderer renderer, ChartWidget::Type type);
 
-	void set_field_enabled(const telemetry_field_lookup &lookup, bool enable);
+	void set_fields_enabled(const QVector<telemetry_field_lookup> &lookups, bool enable); // Loads, adds and schedules the statistics for all of them at once
 	const telemetry_field *lookup_field(const telemetry_field_lookup &lookup, TelemetryDocument *document) const;
+	std::optional<telemetry_field_lookup> find_field(const std::string &name, TelemetryDocument *document, size_t derived_limit) const; // By normalized title
+	QTreeWidgetItem *create_field_item(QTreeWidgetItem *provider_item, const telemetry_provider &provider, const telemetry_field &field, const loaded_document *document) const;
+
+	// Loads fields on demand, derived fields are evaluated from the fields they reference. Returns false if the field can't be loaded
+	bool load_field(loaded_document *document, const telemetry_field_lookup &lookup);
+	void load_fields(loaded_document *document, const QVector<telemetry_field_lookup> &lookups); // Parses the file once for all of them
+	void evaluate_derived_field(loaded_document *document, uint8_t field_id);
+	void create_derived_field(const QString &title, const QString &source); // Will throw std::exception for invalid expressions
+	void add_difference_fields(const loaded_document *document); // This document minus the first one for every enabled field
 
 	QColor get_color_for_telemetry_field(const telemetry_field *field, const loaded_document *document) const;
 
-	void set_time_range(int32_t start, int32_t end);
+	void set_time_range(telemetry_time start, telemetry_time end);
 
 	void update_selected_document(const loaded_document *document);
 	void update_statistics_view();
+	void update_statistics_chart(const std::vector<statistics_entry> &entries, const std::vector<statistics_aggregate> &aggregates);
+
+	void update_correlation_view();
+	void update_correlation_table();
+
+	void evict_summaries(TelemetryDocument *document);
+
+	void detect_hitches(); // Runs the stutter detection for all documents that don't have results yet
+	void update_hitch_views();
+	void show_hitch(int index);
+
+	QString get_region_title(const TelemetryRegion &region) const;
 
 	QAction *add_toolbar_widget(QWidget *widget, const QString &text) const;
 	QAction *add_toolbar_spacer() const;
@@ -97,8 +181,26 @@ private:
 	QVector<loaded_document *> m_loaded_documents;
 	QVector<telemetry_field_lookup> m_enabled_fields;
 
+	std::shared_ptr<const telemetry_container> m_alignment_reference; // Signals of the first document, see align_document()
+
+	std::vector<derived_field_definition> m_derived_fields;
+	QTreeWidgetItem *m_derived_provider_item = nullptr;
+
 	std::vector<std::unique_ptr<QAction>> m_recent_file_actions;
 
+	SummaryCache m_summary_cache; // Shared with the chart view
+	BackgroundJob m_statistics_job;
+
+	// Correlation of every pair of enabled fields, row major. Lags are in grid points of m_correlation_interval seconds
+	QStringList m_correlation_titles;
+	std::vector<telemetry_correlation> m_correlations;
+	double m_correlation_interval = 0.0;
+	BackgroundJob m_correlation_job;
+
+	HitchSettings m_hitch_settings;
+	BackgroundJob m_hitch_job;
+	QComboBox *m_hitch_picker;
+
 	QComboBox *m_installation_selector;
 	QVector<XplaneInstallation> m_installations;
 };
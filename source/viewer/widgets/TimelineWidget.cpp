@@ -54,6 +54,7 @@ TimelineSpanItem::TimelineSpanItem(const QPalette& p, const telemetry_event& spa
 	if (child_count > 0)
 		f.setBold(true);
 	label_item->setFont(f);
+	label_item->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
 
 	auto label = QString("(%1 ms) %2 %3").arg(span.get_duration() * 1000).arg(path).arg(child_count);
 	this->setToolTip(label);
@@ -137,6 +138,9 @@ TimelineWidget::TimelineWidget(QWidget *parent)
 {
 	setTransformationAnchor(AnchorUnderMouse);
 
+	// Scrolling only exposes a strip of the view, the rest of the background is moved instead of being drawn again
+	setCacheMode(QGraphicsView::CacheBackground);
+
 	connect(horizontalScrollBar(), &QScrollBar::valueChanged, this, &TimelineWidget::viewportChange);
 	connect(horizontalScrollBar(), &QScrollBar::rangeChanged, this, &TimelineWidget::viewportChange);
 	connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &TimelineWidget::viewportChange);